@@ -130,6 +130,16 @@ enum TMerge {
 	ARTNET_MERGE_LTP		///< Latest Takes Precedence (LTP)
 };
 
+/**
+ * The protocols from which an output port takes its DMX data, as selected by the ArtAddress packet.
+ * With both selected, the Art-Net and sACN sources of the port are merged.
+ */
+enum TPortProtocol {
+	PORT_PROTOCOL_ARTNET = (1 << 0),	///< Output DMX from Art-Net (default)
+	PORT_PROTOCOL_SACN = (1 << 1),		///< Output DMX from sACN
+	PORT_PROTOCOL_BOTH = PORT_PROTOCOL_ARTNET | PORT_PROTOCOL_SACN	///< Merge the Art-Net and sACN sources
+};
+
 /**
  * Node configuration commands
  */
@@ -148,6 +158,14 @@ enum TArtnetPortCommand {
 	ARTNET_PC_MERGE_HTP_1 = 0x51,	///< Set DMX Port 1 to Merge in HTP (default) mode.
 	ARTNET_PC_MERGE_HTP_2 = 0x52,	///< Set DMX Port 2 to Merge in HTP (default) mode.
 	ARTNET_PC_MERGE_HTP_3 = 0x53,	///< Set DMX Port 3 to Merge in HTP (default) mode.
+	ARTNET_PC_ARTNET_SEL_0 = 0x60,	///< Set DMX Port 0 to output DMX from Art-Net protocol.
+	ARTNET_PC_ARTNET_SEL_1 = 0x61,	///< Set DMX Port 1 to output DMX from Art-Net protocol.
+	ARTNET_PC_ARTNET_SEL_2 = 0x62,	///< Set DMX Port 2 to output DMX from Art-Net protocol.
+	ARTNET_PC_ARTNET_SEL_3 = 0x63,	///< Set DMX Port 3 to output DMX from Art-Net protocol.
+	ARTNET_PC_ACN_SEL_0 = 0x70,		///< Set DMX Port 0 to output DMX from sACN protocol.
+	ARTNET_PC_ACN_SEL_1 = 0x71,		///< Set DMX Port 1 to output DMX from sACN protocol.
+	ARTNET_PC_ACN_SEL_2 = 0x72,		///< Set DMX Port 2 to output DMX from sACN protocol.
+	ARTNET_PC_ACN_SEL_3 = 0x73,		///< Set DMX Port 3 to output DMX from sACN protocol.
 	ARTNET_PC_CLR_0 = 0x90,			///< Clear DMX Output buffer for Port 0
 	ARTNET_PC_CLR_1 = 0x91,			///< Clear DMX Output buffer for Port 1
 	ARTNET_PC_CLR_2 = 0x92,			///< Clear DMX Output buffer for Port 2
@@ -51,8 +51,13 @@
 #include "packets.h"
 #include "common.h"
 
+#include "e131validate.h"
+
 #include "lightset.h"
+#include "lightset_merge.h"
+#include "lightsetinput.h"
 #include "artnettimecode.h"
+#include "lightsetrdm.h"
 
 #include "blinktask.h"
 
@@ -100,7 +105,20 @@ enum TGoodOutput {
 	GO_INCLUDES_DMX_TEXT_PACKETS = (1 << 4),	///< Bit 4 Channel includes DMX512 text packets.
 	GO_OUTPUT_IS_MERGING = (1 << 3),			///< Bit 3 Set – Output is merging ArtNet data.
 	GO_DMX_SHORT_DETECTED = (1 << 2),			///< Bit 2 Set – DMX output short detected on power up
-	GO_MERGE_MODE_LTP = (1 << 1)				///< Bit 1 Set – Merge Mode is LTP.
+	GO_MERGE_MODE_LTP = (1 << 1),				///< Bit 1 Set – Merge Mode is LTP.
+	GO_OUTPUT_IS_SACN = (1 << 0)				///< Bit 0 Set – Output is selected to transmit sACN.
+};
+
+/**
+ * Defines input status of the node.
+ */
+enum TGoodInput {
+	GI_DATA_RECIEVED = (1 << 7),				///< Bit 7 Set – Data received.
+	GI_INCLUDES_DMX_TEST_PACKETS = (1 << 6),	///< Bit 6 Set – Channel includes DMX512 test packets.
+	GI_INCLUDES_DMX_SIP = (1 << 5),				///< Bit 5 Set – Channel includes DMX512 SIP’s.
+	GI_INCLUDES_DMX_TEXT_PACKETS = (1 << 4),	///< Bit 4 Set – Channel includes DMX512 text packets.
+	GI_DISABLED = (1 << 3),						///< Bit 3 Set – Input is disabled.
+	GI_ERRORS = (1 << 2)						///< Bit 2 Set – Receive errors detected.
 };
 
 /**
@@ -140,6 +158,8 @@ struct TArtNetNodeState {
 	bool IsMergeMode;							///< Is the Node in merging mode?
 	bool IsChanged;								///< Is the DMX changed? Update output DMX
 	uint8_t nActivePorts;						///< Number of active ports
+	uint8_t nActiveInputPorts;					///< Number of active input ports
+	bool IsPollReplyPortsChanged;				///< The port fields of the ArtPollReply must be built again
 };
 
 /**
@@ -170,21 +190,94 @@ struct TGenericPort {
 	uint8_t nStatus;			///<
 };
 
+/**
+ * Number of bins of the latency histogram \ref TArtNetLatency
+ */
+#define ARTNET_LATENCY_BINS		24
+
+/**
+ * Latency from the arrival of an ArtDmx to the hand over of its data to the LightSet.
+ * Bin 0 counts the latencies of 0 microseconds, bin n the latencies from 2^(n-1) up to 2^n - 1 microseconds.
+ * The last bin counts all the latencies from 2^(ARTNET_LATENCY_BINS - 2) microseconds.
+ */
+struct TArtNetLatency {
+	uint32_t nCount;						///< Number of outputs measured
+	uint32_t nMin;							///< Minimum latency in microseconds
+	uint32_t nMax;							///< Maximum latency in microseconds
+	uint32_t nBins[ARTNET_LATENCY_BINS];	///< The histogram
+};
+
+/**
+ * struct to represent a source sending ArtDmx to an output port
+ */
+struct TMergeSource {
+	uint32_t nIp;						///< The IP address of the source, 0 when the entry is not used
+	time_t nTime;						///< The latest time of the data received from the source
+	uint8_t nBuffer;					///< The merge buffer with the data of the source, \ref ARTNET_MERGE_BUFFER_NONE when not merging
+	uint8_t nSequence;					///< The sequence number of the latest sACN data packet of the source
+	uint8_t Cid[E131_CID_LENGTH];		///< The CID of a sACN source, all 0 for an Art-Net source
+};
+
 /**
  * struct to represent an output port
  *
  */
 struct TOutputPort {
-	uint8_t data[ARTNET_DMX_LENGTH];	///< Data sent
+	uint8_t *pData;						///< Data sent. Points into pPacket, or to data when merging
 	uint16_t nLength;					///< Length of sent DMX data
-	uint8_t dataA[ARTNET_DMX_LENGTH];	///< The data received from Port A
-	time_t timeA;						///< The latest time of the data received from Port A
-	uint32_t ipA;						///< The IP address for port A
-	uint8_t dataB[ARTNET_DMX_LENGTH];	///< The data received from Port B
-	time_t timeB;						///< The latest time of the data received from Port B
-	uint32_t ipB;						///< The IP address for Port B
+	struct TArtNetPacket *pPacket;		///< The latest ArtDmx received for this port, taken from the receive buffer pool
+	uint8_t data[ARTNET_DMX_LENGTH];	///< The merged data
+	struct TMergeSource sources[ARTNET_NODE_MAX_SOURCES];	///< The sources sending to this port
+	uint8_t nSources;					///< The number of active sources
 	TMerge mergeMode;					///< \ref TMerge
+	TPortProtocol protocol;				///< \ref TPortProtocol
 	bool IsDataPending;					///< ArtDMX received and waiting for ArtSync
+	uint32_t nPendingMicros;			///< Arrival time of the oldest ArtDmx waiting for ArtSync
+	uint32_t nArrivalMicros;			///< Arrival time of the latest ArtDmx for the data sent
+	uint32_t nOutputMicros;				///< Time of the latest hand over to the LightSet
+	struct _lightset_merge_result changed;	///< The slots changed since the data was last handed to the LightSet
+	bool bIsEnabled;					///< Is the port enabled ?
+	TGenericPort port;					///< \ref TGenericPort
+};
+
+/**
+ * The fields of an ArtPollReply page which depend on the ports
+ */
+struct TPollReplyPorts {
+	uint8_t NumPortsLo;						///< \ref TArtPollReply
+	uint8_t SubSwitch;						///<
+	uint8_t PortTypes[ARTNET_MAX_PORTS];	///< PortTypes up to and including SwOut, in the order of \ref TArtPollReply
+	uint8_t GoodInput[ARTNET_MAX_PORTS];	///<
+	uint8_t GoodOutput[ARTNET_MAX_PORTS];	///<
+	uint8_t SwIn[ARTNET_MAX_PORTS];			///<
+	uint8_t SwOut[ARTNET_MAX_PORTS];		///<
+};
+
+/**
+ * struct to represent a controller sending ArtPoll
+ */
+struct TPollSource {
+	uint32_t nIp;						///< The IP address of the controller, 0 when the entry is not used
+	uint32_t nMicros;					///< The latest ArtPoll answered
+};
+
+/**
+ * struct to represent a node receiving the ArtDmx of an input port
+ */
+struct TSubscriber {
+	uint32_t nIp;						///< The IP address of the node, 0 when the entry is not used
+	time_t nTime;						///< The latest ArtPollReply with an output port for the Port-Address
+};
+
+/**
+ * struct to represent an input port
+ */
+struct TInputPort {
+	uint8_t nSequence;					///< Sequence of the latest ArtDmx sent
+	uint32_t nMicros;					///< Time of the latest ArtDmx sent
+	struct TSubscriber subscribers[ARTNET_NODE_MAX_SUBSCRIBERS];	///< The nodes with an output port for the Port-Address of this input port
+	bool bIsSubscribersFull;			///< More subscribers than fit in the table, so broadcast
+	time_t nSubscribersFullTime;		///< The latest ArtPollReply which did not fit in the table
 	bool bIsEnabled;					///< Is the port enabled ?
 	TGenericPort port;					///< \ref TGenericPort
 };
@@ -199,8 +292,10 @@ public:
 	~ArtNetNode(void);
 
 	void SetOutput(LightSet *);
+	void SetInput(LightSetInput *);
 
 	void SetTimeCodeHandler(ArtNetTimeCode *);
+	void SetRdmHandler(LightSetRdm *);
 
 	const uint8_t *GetSoftwareVersion(void);
 
@@ -210,6 +305,22 @@ public:
 	void SetDirectUpdate(bool);
 	const bool GetDirectUpdate(void);
 
+	void SetSyncDeadline(const uint32_t);
+	const uint32_t GetSyncDeadline(void);
+
+	void SetInputKeepAlive(const uint32_t);
+	const uint32_t GetInputKeepAlive(void);
+	void SetInputBroadcast(const bool);
+
+	void SetPollReplyInterval(const uint32_t);
+	const uint32_t GetPollReplyInterval(void);
+	void SetPollReplyDelay(const uint32_t);
+	const uint32_t GetPollReplyDelay(void);
+
+	const struct TArtNetLatency *GetLatency(void);
+	void ResetLatency(void);
+	const uint32_t GetOutputTime(const uint8_t);
+
 	const char *GetShortName(void);
 	void SetShortName(const char *);
 	const char *GetLongName(void);
@@ -217,10 +328,13 @@ public:
 	const uint8_t GetUniverseSwitch(uint8_t);
 	int SetUniverseSwitch(const uint8_t, const TArtNetPortDir, const uint8_t);
 	const uint8_t GetSubnetSwitch(void);
-	void SetSubnetSwitch(const uint8_t);
+	int SetSubnetSwitch(const uint8_t);
 	const uint8_t GetNetSwitch(void);
 	void SetNetSwitch(const uint8_t);
 
+	void SetPortProtocol(const uint8_t, const TPortProtocol);
+	const TPortProtocol GetPortProtocol(const uint8_t);
+
 	const uint8_t GetActiveOutputPorts(void);
 	const uint8_t GetActiveInputPorts(void);
 
@@ -234,47 +348,107 @@ private:
 	void FillDiagData(void);
 
 	void HandlePoll(void);
+	void HandlePollReply(void);
 	void HandleDmx(void);
 	void HandleSync(void);
 	void HandleAddress(void);
 	void HandleTimeCode(void);
+	void HandleTodRequest(void);
+	void HandleTodControl(void);
+	void HandleRdm(void);
+	void HandleE131(void);
 
+	struct TMergeSource *MergeDmx(const uint8_t, const uint8_t *, const uint8_t *, const uint16_t);
 	bool IsMergedDmxDataChanged(const uint8_t, const uint8_t *, const uint16_t);
 	void CheckMergeTimeouts(const uint8_t);
+	void RemoveSource(const uint8_t, struct TMergeSource *);
+	void UpdateOutput(const uint8_t);
+	uint8_t AllocMergeBuffer(void);
+	void FreeMergeBuffer(struct TMergeSource *);
 	bool IsDmxDataChanged(const uint8_t, const uint8_t *, const uint16_t);
-
+	bool SwapDmxData(const uint8_t, const uint8_t *, const uint16_t);
+	void SetLightSetData(const uint8_t);
+	void CheckSyncDeadline(void);
+	void LeaveSynchronousMode(void);
+
+	void HandleDmxIn(void);
+	void SendDmx(const uint8_t, const uint8_t *, const uint16_t);
+
+	void HandleRdmResponse(void);
+	void HandleTodChanges(void);
+	void SendTod(const uint8_t);
+
+	bool IsPollThrottled(void);
+	uint32_t Random(void);
+	void UpdatePollReplyPorts(void);
+	void UpdateNodeReport(void);
 	void SendPollRelply(bool);
 	void SetNetworkDetails(void);
 
-	uint16_t MakePortAddress(const uint16_t);
+	uint16_t MakePortAddress(const uint16_t, const uint8_t);
+	void UpdatePortAddressIndex(void);
+	void JoinUniverse(const uint8_t);
 
 private:
 	CBlinkTask 				*m_pBlinkTask;		///<
 #if defined (__circle__)
 	CNetSubSystem			*m_pNet;			///<
 	CSocket					m_Socket;			///<
+	CSocket					m_SocketE131;		///< sACN is received on its own port
 #else
 	CBlinkTask				m_BlinkTask;
 #endif
 	bool 					m_IsDHCPUsed;		///<
 
 	LightSet    			*m_pLightSet;		///<
+	LightSetInput			*m_pLightSetInput;	///<
 	ArtNetTimeCode			*m_pArtNetTimeCode;	///<
+	LightSetRdm				*m_pLightSetRdm;		///<
 
 	time_t 					m_nCurrentPacketTime;
+	uint32_t				m_nCurrentPacketMicros;	///< Arrival time of the received packet
 
 	struct TArtNetNode		m_Node;				///< Struct describing the node
 	struct TArtNetNodeState m_State;			///< The current state of the node
 
-	struct TArtNetPacket 	m_ArtNetPacket;		///< The received Art-Net package
-	struct TArtPollReply	m_PollReply;		///<
+	struct TArtNetPacket	m_ArtNetPackets[ARTNET_NODE_MAX_PORTS + 1];	///< Receive buffer pool, one buffer per output port and one spare
+	struct TArtNetPacket 	*m_pArtNetPacket;	///< The received Art-Net package
+	struct TE131View		m_E131View;			///< The fields of the received sACN packet
+	struct TArtPollReply	m_PollReply;		///< Kept serialized, only the changed fields are updated before sending
+	struct TPollReplyPorts	m_PollReplyPorts[ARTNET_NODE_MAX_PAGES];	///<
+	uint32_t				m_nNodeReportCount;	///< The ArtPollReplyCount in the NodeReport
+	TArtNetNodeReportCode	m_tNodeReportCode;	///< The reportCode in the NodeReport
+	struct TPollSource		m_PollSources[ARTNET_NODE_MAX_POLL_SOURCES];	///<
+	uint32_t				m_nPollReplyInterval;	///< Microseconds, ArtPoll from the same controller within this time is not answered
+	uint32_t				m_nPollReplyDelay;	///< Microseconds, the maximum random delay of the ArtPollReply. 0 is answer right away
+	bool					m_bIsPollReplyPending;	///< The ArtPollReply is waiting for its random delay
+	uint32_t				m_nPollReplyMicros;	///< The time the pending ArtPollReply is sent
+	uint32_t				m_nRandom;			///< State of the random generator for the delay
 	struct TArtDiagData		m_DiagData;			///<
 
-	struct TOutputPort		m_OutputPorts[ARTNET_MAX_PORTS];	///<
+	struct TOutputPort		m_OutputPorts[ARTNET_NODE_MAX_PORTS];	///<
+	uint8_t					m_PortAddressIndex[256];			///< Sub-Net and Universe (bits 7-0 of the Port-Address) to output port index
+
+	uint8_t					m_MergeBuffers[ARTNET_NODE_MERGE_BUFFERS][ARTNET_DMX_LENGTH];	///< Merge buffer arena, shared by all output ports
+	uint8_t					m_MergeBuffersFree[ARTNET_NODE_MERGE_BUFFERS];	///< Stack of the free merge buffers
+	uint8_t					m_nMergeBuffersFree;							///< Number of free merge buffers
+#if ARTNET_NODE_MAX_SOURCES > 2
+	uint8_t					m_MergeScratch[ARTNET_DMX_LENGTH];				///< HTP of all but the last source
+#endif
 
 	bool					m_bDirectUpdate;
 
-	TOpCodes				m_tOpCodePrevious;
+	uint32_t				m_nSyncDeadline;	///< Microseconds, pending data is sent when no ArtSync is received in time. 0 is wait for ArtSync
+	struct TArtNetLatency	m_Latency;			///<
+
+	struct TInputPort		m_InputPorts[ARTNET_NODE_MAX_PORTS];	///<
+	struct TArtDmx			m_ArtDmxOut;		///< ArtDmx for the input ports
+	uint32_t				m_nInputKeepAlive;	///< Microseconds, the unchanged DMX data of an input port is sent again after this time
+	bool					m_bInputBroadcast;	///< Always broadcast the ArtDmx of the input ports
+
+	struct TArtTodData		m_ArtTodData;		///<
+	struct TArtRdm			m_ArtRdm;			///< The response to an ArtRdm
+	uint8_t					m_RdmRequest[ARTNET_RDM_DATA_LENGTH + 1];	///< ArtRdm Data with the start code added
 };
 
 #endif /* ARTNETNODE_H_ */
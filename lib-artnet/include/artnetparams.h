@@ -49,6 +49,10 @@ public:
 	const _output_type GetOutputType(void);
 
 	const bool IsUseTimeCode(void);
+
+	const uint32_t GetSyncDeadline(void);
+
+	const bool IsInput(void);
 };
 
 #endif /* ARTNETPARAMS_H_ */
@@ -55,6 +55,83 @@ enum {
 	ARTNET_MAX_PORTS = 4
 };
 
+/**
+ * The maximum output ports handled by a single node.
+ * The ports are reported in pages of \ref ARTNET_MAX_PORTS (ArtPollReply BindIndex).
+ * Every 16 ports occupy the next Sub-Net. Override at build time, maximum 32.
+ */
+#if !defined (ARTNET_NODE_MAX_PORTS)
+ #define ARTNET_NODE_MAX_PORTS	4		///< \ref ARTNET_MAX_PORTS, a number for the preprocessor
+#endif
+
+#if (ARTNET_NODE_MAX_PORTS < 1) || (ARTNET_NODE_MAX_PORTS > 32)
+ #error ARTNET_NODE_MAX_PORTS must be 1 .. 32
+#endif
+
+/**
+ * The highest Sub-Net of port 0. The Sub-Net of the last port must not wrap, as all ports share the same Net.
+ */
+#define ARTNET_NODE_MAX_SUBNET	(15 - ((ARTNET_NODE_MAX_PORTS - 1) / 16))
+
+/**
+ * The number of ArtPollReply pages needed for \ref ARTNET_NODE_MAX_PORTS
+ */
+#define ARTNET_NODE_MAX_PAGES	((ARTNET_NODE_MAX_PORTS + ARTNET_MAX_PORTS - 1) / ARTNET_MAX_PORTS)
+
+/**
+ * Port-Address lookup table entry for a Sub-Net/Universe without an output port
+ */
+#define ARTNET_PORT_INDEX_NONE	0xFF
+
+/**
+ * The maximum number of sources merged on a single output port.
+ * Art-Net merges two sources, a third source is discarded. Override at build time, maximum 255.
+ */
+#if !defined (ARTNET_NODE_MAX_SOURCES)
+ #define ARTNET_NODE_MAX_SOURCES	2
+#endif
+
+/**
+ * The number of DMX buffers shared by all output ports for merging.
+ * A source only holds a buffer while its port is merging. Override at build time, maximum 255.
+ */
+#if !defined (ARTNET_NODE_MERGE_BUFFERS)
+ #define ARTNET_NODE_MERGE_BUFFERS	(ARTNET_NODE_MAX_PORTS * 2)
+#endif
+
+/**
+ * Source entry without a merge buffer
+ */
+#define ARTNET_MERGE_BUFFER_NONE	0xFF
+
+/**
+ * The maximum number of nodes receiving the ArtDmx of an input port by unicast.
+ * With more subscribers, or none, the ArtDmx is broadcast. Override at build time.
+ */
+#if !defined (ARTNET_NODE_MAX_SUBSCRIBERS)
+ #define ARTNET_NODE_MAX_SUBSCRIBERS	4
+#endif
+
+/**
+ * The number of controllers for which the time of the latest ArtPollReply is kept, for the throttling of ArtPoll.
+ * Override at build time.
+ */
+#if !defined (ARTNET_NODE_MAX_POLL_SOURCES)
+ #define ARTNET_NODE_MAX_POLL_SOURCES	8
+#endif
+
+/**
+ * 1 when the network layer delivers the sACN port 5568 next to the Art-Net port, then the output ports can switch to sACN.
+ * Circle binds its own socket for it. The UDP layer of the ESP8266 has a single port. Override at build time.
+ */
+#if !defined (ARTNET_NODE_SACN)
+ #if defined (__circle__)
+  #define ARTNET_NODE_SACN	1
+ #else
+  #define ARTNET_NODE_SACN	0
+ #endif
+#endif
+
 /**
  * The length of the short name field. Always 18
  */
@@ -83,6 +160,13 @@ enum {
 	ARTNET_DMX_LENGTH = 512
 };
 
+/**
+ * The length of a sACN (E1.31) data packet with 512 slots. The node receives these next to Art-Net.
+ */
+enum {
+	ARTNET_E131_PACKET_LENGTH = 638
+};
+
 /**
  * Number of bytes in a RDM UID
  */
@@ -90,6 +174,20 @@ enum {
 	ARTNET_RDM_UID_WIDTH = 6
 };
 
+/**
+ * The maximum number of UIDs in a single ArtTodData. Always 200
+ */
+enum {
+	ARTNET_TOD_MAX_UIDS = 200
+};
+
+/**
+ * The length of the RDM data field of ArtRdm, the RDM message without the start code and with the checksum
+ */
+enum {
+	ARTNET_RDM_DATA_LENGTH = 256
+};
+
 /**
  * Length of the hardware address
  */
@@ -51,6 +51,10 @@ enum TOpCodes {
 	OP_DMX = 0x5000,		///< This is an ArtDmx data packet. It contains zero start code DMX512 information for a single Universe.
 	OP_SYNC = 0x5200,		///< This is an ArtSync data packet. It is used to force synchronous transfer of ArtDmx packets to a node’s output.
 	OP_ADDRESS = 0x6000,	///< This is an ArtAddress packet. It contains remote programming information for a Node.
+	OP_TODREQUEST = 0x8000,	///< This is an ArtTodRequest packet. It is used to request a Table of Devices (ToD) for RDM discovery.
+	OP_TODDATA = 0x8100,	///< This is an ArtTodData packet. It is used to send a Table of Devices (ToD) for RDM discovery.
+	OP_TODCONTROL = 0x8200,	///< This is an ArtTodControl packet. It is used to send RDM discovery control messages.
+	OP_RDM = 0x8300,		///< This is an ArtRdm packet. It is used to send all non discovery RDM messages.
 	OP_TIMECODE = 0x9700,	///< This is an ArtTimeCode packet. It is used to transport time code over the network.
 	OP_TIMESYNC = 0x9800,	///< Used to synchronise real time date and clock
 	OP_NOT_DEFINED = 0x0000	///< OP_NOT_DEFINED
@@ -165,7 +169,7 @@ struct TArtAddress {
 	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
 	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
 	uint8_t NetSwitch;		///< This value is ignored unless bit 7 is high. Send 0x00 to reset this value to the physical switch setting. Use value 0x7f for no change.
-	uint8_t Filler2;		///< Pad length to match ArtPoll.
+	uint8_t BindIndex;		///< The bound node (page of ports) which is programmed. 0 or 1 is the root device.
 	uint8_t ShortName[ARTNET_SHORT_NAME_LENGTH];///< The Node will ignore this value if the string is null.
 	uint8_t LongName[ARTNET_LONG_NAME_LENGTH];	///< The Node will ignore this value if the string is null.
 	uint8_t SwIn[ARTNET_MAX_PORTS];		///< This value is ignored unless bit 7 is high. Send 0x00 to reset this value to the physical switch setting. Use value 0x7f for no change.
@@ -197,6 +201,86 @@ struct TArtTimeCode {
 	uint8_t Type;			///< 0 = Film (24fps) , 1 = EBU (25fps), 2 = DF (29.97fps), 3 = SMPTE (30fps)
 }PACKED;
 
+/**
+ * ArtTodRequest packet definition
+ *
+ * This packet is used to request the Table of RDM Devices (TOD).
+ */
+struct TArtTodRequest {
+	uint8_t Id[8];			///< Array of 8 characters, the final character is a null termination. Value = ‘A’ ‘r’ ‘t’ ‘-‘ ‘N’ ‘e’ ‘t’ 0x00
+	uint16_t OpCode;		///< OpTodRequest \ref TOpCodes
+	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
+	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
+	uint8_t Filler1;		///< Pad length to match ArtPoll.
+	uint8_t Filler2;		///< Pad length to match ArtPoll.
+	uint8_t Spare[7];		///< Transmit as zero, receivers don’t test.
+	uint8_t Net;			///< The top 7 bits of the 15 bit Port-Address of Nodes that must respond to this packet.
+	uint8_t Command;		///< 0x00 TodFull : Send the entire TOD.
+	uint8_t AdCount;		///< The number of entries in Address that are used. Max value is 32.
+	uint8_t Address[32];	///< This array defines the low byte of the Port-Address of the Output Gateway nodes that must respond to this packet.
+}PACKED;
+
+/**
+ * ArtTodData packet definition
+ *
+ * This packet is used to transmit the Table of RDM Devices (TOD).
+ */
+struct TArtTodData {
+	uint8_t Id[8];			///< Array of 8 characters, the final character is a null termination. Value = ‘A’ ‘r’ ‘t’ ‘-‘ ‘N’ ‘e’ ‘t’ 0x00
+	uint16_t OpCode;		///< OpTodData \ref TOpCodes
+	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
+	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
+	uint8_t RdmVer;			///< Art-Net Devices that only support RDM DRAFT V1.0 set field to 0x00. Devices that support RDM STANDARD V1.0 set field to 0x01.
+	uint8_t Port;			///< Physical Port. Range 1-4.
+	uint8_t Spare[6];		///< Transmit as zero, receivers don’t test.
+	uint8_t BindIndex;		///< The BindIndex defines the bound node which originated this packet.
+	uint8_t Net;			///< The top 7 bits of the Port-Address of the Output Gateway DMX Port that generated this packet.
+	uint8_t CommandResponse;///< 0x00 TodFull : The packet contains the entire TOD or is the first packet in a sequence of packets that contains the entire TOD.
+	uint8_t Address;		///< The low 8 bits of the Port-Address of the Output Gateway DMX Port that generated this packet.
+	uint8_t UidTotalHi;		///< The total number of RDM devices discovered by this Universe.
+	uint8_t UidTotalLo;		///< Low byte of above.
+	uint8_t BlockCount;		///< The index number of this packet. When UidTotal exceeds 200, multiple ArtTodData packets are used.
+	uint8_t UidCount;		///< The number of UIDs encoded in this packet. This is the index of the following array.
+	uint8_t Tod[ARTNET_TOD_MAX_UIDS][ARTNET_RDM_UID_WIDTH];	///< An array of RDM UID.
+}PACKED;
+
+/**
+ * ArtTodControl packet definition
+ *
+ * The ArtTodControl packet is used to send RDM control parameters over Art-Net.
+ */
+struct TArtTodControl {
+	uint8_t Id[8];			///< Array of 8 characters, the final character is a null termination. Value = ‘A’ ‘r’ ‘t’ ‘-‘ ‘N’ ‘e’ ‘t’ 0x00
+	uint16_t OpCode;		///< OpTodControl \ref TOpCodes
+	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
+	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
+	uint8_t Filler1;		///< Pad length to match ArtPoll.
+	uint8_t Filler2;		///< Pad length to match ArtPoll.
+	uint8_t Spare[7];		///< Transmit as zero, receivers don’t test.
+	uint8_t Net;			///< The top 7 bits of the Port-Address of the Output Gateway DMX Port that should action this command.
+	uint8_t Command;		///< 0x00 AtcNone : No action. 0x01 AtcFlush : The node flushes its TOD and instigates full discovery.
+	uint8_t Address;		///< The low byte of the 15 bit Port-Address of the DMX Port that should action this command.
+}PACKED;
+
+/**
+ * ArtRdm packet definition
+ *
+ * The ArtRdm packet is used to transport all non-discovery RDM messages over Art-Net.
+ */
+struct TArtRdm {
+	uint8_t Id[8];			///< Array of 8 characters, the final character is a null termination. Value = ‘A’ ‘r’ ‘t’ ‘-‘ ‘N’ ‘e’ ‘t’ 0x00
+	uint16_t OpCode;		///< OpRdm \ref TOpCodes
+	uint8_t ProtVerHi;		///< High byte of the Art-Net protocol revision number.
+	uint8_t ProtVerLo;		///< Low byte of the Art-Net protocol revision number. Current value 14.
+	uint8_t RdmVer;			///< Art-Net Devices that only support RDM DRAFT V1.0 set field to 0x00. Devices that support RDM STANDARD V1.0 set field to 0x01.
+	uint8_t Filler2;		///< Pad length to match ArtPoll.
+	uint8_t Spare[7];		///< Transmit as zero, receivers don’t test.
+	uint8_t Net;			///< The top 7 bits of the 15 bit Port-Address that should action this command.
+	uint8_t Command;		///< 0x00 ArProcess : Process RDM Packet.
+	uint8_t Address;		///< The low 8 bits of the Port-Address that should action this command.
+	uint8_t Data[ARTNET_RDM_DATA_LENGTH];	///< The RDM data packet excluding the DMX StartCode.
+}PACKED;
+
 /**
  * union of supported artnet packets
  */
@@ -208,6 +292,10 @@ union UArtPacket {
 	struct TArtSync ArtSync;			///< ArtSync packet
 	struct TArtAddress ArtAddress;		///< ArtAddress packet
 	struct TArtTimeCode ArtTimeCode;	///< ArtTimeCode packet
+	struct TArtTodRequest ArtTodRequest;///< ArtTodRequest packet
+	struct TArtTodControl ArtTodControl;///< ArtTodControl packet
+	struct TArtRdm ArtRdm;				///< ArtRdm packet
+	uint8_t E131[ARTNET_E131_PACKET_LENGTH];	///< sACN data packet, received in the same buffers as Art-Net
 };
 
 
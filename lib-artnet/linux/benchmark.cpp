@@ -0,0 +1,455 @@
+/**
+ * @file benchmark.cpp
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Replay a capture of Art-Net traffic through ArtNetNode::HandlePacket and report the CPU time per OpCode.
+ *
+ * benchmark [-l loops] [-i node ip] [-n net] [-s subnet] [-u universe] [-f frames] capture.pcap
+ *
+ * -f : check that every port which received data received this number of frames, the exit code is non-zero otherwise
+ *
+ * benchmark -w capture.pcap [-f frames]
+ *
+ * Write a synthetic capture : ArtDmx for universe 0 and 1 followed by an ArtSync, at 40 Hz.
+ * Every frame changes the data, so each port outputs every frame.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "artnetnode.h"
+#include "packets.h"
+#include "lightset.h"
+
+#include "replay.h"
+#include "sys_time.h"
+
+#define MERGE_TIMEOUT_SECONDS	10		///< Same as the node, a source without data for this time is not merged
+#define MAX_UNIVERSES			64		///< Port-Addresses tracked for the detection of the merge path
+#define SYNC_UNIVERSES			2		///< Universes in the synthetic capture
+#define SYNC_FRAMES_DEFAULT		100		///<
+#define SYNC_FRAME_MICROS		25000	///< 40 Hz
+
+/**
+ * The LightSet counts the frames
+ */
+class LightSetCounter : public LightSet {
+public:
+	LightSetCounter(void) : m_nSlots(0) {
+		memset(m_nFrames, 0, sizeof m_nFrames);
+	}
+
+	void Start(void) {
+	}
+
+	void Stop(void) {
+	}
+
+	void SetData(const uint8_t nPort, const uint8_t *pData, const uint16_t nLength) {
+		m_nFrames[nPort]++;
+		m_nSlots += nLength;
+	}
+
+	void SetDataRange(const uint8_t nPort, const uint8_t *pData, const uint16_t nLength, const uint16_t nOffset, const uint16_t nCount) {
+		m_nFrames[nPort]++;
+		m_nSlots += nCount;
+	}
+
+	uint32_t m_nFrames[ARTNET_NODE_MAX_PORTS];	///< SetData and SetDataRange calls per port
+	uint64_t m_nSlots;							///< Slots handed over, only the changed slots for SetDataRange
+};
+
+enum TBenchmarkClass {
+	CLASS_DMX,
+	CLASS_DMX_MERGE,
+	CLASS_SYNC,
+	CLASS_POLL,
+	CLASS_OTHER,
+	CLASS_COUNT
+};
+
+static const char *class_names[CLASS_COUNT] = { "ArtDmx", "ArtDmx merge", "ArtSync", "ArtPoll", "Other" };
+
+struct TBenchmarkStats {
+	uint32_t nCount;
+	uint64_t nTotal;	///< Nanoseconds
+	uint32_t nMax;		///< Nanoseconds
+};
+
+/**
+ * The sources of a Port-Address, for the detection of the merge path
+ */
+struct TUniverseSources {
+	uint16_t nPortAddress;
+	uint32_t nIp[2];
+	time_t nTime[2];
+};
+
+static struct TUniverseSources universes[MAX_UNIVERSES];
+static unsigned universes_count;
+
+/**
+ * @return true when a second source sent data for the Port-Address within \ref MERGE_TIMEOUT_SECONDS
+ */
+static bool is_merging(const uint16_t nPortAddress, const uint32_t nIp, const time_t nTime) {
+	struct TUniverseSources *p = NULL;
+	unsigned i;
+
+	for (i = 0; i < universes_count; i++) {
+		if (universes[i].nPortAddress == nPortAddress) {
+			p = &universes[i];
+			break;
+		}
+	}
+
+	if (p == NULL) {
+		if (universes_count == MAX_UNIVERSES) {
+			return false;
+		}
+		p = &universes[universes_count++];
+		p->nPortAddress = nPortAddress;
+	}
+
+	for (i = 0; i < 2; i++) {
+		if ((p->nIp[i] != 0) && ((nTime - p->nTime[i]) > MERGE_TIMEOUT_SECONDS)) {
+			p->nIp[i] = 0;
+		}
+	}
+
+	if (p->nIp[0] == nIp) {
+		p->nTime[0] = nTime;
+	} else if (p->nIp[1] == nIp) {
+		p->nTime[1] = nTime;
+	} else if (p->nIp[0] == 0) {
+		p->nIp[0] = nIp;
+		p->nTime[0] = nTime;
+	} else if (p->nIp[1] == 0) {
+		p->nIp[1] = nIp;
+		p->nTime[1] = nTime;
+	}
+
+	return (p->nIp[0] != 0) && (p->nIp[1] != 0);
+}
+
+static TBenchmarkClass classify(const uint8_t *pPacket, const uint16_t nLength, const uint32_t nIp) {
+	if ((nLength < 12) || (memcmp(pPacket, "Art-Net", 8) != 0)) {
+		return CLASS_OTHER;
+	}
+
+	switch ((pPacket[9] << 8) | pPacket[8]) {
+	case OP_DMX:
+		if ((nLength >= 18) && is_merging((uint16_t) ((pPacket[15] << 8) | pPacket[14]), nIp, sys_time(NULL))) {
+			return CLASS_DMX_MERGE;
+		}
+		return CLASS_DMX;
+	case OP_SYNC:
+		return CLASS_SYNC;
+	case OP_POLL:
+		return CLASS_POLL;
+	default:
+		break;
+	}
+
+	return CLASS_OTHER;
+}
+
+inline static uint64_t get_nanos(clockid_t clock) {
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-l loops] [-i node ip] [-n net] [-s subnet] [-u universe] [-f frames] capture.pcap\n", name);
+	fprintf(stderr, "       %s -w capture.pcap [-f frames]\n", name);
+}
+
+inline static void put_u16(uint8_t *p, const uint16_t n) {
+	memcpy(p, &n, 2);
+}
+
+inline static void put_u32(uint8_t *p, const uint32_t n) {
+	memcpy(p, &n, 4);
+}
+
+/**
+ * Write a pcap record with a raw IPv4 UDP packet from 2.0.0.2 broadcast to the Art-Net port.
+ */
+static bool write_record(FILE *fp, const uint32_t nMicros, const void *pPayload, const uint16_t nLength) {
+	uint8_t record[16 + 20 + 8];
+	uint8_t *ip = &record[16];
+	uint8_t *udp = &record[36];
+
+	memset(record, 0, sizeof record);
+
+	put_u32(&record[0], nMicros / 1000000);
+	put_u32(&record[4], nMicros % 1000000);
+	put_u32(&record[8], (uint32_t) (28 + nLength));
+	put_u32(&record[12], (uint32_t) (28 + nLength));
+
+	ip[0] = 0x45;
+	put_u16(&ip[2], htons((uint16_t) (28 + nLength)));
+	ip[8] = 64;
+	ip[9] = 17;	// UDP
+	put_u32(&ip[12], inet_addr("2.0.0.2"));
+	put_u32(&ip[16], inet_addr("2.255.255.255"));
+
+	put_u16(&udp[0], htons(6454));
+	put_u16(&udp[2], htons(6454));
+	put_u16(&udp[4], htons((uint16_t) (8 + nLength)));
+
+	return (fwrite(record, sizeof record, 1, fp) == 1) && (fwrite(pPayload, nLength, 1, fp) == 1);
+}
+
+/**
+ * The multi universe frame of a video wall : ArtDmx for each universe, then ArtSync.
+ */
+static bool write_sync_capture(const char *pFileName, const unsigned nFrames) {
+	uint8_t header[24];
+	struct TArtDmx dmx;
+	struct TArtSync sync;
+	bool isOk;
+	FILE *fp;
+
+	if ((fp = fopen(pFileName, "wb")) == NULL) {
+		perror(pFileName);
+		return false;
+	}
+
+	put_u32(&header[0], 0xa1b2c3d4);
+	put_u16(&header[4], 2);
+	put_u16(&header[6], 4);
+	put_u32(&header[8], 0);
+	put_u32(&header[12], 0);
+	put_u32(&header[16], 65535);
+	put_u32(&header[20], 101);	// Raw IP
+
+	isOk = (fwrite(header, sizeof header, 1, fp) == 1);
+
+	memset(&dmx, 0, sizeof dmx);
+	memcpy(dmx.Id, "Art-Net", 8);
+	dmx.OpCode = OP_DMX;
+	dmx.ProtVerLo = 14;
+	dmx.LengthHi = ARTNET_DMX_LENGTH >> 8;
+	dmx.Length = ARTNET_DMX_LENGTH & 0xFF;
+
+	memset(&sync, 0, sizeof sync);
+	memcpy(sync.Id, "Art-Net", 8);
+	sync.OpCode = OP_SYNC;
+	sync.ProtVerLo = 14;
+
+	for (unsigned nFrame = 0; isOk && (nFrame < nFrames); nFrame++) {
+		const uint32_t nMicros = nFrame * SYNC_FRAME_MICROS;
+
+		for (unsigned nUniverse = 0; isOk && (nUniverse < SYNC_UNIVERSES); nUniverse++) {
+			dmx.Sequence = (uint8_t) (nFrame + 1);
+			dmx.PortAddress = (uint16_t) nUniverse;
+			memset(dmx.Data, (uint8_t) nFrame, sizeof dmx.Data);
+			isOk = write_record(fp, nMicros + nUniverse * 100, &dmx, sizeof dmx);
+		}
+
+		isOk = isOk && write_record(fp, nMicros + SYNC_UNIVERSES * 100, &sync, sizeof sync);
+	}
+
+	if ((fclose(fp) != 0) || !isOk) {
+		perror(pFileName);
+		return false;
+	}
+
+	printf("%s : %u frames of %u universes and ArtSync\n", pFileName, nFrames, (unsigned) SYNC_UNIVERSES);
+
+	return true;
+}
+
+int main(int argc, char **argv) {
+	struct TBenchmarkStats stats[CLASS_COUNT];
+	struct in_addr ip;
+	unsigned nLoops = 1;
+	uint8_t nNet = 0, nSubnet = 0, nUniverse = 0;
+	unsigned nFramesExpected = 0;
+	const char *pWriteFileName = NULL;
+	int c;
+
+	ip.s_addr = inet_addr("2.0.0.1");
+
+	while ((c = getopt(argc, argv, "l:i:n:s:u:f:w:")) != -1) {
+		switch (c) {
+		case 'f':
+			nFramesExpected = (unsigned) atoi(optarg);
+			break;
+		case 'w':
+			pWriteFileName = optarg;
+			break;
+		case 'l':
+			nLoops = (unsigned) atoi(optarg);
+			break;
+		case 'i':
+			if (inet_aton(optarg, &ip) == 0) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'n':
+			nNet = (uint8_t) atoi(optarg);
+			break;
+		case 's':
+			nSubnet = (uint8_t) atoi(optarg);
+			break;
+		case 'u':
+			nUniverse = (uint8_t) atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (pWriteFileName != NULL) {
+		return write_sync_capture(pWriteFileName, nFramesExpected == 0 ? SYNC_FRAMES_DEFAULT : nFramesExpected) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (optind >= argc) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Art-Net 'A' network type, 2.x.x.x/8
+	if (!replay_open(argv[optind], ip.s_addr, inet_addr("255.0.0.0"))) {
+		return EXIT_FAILURE;
+	}
+
+	LightSetCounter lightSet;
+	ArtNetNode node;
+
+	node.SetOutput(&lightSet);
+	node.SetNetSwitch(nNet);
+	node.SetSubnetSwitch(nSubnet);
+
+	for (uint8_t i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		node.SetUniverseSwitch(i, ARTNET_OUTPUT_PORT, (uint8_t) (nUniverse + i));
+	}
+
+	node.SetPollReplyDelay(0);
+	node.Start();
+
+	memset(stats, 0, sizeof stats);
+
+	const uint64_t nCpuStart = get_nanos(CLOCK_PROCESS_CPUTIME_ID);
+	const uint64_t nWallStart = get_nanos(CLOCK_MONOTONIC);
+
+	for (unsigned nLoop = 0; nLoop < nLoops; nLoop++) {
+		const uint8_t *pPacket;
+		uint16_t nLength;
+		uint32_t nIp;
+
+		replay_rewind();
+
+		while ((pPacket = replay_peek(&nLength, &nIp)) != NULL) {
+			const uint64_t nStart = get_nanos(CLOCK_MONOTONIC);
+			(void) node.HandlePacket();
+			const uint32_t nElapsed = (uint32_t) (get_nanos(CLOCK_MONOTONIC) - nStart);
+
+			// Classified after HandlePacket, so that the clock is at the capture time of the packet
+			struct TBenchmarkStats *p = &stats[classify(pPacket, nLength, nIp)];
+			p->nCount++;
+			p->nTotal += nElapsed;
+			if (nElapsed > p->nMax) {
+				p->nMax = nElapsed;
+			}
+		}
+	}
+
+	const uint64_t nWall = get_nanos(CLOCK_MONOTONIC) - nWallStart;
+	const uint64_t nCpu = get_nanos(CLOCK_PROCESS_CPUTIME_ID) - nCpuStart;
+
+	node.Stop();
+
+	uint32_t nPackets = 0;
+	uint64_t nFrames = 0;
+
+	for (unsigned i = 0; i < CLASS_COUNT; i++) {
+		nPackets += stats[i].nCount;
+	}
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		nFrames += lightSet.m_nFrames[i];
+	}
+
+	printf("Capture  : %u packets, %.3f s, replayed %u time(s)\n", replay_get_packets(), (double) replay_get_duration() / 1E6, nLoops);
+	printf("Node     : %s, Net %u, Sub-Net %u, Universe %u, %u output port(s)\n", inet_ntoa(ip), nNet, nSubnet, nUniverse, (unsigned) ARTNET_NODE_MAX_PORTS);
+	printf("Time     : wall %.3f ms, CPU %.3f ms\n", (double) nWall / 1E6, (double) nCpu / 1E6);
+	printf("Rate     : %.0f packets/s, %.1f ns/packet CPU\n", nPackets / ((double) nCpu / 1E9), nPackets == 0 ? 0.0 : (double) nCpu / nPackets);
+	printf("\n%-14s %10s %12s %10s\n", "", "packets", "ns/packet", "max ns");
+
+	for (unsigned i = 0; i < CLASS_COUNT; i++) {
+		if (stats[i].nCount == 0) {
+			continue;
+		}
+		printf("%-14s %10u %12.1f %10u\n", class_names[i], stats[i].nCount, (double) stats[i].nTotal / stats[i].nCount, stats[i].nMax);
+	}
+
+	printf("\nLightSet : %llu frames, %llu slots\n", (unsigned long long) nFrames, (unsigned long long) lightSet.m_nSlots);
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		if (lightSet.m_nFrames[i] != 0) {
+			printf("  port %-3u %u frames\n", i, lightSet.m_nFrames[i]);
+		}
+	}
+
+	const struct TArtNetLatency *pLatency = node.GetLatency();
+
+	if (pLatency->nCount != 0) {
+		printf("Latency  : %u outputs, min %u us, max %u us (capture time)\n", pLatency->nCount, pLatency->nMin, pLatency->nMax);
+	}
+
+	printf("Sent     : %u packets\n", replay_get_sent());
+
+	replay_close();
+
+	if (nFramesExpected != 0) {
+		bool isOk = (nFrames != 0);
+
+		for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+			if ((lightSet.m_nFrames[i] != 0) && (lightSet.m_nFrames[i] != nFramesExpected * nLoops)) {
+				fprintf(stderr, "port %u : %u frames, expected %u\n", i, lightSet.m_nFrames[i], nFramesExpected * nLoops);
+				isOk = false;
+			}
+		}
+
+		if (!isOk) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
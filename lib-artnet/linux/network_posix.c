@@ -0,0 +1,270 @@
+/**
+ * @file network_posix.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * The udp.h and wifi.h interface on POSIX sockets, for running lib-artnet on a Linux host.
+ * The IP addresses are in network byte order, as on the ESP8266.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include "wifi.h"
+#include "udp.h"
+
+#include "network_posix.h"
+
+#define E131_UDP_PORT	5568	///< sACN, received by the node next to Art-Net, see ARTNET_NODE_SACN
+
+static int udp_socket = -1;
+static int e131_socket = -1;
+static struct ip_info if_ip_info;
+static uint8_t if_macaddr[6];
+static char if_name[IFNAMSIZ];
+
+/**
+ * Get the IP address, network mask and MAC address of the interface.
+ *
+ * @param ifname The interface, for example "eth0"
+ * @return false when the interface has no IPv4 address
+ */
+bool network_posix_init(const char *ifname) {
+	struct ifaddrs *ifaddr, *ifa;
+	struct ifreq ifr;
+	bool is_found = false;
+	int fd;
+
+	assert(ifname != NULL);
+
+	strncpy(if_name, ifname, IFNAMSIZ - 1);
+
+	if (getifaddrs(&ifaddr) == -1) {
+		perror("getifaddrs");
+		return false;
+	}
+
+	for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+		if ((ifa->ifa_addr == NULL) || (ifa->ifa_addr->sa_family != AF_INET) || (strcmp(ifa->ifa_name, if_name) != 0)) {
+			continue;
+		}
+
+		if_ip_info.ip.addr = ((struct sockaddr_in *) ifa->ifa_addr)->sin_addr.s_addr;
+		if_ip_info.netmask.addr = ((struct sockaddr_in *) ifa->ifa_netmask)->sin_addr.s_addr;
+		if_ip_info.gw.addr = 0;
+		is_found = true;
+		break;
+	}
+
+	freeifaddrs(ifaddr);
+
+	if (!is_found) {
+		fprintf(stderr, "%s : no IPv4 address\n", if_name);
+		return false;
+	}
+
+	memset(if_macaddr, 0, sizeof(if_macaddr));
+
+	if ((fd = socket(AF_INET, SOCK_DGRAM, 0)) >= 0) {
+		memset(&ifr, 0, sizeof(ifr));
+		memcpy(ifr.ifr_name, if_name, IFNAMSIZ);
+
+		if (ioctl(fd, SIOCGIFHWADDR, &ifr) == 0) {
+			memcpy(if_macaddr, ifr.ifr_hwaddr.sa_data, sizeof(if_macaddr));
+		}
+
+		close(fd);
+	}
+
+	return true;
+}
+
+/**
+ *
+ * @param mac
+ * @return
+ */
+bool wifi_get_macaddr(uint8_t *mac) {
+	memcpy(mac, if_macaddr, sizeof(if_macaddr));
+	return true;
+}
+
+/**
+ *
+ * @param info
+ * @return
+ */
+bool wifi_get_ip_info(struct ip_info *info) {
+	memcpy(info, &if_ip_info, sizeof(struct ip_info));
+	return true;
+}
+
+/**
+ * The DHCP client is not known here
+ *
+ * @return
+ */
+const bool wifi_is_dhcp_used(void) {
+	return false;
+}
+
+/**
+ *
+ * @param port
+ * @return The non blocking socket, -1 on error
+ */
+static int udp_open(const uint16_t port) {
+	struct sockaddr_in si_me;
+	int enable = 1;
+	int fd;
+
+	if ((fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	(void) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+	(void) setsockopt(fd, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable));
+	(void) setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, if_name, (socklen_t) strlen(if_name));
+
+	memset(&si_me, 0, sizeof(si_me));
+	si_me.sin_family = AF_INET;
+	si_me.sin_port = htons(port);
+	si_me.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (bind(fd, (struct sockaddr *) &si_me, sizeof(si_me)) < 0) {
+		perror("bind");
+	}
+
+	(void) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+	return fd;
+}
+
+/**
+ * The socket is non blocking, \ref udp_recvfrom returns 0 when there is nothing received.
+ * The sACN port is bound next to the port, so the node receives sACN as on Circle.
+ *
+ * @param port
+ */
+void udp_begin(const uint16_t port) {
+	if (udp_socket >= 0) {
+		close(udp_socket);
+	}
+
+	if (e131_socket >= 0) {
+		close(e131_socket);
+		e131_socket = -1;
+	}
+
+	udp_socket = udp_open(port);
+
+	if (port != E131_UDP_PORT) {
+		e131_socket = udp_open(E131_UDP_PORT);
+	}
+}
+
+/**
+ *
+ * @param ip_address
+ */
+void udp_joingroup(const uint32_t ip_address) {
+	struct ip_mreq mreq;
+
+	mreq.imr_multiaddr.s_addr = ip_address;
+	mreq.imr_interface.s_addr = if_ip_info.ip.addr;
+
+	if (setsockopt(e131_socket >= 0 ? e131_socket : udp_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+		perror("IP_ADD_MEMBERSHIP");
+	}
+}
+
+/**
+ *
+ * @param buffer
+ * @param length
+ * @param ip_address
+ * @param port
+ * @return
+ */
+uint16_t udp_recvfrom(const uint8_t *buffer, const uint16_t length, uint32_t *ip_address, uint16_t *port) {
+	struct sockaddr_in si_other;
+	socklen_t slen = sizeof(si_other);
+	ssize_t bytes_received;
+
+	assert(buffer != NULL);
+	assert(ip_address != NULL);
+	assert(port != NULL);
+
+	bytes_received = recvfrom(udp_socket, (void *) buffer, length, 0, (struct sockaddr *) &si_other, &slen);
+
+	if ((bytes_received <= 0) && (e131_socket >= 0)) {
+		slen = sizeof(si_other);
+		bytes_received = recvfrom(e131_socket, (void *) buffer, length, 0, (struct sockaddr *) &si_other, &slen);
+	}
+
+	if (bytes_received <= 0) {
+		*ip_address = 0;
+		*port = 0;
+		return 0;
+	}
+
+	*ip_address = si_other.sin_addr.s_addr;
+	*port = ntohs(si_other.sin_port);
+
+	return (uint16_t) bytes_received;
+}
+
+/**
+ *
+ * @param buffer
+ * @param length
+ * @param ip_address
+ * @param port
+ */
+void udp_sendto(const uint8_t *buffer, const uint16_t length, const uint32_t ip_address, const uint16_t port) {
+	struct sockaddr_in si_other;
+
+	assert(buffer != NULL);
+
+	memset(&si_other, 0, sizeof(si_other));
+	si_other.sin_family = AF_INET;
+	si_other.sin_addr.s_addr = ip_address;
+	si_other.sin_port = htons(port);
+
+	if (sendto(udp_socket, buffer, length, 0, (struct sockaddr *) &si_other, sizeof(si_other)) < 0) {
+		perror("sendto");
+	}
+}
@@ -0,0 +1,530 @@
+/**
+ * @file replay.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * The udp.h, wifi.h and sys_time.h interface fed from a capture file.
+ * The UDP packets for the Art-Net and sACN ports are read from a pcap file (tcpdump, Wireshark) into memory.
+ * udp_recvfrom returns the next packet and the clock (micros, millis, sys_time) jumps to its capture time.
+ * So the timeouts of the node behave as in the capture, however fast the packets are handled.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "wifi.h"
+#include "udp.h"
+#include "sys_time.h"
+
+#include "replay.h"
+
+#define PCAP_MAGIC				0xa1b2c3d4	///< Microsecond time stamps
+#define PCAP_MAGIC_NSEC			0xa1b23c4d	///< Nanosecond time stamps
+
+#define PCAP_LINKTYPE_NULL		0			///< BSD loopback
+#define PCAP_LINKTYPE_ETHERNET	1			///<
+#define PCAP_LINKTYPE_RAW		101			///< Raw IP
+#define PCAP_LINKTYPE_LINUX_SLL	113			///< tcpdump -i any
+#define PCAP_LINKTYPE_LINUX_SLL2	276		///< tcpdump -i any, newer libpcap
+
+#define ETHERTYPE_IPV4			0x0800		///<
+#define ETHERTYPE_VLAN			0x8100		///<
+
+#define IP_PROTOCOL_UDP			17			///<
+
+#define ARTNET_UDP_PORT			0x1936		///< 6454
+#define E131_UDP_PORT			5568		///< sACN, handled by the node next to Art-Net
+
+/**
+ * A packet in the replay buffer
+ */
+struct replay_packet {
+	uint32_t offset;	///< Offset of the UDP payload in the data buffer
+	uint16_t length;	///< Length of the UDP payload
+	uint32_t ip;		///< Source IP address, network byte order
+	uint64_t micros;	///< Capture time relative to the first packet
+};
+
+static struct replay_packet *packets;
+static uint32_t packets_count;
+static uint8_t *data;
+
+static uint32_t next;			///< Index of the next packet returned by udp_recvfrom
+static uint64_t loop_micros;	///< Added to the capture time, the clock continues when the capture is replayed again
+static uint64_t now_micros;		///< The clock
+static time_t start_seconds;	///< Capture time of the first packet
+
+static uint32_t node_ip;
+static uint32_t node_netmask;
+static uint32_t sent_count;
+
+inline static uint16_t get_be16(const uint8_t *p) {
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+inline static uint32_t get_u32(const uint8_t *p, const bool is_swapped) {
+	const uint32_t u = (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+	return is_swapped ? __builtin_bswap32(u) : u;
+}
+
+/**
+ * Find the IPv4 header behind the link layer header.
+ *
+ * @return NULL when the frame is not IPv4
+ */
+static const uint8_t *get_ipv4(const uint8_t *frame, uint32_t *length, const uint32_t linktype) {
+	uint32_t header;
+	uint16_t ethertype;
+
+	switch (linktype) {
+	case PCAP_LINKTYPE_NULL:
+		header = 4;
+		ethertype = ETHERTYPE_IPV4;
+		break;
+	case PCAP_LINKTYPE_ETHERNET:
+		if (*length < 14) {
+			return NULL;
+		}
+		header = 14;
+		ethertype = get_be16(&frame[12]);
+		if ((ethertype == ETHERTYPE_VLAN) && (*length >= 18)) {
+			header = 18;
+			ethertype = get_be16(&frame[16]);
+		}
+		break;
+	case PCAP_LINKTYPE_RAW:
+		header = 0;
+		ethertype = ETHERTYPE_IPV4;
+		break;
+	case PCAP_LINKTYPE_LINUX_SLL:
+		if (*length < 16) {
+			return NULL;
+		}
+		header = 16;
+		ethertype = get_be16(&frame[14]);
+		break;
+	case PCAP_LINKTYPE_LINUX_SLL2:
+		if (*length < 20) {
+			return NULL;
+		}
+		header = 20;
+		ethertype = get_be16(&frame[0]);
+		break;
+	default:
+		return NULL;
+	}
+
+	if ((ethertype != ETHERTYPE_IPV4) || (*length < header + 20)) {
+		return NULL;
+	}
+
+	*length -= header;
+
+	return &frame[header];
+}
+
+/**
+ * Add the UDP payload of the frame when it is for the Art-Net or the sACN port.
+ */
+static void add_frame(const uint8_t *frame, uint32_t length, const uint32_t linktype, const uint64_t micros, uint32_t *data_length) {
+	const uint8_t *ip = get_ipv4(frame, &length, linktype);
+	const uint8_t *udp;
+	uint32_t ihl, udp_length, src;
+	uint16_t port;
+
+	if ((ip == NULL) || ((ip[0] >> 4) != 4) || (ip[9] != IP_PROTOCOL_UDP)) {
+		return;
+	}
+
+	// Fragments are not reassembled
+	if ((get_be16(&ip[6]) & 0x3FFF) != 0) {
+		return;
+	}
+
+	ihl = (uint32_t) (ip[0] & 0x0F) * 4;
+
+	if (length < ihl + 8) {
+		return;
+	}
+
+	udp = &ip[ihl];
+
+	port = get_be16(&udp[2]);
+
+	if ((port != ARTNET_UDP_PORT) && (port != E131_UDP_PORT)) {
+		return;
+	}
+
+	memcpy(&src, &ip[12], 4);
+
+	// The replies of the node itself are in a capture taken on the node
+	if (src == node_ip) {
+		return;
+	}
+
+	udp_length = get_be16(&udp[4]);
+
+	if ((udp_length < 8) || (udp_length > length - ihl)) {
+		return;
+	}
+
+	udp_length -= 8;
+
+	packets[packets_count].offset = *data_length;
+	packets[packets_count].length = (uint16_t) udp_length;
+	packets[packets_count].ip = src;
+	packets[packets_count].micros = micros;
+	packets_count++;
+
+	memcpy(&data[*data_length], &udp[8], udp_length);
+	*data_length += udp_length;
+}
+
+/**
+ * Read the Art-Net and sACN packets of a pcap file into memory.
+ *
+ * @param file_name
+ * @param ip The IP address of the node, network byte order
+ * @param netmask
+ * @return false when the file cannot be read or has no Art-Net or sACN packets
+ */
+bool replay_open(const char *file_name, const uint32_t ip, const uint32_t netmask) {
+	uint8_t *file;
+	long file_length;
+	uint32_t offset, linktype, data_length = 0;
+	uint64_t first_micros = 0;
+	bool is_swapped, is_nsec;
+	FILE *fp;
+
+	assert(file_name != NULL);
+
+	replay_close();
+
+	node_ip = ip;
+	node_netmask = netmask;
+
+	if ((fp = fopen(file_name, "rb")) == NULL) {
+		perror(file_name);
+		return false;
+	}
+
+	(void) fseek(fp, 0, SEEK_END);
+	file_length = ftell(fp);
+	(void) fseek(fp, 0, SEEK_SET);
+
+	if ((file_length < 24) || ((file = malloc((size_t) file_length)) == NULL)) {
+		fclose(fp);
+		return false;
+	}
+
+	if (fread(file, 1, (size_t) file_length, fp) != (size_t) file_length) {
+		perror(file_name);
+		fclose(fp);
+		free(file);
+		return false;
+	}
+
+	fclose(fp);
+
+	switch (get_u32(file, false)) {
+	case PCAP_MAGIC:
+		is_swapped = false;
+		is_nsec = false;
+		break;
+	case PCAP_MAGIC_NSEC:
+		is_swapped = false;
+		is_nsec = true;
+		break;
+	default:
+		if (get_u32(file, true) == PCAP_MAGIC) {
+			is_swapped = true;
+			is_nsec = false;
+		} else if (get_u32(file, true) == PCAP_MAGIC_NSEC) {
+			is_swapped = true;
+			is_nsec = true;
+		} else {
+			fprintf(stderr, "%s : not a pcap file\n", file_name);
+			free(file);
+			return false;
+		}
+		break;
+	}
+
+	linktype = get_u32(&file[20], is_swapped) & 0xFFFF;
+
+	// Every record has at least 16 bytes of header
+	packets = malloc(sizeof(struct replay_packet) * ((size_t) file_length / 16));
+	data = malloc((size_t) file_length);
+
+	if ((packets == NULL) || (data == NULL)) {
+		free(file);
+		replay_close();
+		return false;
+	}
+
+	for (offset = 24; offset + 16 <= (uint32_t) file_length;) {
+		const uint32_t seconds = get_u32(&file[offset], is_swapped);
+		const uint32_t fraction = get_u32(&file[offset + 4], is_swapped);
+		const uint32_t caplen = get_u32(&file[offset + 8], is_swapped);
+		uint64_t micros;
+
+		offset += 16;
+
+		if (caplen > (uint32_t) file_length - offset) {
+			break;
+		}
+
+		micros = (uint64_t) seconds * 1000000 + (is_nsec ? fraction / 1000 : fraction);
+
+		if (packets_count == 0) {
+			first_micros = micros;
+			start_seconds = (time_t) seconds;
+		}
+
+		add_frame(&file[offset], caplen, linktype, micros - first_micros, &data_length);
+
+		offset += caplen;
+	}
+
+	free(file);
+
+	if (packets_count == 0) {
+		fprintf(stderr, "%s : no Art-Net or sACN packets\n", file_name);
+		replay_close();
+		return false;
+	}
+
+	replay_rewind();
+	loop_micros = 0;
+	now_micros = 0;
+	sent_count = 0;
+
+	return true;
+}
+
+/**
+ *
+ */
+void replay_close(void) {
+	free(packets);
+	free(data);
+	packets = NULL;
+	data = NULL;
+	packets_count = 0;
+	next = 0;
+}
+
+/**
+ * Replay the capture again, the clock continues 1ms after the last packet.
+ */
+void replay_rewind(void) {
+	if (next != 0) {
+		loop_micros += packets[packets_count - 1].micros + 1000;
+	}
+
+	next = 0;
+}
+
+/**
+ * The packet returned by the next udp_recvfrom.
+ *
+ * @param length
+ * @param ip
+ * @return NULL at the end of the capture
+ */
+const uint8_t *replay_peek(uint16_t *length, uint32_t *ip) {
+	if (next >= packets_count) {
+		return NULL;
+	}
+
+	*length = packets[next].length;
+	*ip = packets[next].ip;
+
+	return &data[packets[next].offset];
+}
+
+/**
+ *
+ * @return The number of Art-Net and sACN packets in the capture
+ */
+const uint32_t replay_get_packets(void) {
+	return packets_count;
+}
+
+/**
+ *
+ * @return The capture time of the last packet in microseconds
+ */
+const uint32_t replay_get_duration(void) {
+	return packets_count == 0 ? 0 : (uint32_t) packets[packets_count - 1].micros;
+}
+
+/**
+ *
+ * @return The number of udp_sendto calls
+ */
+const uint32_t replay_get_sent(void) {
+	return sent_count;
+}
+
+/**
+ *
+ * @param mac
+ * @return
+ */
+bool wifi_get_macaddr(uint8_t *mac) {
+	memset(mac, 0, 6);
+	return true;
+}
+
+/**
+ *
+ * @param info
+ * @return
+ */
+bool wifi_get_ip_info(struct ip_info *info) {
+	info->ip.addr = node_ip;
+	info->netmask.addr = node_netmask;
+	info->gw.addr = 0;
+
+	return true;
+}
+
+/**
+ *
+ * @return
+ */
+const bool wifi_is_dhcp_used(void) {
+	return false;
+}
+
+/**
+ *
+ * @param port
+ */
+void udp_begin(const uint16_t port) {
+}
+
+/**
+ *
+ * @param ip_address
+ */
+void udp_joingroup(const uint32_t ip_address) {
+}
+
+/**
+ *
+ * @param buffer
+ * @param length
+ * @param ip_address
+ * @param port
+ * @return 0 at the end of the capture
+ */
+uint16_t udp_recvfrom(const uint8_t *buffer, const uint16_t length, uint32_t *ip_address, uint16_t *port) {
+	const struct replay_packet *p;
+	uint16_t bytes_received;
+
+	assert(buffer != NULL);
+	assert(ip_address != NULL);
+	assert(port != NULL);
+
+	if (next >= packets_count) {
+		*ip_address = 0;
+		*port = 0;
+		return 0;
+	}
+
+	p = &packets[next++];
+
+	bytes_received = p->length < length ? p->length : length;
+	memcpy((uint8_t *) buffer, &data[p->offset], bytes_received);
+
+	*ip_address = p->ip;
+	*port = (uint16_t) ARTNET_UDP_PORT;
+
+	now_micros = loop_micros + p->micros;
+
+	return bytes_received;
+}
+
+/**
+ * Nothing is sent, only counted
+ *
+ * @param buffer
+ * @param length
+ * @param ip_address
+ * @param port
+ */
+void udp_sendto(const uint8_t *buffer, const uint16_t length, const uint32_t ip_address, const uint16_t port) {
+	sent_count++;
+}
+
+/**
+ *
+ */
+void sys_time_init(void) {
+}
+
+/**
+ *
+ * @param tm
+ */
+void sys_time_set(const struct tm *tm) {
+}
+
+/**
+ *
+ * @param t
+ * @return The capture time
+ */
+time_t sys_time(time_t *t) {
+	const time_t seconds = start_seconds + (time_t) (now_micros / 1000000);
+
+	if (t != NULL) {
+		*t = seconds;
+	}
+
+	return seconds;
+}
+
+/**
+ *
+ * @return
+ */
+const uint32_t micros(void) {
+	return (uint32_t) now_micros;
+}
+
+/**
+ *
+ * @return
+ */
+const uint32_t millis(void) {
+	return (uint32_t) (now_micros / 1000);
+}
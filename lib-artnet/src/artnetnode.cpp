@@ -57,8 +57,12 @@
 #include "artnetnode.h"
 #include "packets.h"
 
+#include "e131.h"
+#include "e131validate.h"
+
 #include "lightset.h"
 #include "artnettimecode.h"
+#include "lightsetrdm.h"
 
 #include "blinktask.h"
 
@@ -97,11 +101,25 @@ static const uint8_t DEVICE_MANUFACTURER_ID[] = { 0x7F, 0xF0 };	///< 0x7F, 0xF0
 static const uint8_t DEVICE_SOFTWARE_VERSION[] = {0x01, 0x07 };	///<
 static const uint8_t DEVICE_OEM_VALUE[] = { 0x20, 0xE0 };		///< OemArtRelay , 0x00FF = developer code
 
+static const uint8_t CID_ARTNET[E131_CID_LENGTH] = { 0 };		///< The CID of the Art-Net sources, Art-Net has none
+
 #define ARTNET_MIN_HEADER_SIZE			12						///< \ref TArtPoll \ref TArtSync
 #define ARTNET_MERGE_TIMEOUT_SECONDS	10						///<
+#define ARTNET_SUBSCRIBER_TIMEOUT_SECONDS	10					///< A subscriber is removed when there is no ArtPollReply from it for this time
+#define ARTNET_INPUT_KEEP_ALIVE_MILLIS	1000					///< Default, unchanged DMX data of an input port is sent again after this time
+
+#define ARTNET_POLL_REPLY_INTERVAL_MILLIS	500					///< Default, ArtPoll from the same controller within this time is not answered
+#define ARTNET_POLL_REPLY_DELAY_MILLIS	1000					///< Default, the maximum random delay of the ArtPollReply
+#define ARTNET_NODE_REPORT_COUNT_OFFSET	6						///< "%04x [%04d]" : the decimal counter is at a fixed offset while it has 4 digits
 
 #define PORT_IN_STATUS_DISABLED_MASK	0x08
 
+#define ARTNET_RDM_VERSION				0x01					///< RDM STANDARD V1.0
+#define ARTNET_RDM_START_CODE			0xCC					///< The DMX start code of RDM, not included in ArtRdm
+#define ARTNET_TOD_FULL					0x00					///< ArtTodRequest Command, ArtTodData CommandResponse
+#define ARTNET_TOD_CONTROL_FLUSH		0x01					///< ArtTodControl Command AtcFlush
+#define ARTNET_RDM_PROCESS				0x00					///< ArtRdm Command ArProcess
+
 /**
  *
  */
@@ -109,10 +127,14 @@ static const uint8_t DEVICE_OEM_VALUE[] = { 0x20, 0xE0 };		///< OemArtRelay , 0x
 ArtNetNode::ArtNetNode(CNetSubSystem *pNet, CActLED *pActLED) :
 		m_pNet(pNet),
 		m_Socket(m_pNet, IPPROTO_UDP),
+		m_SocketE131(m_pNet, IPPROTO_UDP),
 		m_IsDHCPUsed(true),
 		m_pLightSet(0),
+		m_pLightSetInput(0),
 		m_pArtNetTimeCode(0),
-		m_bDirectUpdate(false) {
+		m_pLightSetRdm(0),
+		m_bDirectUpdate(false),
+		m_nSyncDeadline(0) {
 
 	m_pBlinkTask = new CBlinkTask (pActLED, 1);
 #else
@@ -120,27 +142,82 @@ ArtNetNode::ArtNetNode(void) :
 		m_pBlinkTask(0),
 		m_IsDHCPUsed(true),
 		m_pLightSet(0),
+		m_pLightSetInput(0),
 		m_pArtNetTimeCode(0),
-		m_bDirectUpdate(false) {
+		m_pLightSetRdm(0),
+		m_bDirectUpdate(false),
+		m_nSyncDeadline(0) {
 
 	m_pBlinkTask = &m_BlinkTask;
 #endif
 	memset(&m_Node, 0, sizeof (struct TArtNetNode));
+	memset(m_PortAddressIndex, ARTNET_PORT_INDEX_NONE, sizeof m_PortAddressIndex);
+	memset(m_ArtNetPackets, 0, sizeof m_ArtNetPackets);
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+	m_pArtNetPacket = &m_ArtNetPackets[ARTNET_NODE_MAX_PORTS];
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		m_OutputPorts[i].pPacket = &m_ArtNetPackets[i];
+		m_OutputPorts[i].pData = m_OutputPorts[i].pPacket->ArtPacket.ArtDmx.Data;
 		m_OutputPorts[i].port.nStatus = (uint8_t) 0;
 		m_OutputPorts[i].port.nPortAddress = (uint16_t) 0;
 		m_OutputPorts[i].port.nDefaultAddress = (uint8_t) 0;
 		m_OutputPorts[i].mergeMode = ARTNET_MERGE_HTP;
+		m_OutputPorts[i].protocol = PORT_PROTOCOL_ARTNET;
 		m_OutputPorts[i].IsDataPending = false;
+		m_OutputPorts[i].nOutputMicros = (uint32_t) 0;
+		m_OutputPorts[i].changed.is_changed = false;
 		m_OutputPorts[i].bIsEnabled = false;
 		m_OutputPorts[i].nLength = (uint16_t) 0;
-		m_OutputPorts[i].ipA = (uint32_t) 0;
-		m_OutputPorts[i].ipB = (uint32_t) 0;
+		m_OutputPorts[i].nSources = (uint8_t) 0;
+
+		for (unsigned j = 0; j < ARTNET_NODE_MAX_SOURCES; j++) {
+			m_OutputPorts[i].sources[j].nIp = (uint32_t) 0;
+			m_OutputPorts[i].sources[j].nBuffer = (uint8_t) ARTNET_MERGE_BUFFER_NONE;
+			m_OutputPorts[i].sources[j].nSequence = (uint8_t) 0;
+		}
 	}
 
+	for (unsigned i = 0; i < ARTNET_NODE_MERGE_BUFFERS; i++) {
+		m_MergeBuffersFree[i] = (uint8_t) i;
+	}
+
+	m_nMergeBuffersFree = (uint8_t) ARTNET_NODE_MERGE_BUFFERS;
+
+	ResetLatency();
+
+	memset(m_InputPorts, 0, sizeof m_InputPorts);
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		m_InputPorts[i].port.nStatus = GI_DISABLED;
+	}
+
+	memset(&m_ArtDmxOut, 0, sizeof(struct TArtDmx));
+	memcpy(m_ArtDmxOut.Id, (const char *)"Art-Net", sizeof m_ArtDmxOut.Id);
+	m_ArtDmxOut.OpCode = OP_DMX;
+	m_ArtDmxOut.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
+
+	memset(&m_ArtTodData, 0, sizeof(struct TArtTodData));
+	memcpy(m_ArtTodData.Id, (const char *)"Art-Net", sizeof m_ArtTodData.Id);
+	m_ArtTodData.OpCode = OP_TODDATA;
+	m_ArtTodData.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
+	m_ArtTodData.RdmVer = ARTNET_RDM_VERSION;
+
+	memset(&m_ArtRdm, 0, sizeof(struct TArtRdm));
+	memcpy(m_ArtRdm.Id, (const char *)"Art-Net", sizeof m_ArtRdm.Id);
+	m_ArtRdm.OpCode = OP_RDM;
+	m_ArtRdm.ProtVerLo = (uint8_t) ARTNET_PROTOCOL_REVISION;
+	m_ArtRdm.RdmVer = ARTNET_RDM_VERSION;
+	m_ArtRdm.Command = ARTNET_RDM_PROCESS;
+
+	m_nInputKeepAlive = (uint32_t) ARTNET_INPUT_KEEP_ALIVE_MILLIS * 1000;
+	m_bInputBroadcast = false;
+
 	m_Node.Status1 = STATUS1_INDICATOR_NORMAL_MODE | STATUS1_PAP_FRONT_PANEL;
 	m_Node.Status2 = STATUS2_DHCP_CAPABLE | STATUS2_PORT_ADDRESS_15BIT;
+#if ARTNET_NODE_SACN
+	m_Node.Status2 = m_Node.Status2 | STATUS2_SACN_ABLE_TO_SWITCH;
+#endif
 
 	m_State.IsSynchronousMode = false;
 	m_State.SendArtDiagData = false;
@@ -152,9 +229,16 @@ ArtNetNode::ArtNetNode(void) :
 	m_State.IsMultipleControllersReqDiag = false;
 	m_State.reportCode = ARTNET_RCPOWEROK;
 	m_State.nActivePorts = 0;
+	m_State.nActiveInputPorts = 0;
+	m_State.IsPollReplyPortsChanged = true;
 	m_State.status = ARTNET_STANDBY;
 
-	m_tOpCodePrevious = OP_NOT_DEFINED;
+	memset(m_PollSources, 0, sizeof m_PollSources);
+	m_nPollReplyInterval = (uint32_t) ARTNET_POLL_REPLY_INTERVAL_MILLIS * 1000;
+	m_nPollReplyDelay = (uint32_t) ARTNET_POLL_REPLY_DELAY_MILLIS * 1000;
+	m_bIsPollReplyPending = false;
+	m_nPollReplyMicros = 0;
+
 
 	SetNetworkDetails();
 
@@ -167,6 +251,13 @@ ArtNetNode::ArtNetNode(void) :
 
 	FillPollReply();
 	FillDiagData();
+
+	// The nodes powered at the same time must not reply at the same time
+	m_nRandom = m_Node.IPAddressLocal ^ ((uint32_t) m_Node.MACAddressLocal[4] << 8) ^ (uint32_t) m_Node.MACAddressLocal[5];
+
+	if (m_nRandom == 0) {
+		m_nRandom = 1;
+	}
 }
 
 /**
@@ -191,6 +282,80 @@ void ArtNetNode::SetOutput(LightSet *pLightSet) {
 	m_pLightSet = pLightSet;
 }
 
+/**
+ * The DMX data for the input ports
+ *
+ * @param pLightSetInput
+ */
+void ArtNetNode::SetInput(LightSetInput *pLightSetInput) {
+	assert(pLightSetInput != 0);
+	m_pLightSetInput = pLightSetInput;
+}
+
+/**
+ * The DMX data of an input port is sent when changed.
+ * Unchanged data is sent again after the keep alive time.
+ *
+ * @param nMillis
+ */
+void ArtNetNode::SetInputKeepAlive(const uint32_t nMillis) {
+	m_nInputKeepAlive = nMillis * 1000;
+}
+
+/**
+ *
+ * @return
+ */
+const uint32_t ArtNetNode::GetInputKeepAlive(void) {
+	return m_nInputKeepAlive / 1000;
+}
+
+/**
+ * By default the ArtDmx of an input port is sent by unicast to the nodes with an output port for the same Port-Address.
+ * These nodes are learned from their ArtPollReply. Without such nodes the ArtDmx is broadcast.
+ *
+ * @param bBroadcast Always broadcast
+ */
+void ArtNetNode::SetInputBroadcast(const bool bBroadcast) {
+	m_bInputBroadcast = bBroadcast;
+}
+
+/**
+ * A controller polling again within this time does not get an ArtPollReply.
+ * A controller sending ArtPoll in a loop cannot keep the node busy.
+ *
+ * @param nMillis Default 500
+ */
+void ArtNetNode::SetPollReplyInterval(const uint32_t nMillis) {
+	m_nPollReplyInterval = nMillis * 1000;
+}
+
+/**
+ *
+ * @return milliseconds
+ */
+const uint32_t ArtNetNode::GetPollReplyInterval(void) {
+	return m_nPollReplyInterval / 1000;
+}
+
+/**
+ * The ArtPollReply is sent after a random delay, so that all the nodes do not reply to a broadcast ArtPoll at the same time.
+ * Art-Net allows a delay up to 1 second.
+ *
+ * @param nMillis Maximum delay, default 1000. 0 is answer right away
+ */
+void ArtNetNode::SetPollReplyDelay(const uint32_t nMillis) {
+	m_nPollReplyDelay = nMillis * 1000;
+}
+
+/**
+ *
+ * @return milliseconds
+ */
+const uint32_t ArtNetNode::GetPollReplyDelay(void) {
+	return m_nPollReplyDelay / 1000;
+}
+
 /**
  *
  * @return
@@ -207,6 +372,51 @@ void ArtNetNode::SetDirectUpdate(bool bDirectUpdate) {
 	m_bDirectUpdate = bDirectUpdate;
 }
 
+/**
+ * In synchronous mode the DMX data waits for an ArtSync.
+ * When an ArtSync is missed, the data is sent anyway after the deadline.
+ *
+ * @param nMicros The deadline in microseconds. 0 is wait for ArtSync
+ */
+void ArtNetNode::SetSyncDeadline(const uint32_t nMicros) {
+	m_nSyncDeadline = nMicros;
+}
+
+/**
+ *
+ * @return
+ */
+const uint32_t ArtNetNode::GetSyncDeadline(void) {
+	return m_nSyncDeadline;
+}
+
+/**
+ *
+ * @return
+ */
+const struct TArtNetLatency *ArtNetNode::GetLatency(void) {
+	return &m_Latency;
+}
+
+/**
+ *
+ */
+void ArtNetNode::ResetLatency(void) {
+	memset(&m_Latency, 0, sizeof(struct TArtNetLatency));
+	m_Latency.nMin = (uint32_t) ~0;
+}
+
+/**
+ *
+ * @param nPortId
+ * @return The time in microseconds of the latest DMX data sent to the LightSet
+ */
+const uint32_t ArtNetNode::GetOutputTime(const uint8_t nPortId) {
+	assert(nPortId < ARTNET_NODE_MAX_PORTS);
+
+	return m_OutputPorts[nPortId].nOutputMicros;
+}
+
 /**
  *
  * @return
@@ -226,14 +436,14 @@ const uint8_t ArtNetNode::GetActiveOutputPorts(void) {
  *
  */
 const uint8_t ArtNetNode::GetActiveInputPorts(void) {
-	return 0;
+	return m_State.nActiveInputPorts;
 }
 
 /**
  *
  */
 void ArtNetNode::Start(void) {
-	assert(m_pLightSet != 0);
+	assert((m_pLightSet != 0) || (m_pLightSetInput != 0));
 
 #if defined (__circle__)
 	if (m_Socket.Bind(NODE_UDP_PORT) < 0) {
@@ -243,18 +453,26 @@ void ArtNetNode::Start(void) {
 		m_Socket.SetOptionBroadcast(TRUE);
 	#endif
 #endif
-		m_PollReply.NumPortsLo = m_State.nActivePorts;
-		for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
-			if (m_OutputPorts[i].bIsEnabled) {
-				m_PollReply.PortTypes[i] = ARTNET_ENABLE_OUTPUT | ARTNET_PORT_DMX;
-			}
-		}
 		m_State.status = ARTNET_ON;
 #if defined (__circle__)
 	}
+
+	if (m_SocketE131.Bind(E131_DEFAULT_PORT) < 0) {
+		CLogger::Get()->Write(FromArtNetNode, LogError, "Cannot bind socket (port %u)", E131_DEFAULT_PORT);
+	}
 #endif
 
-	m_pLightSet->Start();
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		JoinUniverse(i);
+	}
+
+	if (m_pLightSet != 0) {
+		m_pLightSet->Start();
+	}
+
+	if (m_pLightSetInput != 0) {
+		m_pLightSetInput->Start();
+	}
 
 	SendPollRelply(false);	// send a reply on startup
 }
@@ -263,7 +481,14 @@ void ArtNetNode::Start(void) {
  *
  */
 void ArtNetNode::Stop(void) {
-	m_pLightSet->Stop();
+	if (m_pLightSet != 0) {
+		m_pLightSet->Stop();
+	}
+
+	if (m_pLightSetInput != 0) {
+		m_pLightSetInput->Stop();
+	}
+
 	m_pBlinkTask->SetFrequency(0);
 	m_State.status = ARTNET_OFF;
 }
@@ -275,9 +500,9 @@ void ArtNetNode::Stop(void) {
  */
 const uint8_t ArtNetNode::GetUniverseSwitch(const uint8_t nPortId) {
 
-	if (nPortId >= ARTNET_MAX_PORTS) {
+	if (nPortId >= ARTNET_NODE_MAX_PORTS) {
 #if defined (__circle__)
-		CLogger::Get()->Write(FromArtNetNode, LogError, "Port index out of bounds (%d < 0 || %d > ARTNET_MAX_PORTS)", nPortId, nPortId);
+		CLogger::Get()->Write(FromArtNetNode, LogError, "Port index out of bounds (%d < 0 || %d > ARTNET_NODE_MAX_PORTS)", nPortId, nPortId);
 #else
 #endif
 		return ARTNET_EARG;
@@ -295,21 +520,32 @@ const uint8_t ArtNetNode::GetUniverseSwitch(const uint8_t nPortId) {
  */
 int ArtNetNode::SetUniverseSwitch(const uint8_t nPortIndex, const TArtNetPortDir dir, const uint8_t nAddress) {
 
-	if (nPortIndex >= ARTNET_MAX_PORTS) {
+	if (nPortIndex >= ARTNET_NODE_MAX_PORTS) {
 #if defined (__circle__)
-		CLogger::Get()->Write(FromArtNetNode, LogError, "Port index out of bounds (%d < 0 || %d > ARTNET_MAX_PORTS)", nPortIndex, nPortIndex);
+		CLogger::Get()->Write(FromArtNetNode, LogError, "Port index out of bounds (%d < 0 || %d > ARTNET_NODE_MAX_PORTS)", nPortIndex, nPortIndex);
 #else
 #endif
 		return ARTNET_EARG;
 	}
 
 	if (dir == ARTNET_INPUT_PORT) {
-		// Not supported. We have output ports only.
-		return ARTNET_EACTION;
+		if (!m_InputPorts[nPortIndex].bIsEnabled) {
+			m_State.nActiveInputPorts = m_State.nActiveInputPorts + 1;
+			assert(m_State.nActiveInputPorts <= ARTNET_NODE_MAX_PORTS);
+		}
+		m_InputPorts[nPortIndex].bIsEnabled = true;
+		m_InputPorts[nPortIndex].port.nStatus = m_InputPorts[nPortIndex].port.nStatus & ~GI_DISABLED;
+		m_InputPorts[nPortIndex].port.nDefaultAddress = nAddress & (uint16_t)0x0F;		// Universe : Bits 3-0
+		m_InputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t)nAddress, nPortIndex);
+		memset(m_InputPorts[nPortIndex].subscribers, 0, sizeof m_InputPorts[nPortIndex].subscribers);
+		m_InputPorts[nPortIndex].bIsSubscribersFull = false;
+		m_InputPorts[nPortIndex].nSubscribersFullTime = 0;
+		m_State.IsPollReplyPortsChanged = true;
+		return ARTNET_EOK;
 	} else if (dir == ARTNET_OUTPUT_PORT) {
 		if (!m_OutputPorts[nPortIndex].bIsEnabled) {
 			m_State.nActivePorts = m_State.nActivePorts + 1;
-			assert(m_State.nActivePorts <= ARTNET_MAX_PORTS);
+			assert(m_State.nActivePorts <= ARTNET_NODE_MAX_PORTS);
 		}
 		m_OutputPorts[nPortIndex].bIsEnabled = true;
 	} else {
@@ -321,11 +557,68 @@ int ArtNetNode::SetUniverseSwitch(const uint8_t nPortIndex, const TArtNetPortDir
 	}
 
 	m_OutputPorts[nPortIndex].port.nDefaultAddress = nAddress & (uint16_t)0x0F;		// Universe : Bits 3-0
-	m_OutputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t)nAddress);
+	m_OutputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t)nAddress, nPortIndex);
+
+	UpdatePortAddressIndex();
 
 	return ARTNET_EOK;
 }
 
+/**
+ * Select the protocols from which the output port takes its DMX data.
+ * The Port-Address of the port is the sACN universe with the same number, so Port-Address 0 is Art-Net only.
+ *
+ * @param nPortId
+ * @param tProtocol \ref TPortProtocol
+ */
+void ArtNetNode::SetPortProtocol(const uint8_t nPortId, const TPortProtocol tProtocol) {
+	if ((nPortId >= ARTNET_NODE_MAX_PORTS) || (m_OutputPorts[nPortId].protocol == tProtocol)) {
+		return;
+	}
+
+#if !ARTNET_NODE_SACN
+	// sACN is not received, a port switched to it would have no data
+	if (tProtocol & PORT_PROTOCOL_SACN) {
+		return;
+	}
+#endif
+
+	struct TOutputPort *pPort = &m_OutputPorts[nPortId];
+
+	pPort->protocol = tProtocol;
+
+	// The sources are not kept by protocol, so the sources of the port start over
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_SOURCES; i++) {
+		pPort->sources[i].nIp = 0;
+		FreeMergeBuffer(&pPort->sources[i]);
+	}
+
+	pPort->nSources = 0;
+	CheckMergeTimeouts(nPortId);
+
+	if (tProtocol & PORT_PROTOCOL_SACN) {
+		pPort->port.nStatus = pPort->port.nStatus | GO_OUTPUT_IS_SACN;
+		JoinUniverse(nPortId);
+	} else {
+		pPort->port.nStatus = pPort->port.nStatus & ~GO_OUTPUT_IS_SACN;
+	}
+
+	m_State.IsPollReplyPortsChanged = true;
+}
+
+/**
+ *
+ * @param nPortId
+ * @return \ref TPortProtocol
+ */
+const TPortProtocol ArtNetNode::GetPortProtocol(const uint8_t nPortId) {
+	if (nPortId >= ARTNET_NODE_MAX_PORTS) {
+		return PORT_PROTOCOL_ARTNET;
+	}
+
+	return m_OutputPorts[nPortId].protocol;
+}
+
 /**
  *
  * @return
@@ -339,16 +632,31 @@ const uint8_t ArtNetNode::GetSubnetSwitch(void) {
  *
  * The Sub-Net address is between 0 and 15. If the supplied address is larger than 15,
  * the lower 4 bits will be used in setting the address.
+ * Every 16 ports occupy the next Sub-Net, so with more than 16 ports the maximum is \ref ARTNET_NODE_MAX_SUBNET.
  *
  * @param nAddress
+ * @return \ref ARTNET_EARG when the Sub-Net of the last port would wrap, the Sub-Net is not changed
  */
-void ArtNetNode::SetSubnetSwitch(const uint8_t nAddress) {
+int ArtNetNode::SetSubnetSwitch(const uint8_t nAddress) {
+	const uint8_t nSubSwitch = nAddress & (uint8_t) 0x0F;
+
+	if (nSubSwitch > ARTNET_NODE_MAX_SUBNET) {
+#if defined (__circle__)
+		CLogger::Get()->Write(FromArtNetNode, LogError, "Sub-Net %d out of bounds (> %d)", nSubSwitch, ARTNET_NODE_MAX_SUBNET);
+#endif
+		return ARTNET_EARG;
+	}
 
-	m_Node.SubSwitch = nAddress;
+	m_Node.SubSwitch = nSubSwitch;
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress);
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress, i);
+		m_InputPorts[i].port.nPortAddress = MakePortAddress(m_InputPorts[i].port.nPortAddress, i);
 	}
+
+	UpdatePortAddressIndex();
+
+	return ARTNET_EOK;
 }
 
 /**
@@ -366,9 +674,12 @@ const uint8_t ArtNetNode::GetNetSwitch(void) {
 void ArtNetNode::SetNetSwitch(const uint8_t nAddress) {
 	m_Node.NetSwitch = nAddress;
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress);
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress, i);
+		m_InputPorts[i].port.nPortAddress = MakePortAddress(m_InputPorts[i].port.nPortAddress, i);
 	}
+
+	UpdatePortAddressIndex();
 }
 
 /**
@@ -455,19 +766,67 @@ void ArtNetNode::SetNetworkDetails(void) {
 }
 
 /**
+ * Every 16 ports occupy the next Sub-Net. \ref SetSubnetSwitch makes sure that the Sub-Net does not wrap.
  *
  * @param nCurrentAddress
+ * @param nPortIndex
  * @return
  */
-uint16_t ArtNetNode::MakePortAddress(const uint16_t nCurrentAddress) {
+uint16_t ArtNetNode::MakePortAddress(const uint16_t nCurrentAddress, const uint8_t nPortIndex) {
+	const uint8_t nSubSwitch = m_Node.SubSwitch + (nPortIndex / 16);
+
 	// PortAddress Bit 15 = 0
 	uint16_t newAddress = (m_Node.NetSwitch & 0x7F) << 8;	// Net : Bits 14-8
-	newAddress |= (m_Node.SubSwitch & (uint8_t)0x0F) << 4;	// Sub-Net : Bits 7-4
+	newAddress |= (nSubSwitch & (uint8_t)0x0F) << 4;		// Sub-Net : Bits 7-4
 	newAddress |= nCurrentAddress & (uint16_t)0x0F;			// Universe : Bits 3-0
 
 	return newAddress;
 }
 
+/**
+ * All ports share the same Net, so the Sub-Net and Universe (bits 7-0 of the Port-Address)
+ * are sufficient to find the output port. When ports share a Port-Address, the lowest port index is used.
+ */
+void ArtNetNode::UpdatePortAddressIndex(void) {
+	m_State.IsPollReplyPortsChanged = true;
+
+	memset(m_PortAddressIndex, ARTNET_PORT_INDEX_NONE, sizeof m_PortAddressIndex);
+
+	for (unsigned i = ARTNET_NODE_MAX_PORTS; i-- > 0;) {
+		if (m_OutputPorts[i].bIsEnabled) {
+			m_PortAddressIndex[m_OutputPorts[i].port.nPortAddress & 0xFF] = (uint8_t) i;
+		}
+
+		JoinUniverse(i);
+	}
+}
+
+/**
+ * Join the multicast group of the sACN universe of an output port which takes sACN.
+ * 9.3.1 Allocation of Multicast Addresses : 239.255.UHB.ULB
+ *
+ * The UDP layer has no leave, so after a change of the Port-Address the previous group is still joined.
+ * The packets for that universe are dropped by the Port-Address lookup.
+ *
+ * @param nPortId
+ */
+void ArtNetNode::JoinUniverse(const uint8_t nPortId) {
+#if !defined (__circle__)
+	const struct TOutputPort *pPort = &m_OutputPorts[nPortId];
+
+	if ((m_State.status != ARTNET_ON) || !pPort->bIsEnabled || !(pPort->protocol & PORT_PROTOCOL_SACN)) {
+		return;
+	}
+
+	ip.u8[0] = 239;
+	ip.u8[1] = 255;
+	ip.u8[2] = (uint8_t) (pPort->port.nPortAddress >> 8);
+	ip.u8[3] = (uint8_t) (pPort->port.nPortAddress & 0xFF);
+
+	udp_joingroup(ip.u32);
+#endif
+}
+
 /**
  *
  */
@@ -492,14 +851,18 @@ void ArtNetNode::FillPollReply(void) {
 	memcpy (m_PollReply.ShortName, m_Node.ShortName, sizeof m_PollReply.ShortName);
 	memcpy (m_PollReply.LongName, m_Node.LongName, sizeof m_PollReply.LongName);
 
-	// Disable all input
-	for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
-		m_PollReply.GoodInput[i] = PORT_IN_STATUS_DISABLED_MASK;
-	}
-
 	m_PollReply.Style = ARTNET_ST_NODE;
 	memcpy (m_PollReply.MAC, m_Node.MACAddressLocal, sizeof m_PollReply.MAC);
+
+	if (ARTNET_NODE_MAX_PAGES > 1) {
+		memcpy (m_PollReply.BindIp, ip.u8, sizeof m_PollReply.BindIp);
+	}
+
 	m_PollReply.Status2 = m_Node.Status2;
+
+	m_nNodeReportCount = (uint32_t) ~0;	// The NodeReport is cleared, so it must be formatted
+	m_tNodeReportCode = m_State.reportCode;
+	m_State.IsPollReplyPortsChanged = true;
 }
 
 /**
@@ -518,33 +881,39 @@ void ArtNetNode::FillDiagData(void) {
  *
  */
 void ArtNetNode::GetType(void) {
-	char *data = (char *)&(m_ArtNetPacket.ArtPacket);
+	const uint8_t *data = (uint8_t *)&(m_pArtNetPacket->ArtPacket);
 
-	if (m_ArtNetPacket.length < ARTNET_MIN_HEADER_SIZE) {
-		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
+	if (m_pArtNetPacket->length < ARTNET_MIN_HEADER_SIZE) {
+		m_pArtNetPacket->OpCode = OP_NOT_DEFINED;
 	}
 
 	if (memcmp(data, "Art-Net\0", 8) == 0) {
-		m_ArtNetPacket.OpCode = (TOpCodes)((data[9] << 8) + data[8]);
+		m_pArtNetPacket->OpCode = (TOpCodes)((data[9] << 8) + data[8]);
 	} else {
-		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
+		m_pArtNetPacket->OpCode = OP_NOT_DEFINED;
 	}
 }
 
 /**
+ * Art-Net and sACN are handled by the same loop, the content of the packet selects the protocol.
+ * Circle receives sACN on its own socket. Otherwise the UDP layer delivers sACN next to Art-Net when \ref ARTNET_NODE_SACN is set.
  *
  * @return
  */
 int ArtNetNode::HandlePacket(void) {
-	const char *packet = (char *)&(m_ArtNetPacket.ArtPacket);
+	const char *packet = (char *)&(m_pArtNetPacket->ArtPacket);
 
 	uint16_t	nForeignPort;
 #if defined (__circle__)
 	CIPAddress IPAddressFrom;
-	const int nBytesReceived = m_Socket.ReceiveFrom ((void *)packet, sizeof m_ArtNetPacket.ArtPacket, MSG_DONTWAIT, &IPAddressFrom, &nForeignPort);
+	int nBytesReceived = m_Socket.ReceiveFrom ((void *)packet, sizeof m_pArtNetPacket->ArtPacket, MSG_DONTWAIT, &IPAddressFrom, &nForeignPort);
+
+	if (nBytesReceived == 0) {
+		nBytesReceived = m_SocketE131.ReceiveFrom ((void *)packet, sizeof m_pArtNetPacket->ArtPacket, MSG_DONTWAIT, &IPAddressFrom, &nForeignPort);
+	}
 #else
 	uint32_t IPAddressFrom;
-	const int nBytesReceived = udp_recvfrom((const uint8_t *)packet, (const uint16_t)sizeof(m_ArtNetPacket.ArtPacket), &IPAddressFrom, &nForeignPort) ;
+	const int nBytesReceived = udp_recvfrom((const uint8_t *)packet, (const uint16_t)sizeof(m_pArtNetPacket->ArtPacket), &IPAddressFrom, &nForeignPort) ;
 #endif
 
 #if defined (__circle__)
@@ -556,40 +925,55 @@ int ArtNetNode::HandlePacket(void) {
 
 #if defined (__circle__)
 	m_nCurrentPacketTime = CTimer::Get()->GetTime();
+	m_nCurrentPacketMicros = CTimer::Get()->GetClockTicks();
 #else
 	m_nCurrentPacketTime = sys_time(NULL);
+	m_nCurrentPacketMicros = micros();
 #endif
 
+	if (m_State.IsSynchronousMode && (m_nSyncDeadline != 0)) {
+		CheckSyncDeadline();
+	}
+
+	if ((m_State.nActiveInputPorts != 0) && (m_pLightSetInput != 0)) {
+		HandleDmxIn();
+	}
+
+	if (m_pLightSetRdm != 0) {
+		m_pLightSetRdm->Run();
+		HandleRdmResponse();
+		HandleTodChanges();
+	}
+
+	if (m_bIsPollReplyPending && ((int32_t) (m_nCurrentPacketMicros - m_nPollReplyMicros) >= 0)) {
+		m_bIsPollReplyPending = false;
+		SendPollRelply(true);
+	}
+
 	if (nBytesReceived == 0) {
 		return 0;
 	}
 
-	m_ArtNetPacket.length = nBytesReceived;
-	m_ArtNetPacket.IPAddressFrom = IPAddressFrom;
+	m_pArtNetPacket->length = nBytesReceived;
+	m_pArtNetPacket->IPAddressFrom = IPAddressFrom;
 
 	GetType();
 
-	if (m_State.IsSynchronousMode) {
-		if ((m_ArtNetPacket.OpCode == OP_DMX) && (m_tOpCodePrevious == OP_DMX)) {
-			// WiFi UDP : We have missed the OP_SYNC
-			m_State.IsSynchronousMode = false;
-			for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-				m_OutputPorts[i].IsDataPending = false;
-			}
-		} else {
-			if (m_nCurrentPacketTime - m_State.ArtSyncTime >= 4) {
-				m_State.IsSynchronousMode = false;
-#ifdef SENDDIAG
-				SendDiag("Leaving Synchronous Mode", ARTNET_DP_LOW);
-#endif
-			}
-		}
+	// HandleDmx can swap the receive buffer, so keep the OpCode
+	const TOpCodes OpCode = m_pArtNetPacket->OpCode;
+
+	// A missed ArtSync is handled by the deadline, see CheckSyncDeadline
+	if (m_State.IsSynchronousMode && (m_nCurrentPacketTime - m_State.ArtSyncTime >= 4)) {
+		LeaveSynchronousMode();
 	}
 
-	switch (m_ArtNetPacket.OpCode) {
+	switch (OpCode) {
 	case OP_POLL:
 		HandlePoll();
 		break;
+	case OP_POLLREPLY:
+		HandlePollReply();
+		break;
 	case OP_DMX:
 		HandleDmx();
 		break;
@@ -602,6 +986,19 @@ int ArtNetNode::HandlePacket(void) {
 	case OP_TIMECODE:
 		HandleTimeCode();
 		break;
+	case OP_TODREQUEST:
+		HandleTodRequest();
+		break;
+	case OP_TODCONTROL:
+		HandleTodControl();
+		break;
+	case OP_RDM:
+		HandleRdm();
+		break;
+	case OP_NOT_DEFINED:
+		// Not Art-Net, it can be sACN
+		HandleE131();
+		break;
 	default:
 		// ArtNet but OpCode is not implemented
 		// Just skip ... no error
@@ -614,62 +1011,159 @@ int ArtNetNode::HandlePacket(void) {
 		m_State.IsChanged = false;
 	}
 
-	m_tOpCodePrevious = m_ArtNetPacket.OpCode;
-
-	return m_ArtNetPacket.length;
+	return nBytesReceived;
 }
 
 /**
- *
- * @param bResponse
+ * Build the port fields of all the ArtPollReply pages. Page 0 is written into the ArtPollReply as well.
  */
-void ArtNetNode::SendPollRelply(const bool bResponse) {
+void ArtNetNode::UpdatePollReplyPorts(void) {
+	m_State.IsPollReplyPortsChanged = false;
 
-	if (!bResponse && m_State.status == ARTNET_ON) {
-		m_State.ArtPollReplyCount++;
+	for (unsigned nPage = 0; nPage < ARTNET_NODE_MAX_PAGES; nPage++) {
+		struct TPollReplyPorts *pPorts = &m_PollReplyPorts[nPage];
+		uint8_t nActivePorts = 0;
+
+		for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
+			const unsigned nPortIndex = (nPage * ARTNET_MAX_PORTS) + i;
+
+			pPorts->PortTypes[i] = ARTNET_PORT_DMX;
+			pPorts->GoodOutput[i] = 0;
+			pPorts->SwOut[i] = 0;
+			pPorts->GoodInput[i] = PORT_IN_STATUS_DISABLED_MASK;
+			pPorts->SwIn[i] = 0;
+
+			if (nPortIndex >= ARTNET_NODE_MAX_PORTS) {
+				continue;
+			}
+
+			if (m_OutputPorts[nPortIndex].bIsEnabled) {
+				pPorts->PortTypes[i] |= ARTNET_ENABLE_OUTPUT;
+				pPorts->GoodOutput[i] = m_OutputPorts[nPortIndex].port.nStatus;
+				pPorts->SwOut[i] = m_OutputPorts[nPortIndex].port.nDefaultAddress;
+			}
+
+			if (m_InputPorts[nPortIndex].bIsEnabled) {
+				pPorts->PortTypes[i] |= ARTNET_ENABLE_INPUT;
+				pPorts->GoodInput[i] = m_InputPorts[nPortIndex].port.nStatus;
+				pPorts->SwIn[i] = m_InputPorts[nPortIndex].port.nDefaultAddress;
+			}
+
+			if (m_OutputPorts[nPortIndex].bIsEnabled || m_InputPorts[nPortIndex].bIsEnabled) {
+				nActivePorts++;
+			}
+		}
+
+		pPorts->NumPortsLo = nActivePorts;
+		pPorts->SubSwitch = (m_Node.SubSwitch + ((nPage * ARTNET_MAX_PORTS) / 16)) & 0x0F;
 	}
 
-	for (unsigned i = 0 ; i < ARTNET_MAX_PORTS; i++) {
-		m_PollReply.GoodOutput[i] = m_OutputPorts[i].port.nStatus;
-		m_PollReply.SwOut[i] = m_OutputPorts[i].port.nDefaultAddress;
+	m_PollReply.NetSwitch = m_Node.NetSwitch;
+	m_PollReply.NumPortsLo = m_PollReplyPorts[0].NumPortsLo;
+	m_PollReply.SubSwitch = m_PollReplyPorts[0].SubSwitch;
+	memcpy(m_PollReply.PortTypes, m_PollReplyPorts[0].PortTypes, 5 * ARTNET_MAX_PORTS);
+}
+
+/**
+ * The NodeReport is formatted when the report code changes. Otherwise only the digits of the counter are updated.
+ */
+void ArtNetNode::UpdateNodeReport(void) {
+	const uint32_t nCount = m_State.ArtPollReplyCount;
+
+	if ((m_State.reportCode == m_tNodeReportCode) && (nCount < 10000) && (m_nNodeReportCount < 10000)) {
+		uint8_t *pDigits = &m_PollReply.NodeReport[ARTNET_NODE_REPORT_COUNT_OFFSET];
+
+		pDigits[0] = (uint8_t) ('0' + (nCount / 1000));
+		pDigits[1] = (uint8_t) ('0' + ((nCount / 100) % 10));
+		pDigits[2] = (uint8_t) ('0' + ((nCount / 10) % 10));
+		pDigits[3] = (uint8_t) ('0' + (nCount % 10));
+
+		m_nNodeReportCount = nCount;
+		return;
 	}
 
+	m_nNodeReportCount = nCount;
+	m_tNodeReportCode = m_State.reportCode;
+
+	memset(m_PollReply.NodeReport, 0, ARTNET_REPORT_LENGTH);
+
 #if defined (__circle__)
 	CString Report;
 	Report.Format("%04x [%04d] RPi AvV " CIRCLE_NAME " " CIRCLE_VERSION_STRING, m_State.reportCode, m_State.ArtPollReplyCount);
 	strncpy((char *)m_PollReply.NodeReport, (const char *)Report, Report.GetLength() < ARTNET_REPORT_LENGTH ? Report.GetLength() : ARTNET_REPORT_LENGTH); //
-
-	CIPAddress BroadcastIP;
-	BroadcastIP.Set (m_Node.IPAddressBroadcast);
-
-	if ((m_Socket.SendTo((const void *)&(m_PollReply), (unsigned)sizeof (struct TArtPollReply), MSG_DONTWAIT, BroadcastIP, (u16)NODE_UDP_PORT)) != sizeof (struct TArtPollReply)) {
-		CLogger::Get()->Write(FromArtNetNode, LogPanic, "Cannot send");
-	}
 #else
 	char report[ARTNET_REPORT_LENGTH];
 	sprintf(report, "%04x [%04d] RPi AvV", (int)m_State.reportCode, (int)m_State.ArtPollReplyCount);
 	strncpy((char *)m_PollReply.NodeReport, report, strlen(report) < ARTNET_REPORT_LENGTH ? strlen(report) : ARTNET_REPORT_LENGTH);
-	udp_sendto((const uint8_t *)&(m_PollReply), (const uint16_t)sizeof (struct TArtPollReply), m_Node.IPAddressBroadcast, (uint16_t)NODE_UDP_PORT);
 #endif
 }
 
 /**
+ * A node with more than \ref ARTNET_MAX_PORTS ports sends an ArtPollReply for each page of ports.
+ * The ArtPollReply is kept serialized, only the fields which are changed are updated.
  *
- * @param text
- * @param nPriority
+ * @param bResponse
  */
-void ArtNetNode::SendDiag(const char *text, TPriorityCodes nPriority) {
-	if (!m_State.SendArtDiagData) {
-		return;
+void ArtNetNode::SendPollRelply(const bool bResponse) {
+
+	if (!bResponse && m_State.status == ARTNET_ON) {
+		m_State.ArtPollReplyCount++;
 	}
 
-	if (nPriority < m_State.Priority) {
-		return;
+	if ((m_State.reportCode != m_tNodeReportCode) || (m_State.ArtPollReplyCount != m_nNodeReportCount)) {
+		UpdateNodeReport();
 	}
 
-	m_DiagData.Priority = nPriority;
+	if (m_State.IsPollReplyPortsChanged) {
+		UpdatePollReplyPorts();
+	}
 
-	strncpy((char *) m_DiagData.Data, text, sizeof m_DiagData.Data);
+#if defined (__circle__)
+	CIPAddress BroadcastIP;
+	BroadcastIP.Set (m_Node.IPAddressBroadcast);
+#endif
+
+	for (unsigned nPage = 0; nPage < ARTNET_NODE_MAX_PAGES; nPage++) {
+		const struct TPollReplyPorts *pPorts = &m_PollReplyPorts[nPage];
+
+		if ((nPage != 0) && (pPorts->NumPortsLo == 0)) {
+			continue;
+		}
+
+		if (ARTNET_NODE_MAX_PAGES > 1) {
+			m_PollReply.NumPortsLo = pPorts->NumPortsLo;
+			m_PollReply.SubSwitch = pPorts->SubSwitch;
+			memcpy(m_PollReply.PortTypes, pPorts->PortTypes, 5 * ARTNET_MAX_PORTS);
+			m_PollReply.BindIndex = (uint8_t) (nPage + 1);
+		}
+
+#if defined (__circle__)
+		if ((m_Socket.SendTo((const void *)&(m_PollReply), (unsigned)sizeof (struct TArtPollReply), MSG_DONTWAIT, BroadcastIP, (u16)NODE_UDP_PORT)) != sizeof (struct TArtPollReply)) {
+			CLogger::Get()->Write(FromArtNetNode, LogPanic, "Cannot send");
+		}
+#else
+		udp_sendto((const uint8_t *)&(m_PollReply), (const uint16_t)sizeof (struct TArtPollReply), m_Node.IPAddressBroadcast, (uint16_t)NODE_UDP_PORT);
+#endif
+	}
+}
+
+/**
+ *
+ * @param text
+ * @param nPriority
+ */
+void ArtNetNode::SendDiag(const char *text, TPriorityCodes nPriority) {
+	if (!m_State.SendArtDiagData) {
+		return;
+	}
+
+	if (nPriority < m_State.Priority) {
+		return;
+	}
+
+	m_DiagData.Priority = nPriority;
+
+	strncpy((char *) m_DiagData.Data, text, sizeof m_DiagData.Data);
 	m_DiagData.Data[sizeof(m_DiagData.Data) - 1] = '\0';				// Just be sure we have a last '\0'
 	m_DiagData.LengthLo = strlen((const char *) m_DiagData.Data) + 1;	// Text length including the '\0'
 
@@ -694,106 +1188,243 @@ void ArtNetNode::SendDiag(const char *text, TPriorityCodes nPriority) {
  * @return
  */
 bool ArtNetNode::IsDmxDataChanged(const uint8_t nPortId, const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
-
-	uint32_t *src = (uint32_t *)pData;
-	uint32_t *dst = (uint32_t *)m_OutputPorts[nPortId].data;
+	if (m_OutputPorts[nPortId].pData != m_OutputPorts[nPortId].data) {
+		m_OutputPorts[nPortId].pData = m_OutputPorts[nPortId].data;
+		m_OutputPorts[nPortId].nLength = 0;
+	}
 
 	if (nLength != m_OutputPorts[nPortId].nLength) {
 		m_OutputPorts[nPortId].nLength = nLength;
-		for (unsigned i = 0 ; i < ARTNET_DMX_LENGTH / 4; i++) {
-			*dst++ = *src++;
-		}
+		(void) lightset_merge_copy(m_OutputPorts[nPortId].data, pData, nLength, 0);
+		lightset_merge_mark(&m_OutputPorts[nPortId].changed, 0, nLength);
 		return true;
 	}
 
-	for (unsigned i = 0; i < ARTNET_DMX_LENGTH / 4; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
+	return lightset_merge_copy(m_OutputPorts[nPortId].data, pData, nLength, &m_OutputPorts[nPortId].changed);
+}
+
+/**
+ * No merging, so no copy. The received packet becomes the output buffer of the port,
+ * and the previous output buffer of the port is handed back for receiving.
+ *
+ * @param nPortId
+ * @param pData The DMX data in the received packet
+ * @param nLength
+ * @return true when the data differs from the data sent previously
+ */
+bool ArtNetNode::SwapDmxData(const uint8_t nPortId, const uint8_t *pData, const uint16_t nLength) {
+	bool isChanged = (nLength != m_OutputPorts[nPortId].nLength);
+
+	if (!isChanged) {
+		isChanged = lightset_merge_compare(pData, m_OutputPorts[nPortId].pData, nLength, &m_OutputPorts[nPortId].changed);
+	} else {
+		lightset_merge_mark(&m_OutputPorts[nPortId].changed, 0, nLength);
 	}
 
+	struct TArtNetPacket *pPacket = m_OutputPorts[nPortId].pPacket;
+
+	m_OutputPorts[nPortId].pPacket = m_pArtNetPacket;
+	m_OutputPorts[nPortId].pData = (uint8_t *)pData;
+	m_OutputPorts[nPortId].nLength = nLength;
+
+	m_pArtNetPacket = pPacket;
+
 	return isChanged;
 }
 
 /**
- * merge the data from two sources
+ * Hand the data of the port to the LightSet, together with the slots changed since the previous hand over.
+ * Without a changed range (direct update) the full universe is handed over.
+ *
  * @param nPortId
- * @param pData
+ */
+void ArtNetNode::SetLightSetData(const uint8_t nPortId) {
+	struct _lightset_merge_result *pChanged = &m_OutputPorts[nPortId].changed;
+	const uint16_t nLength = m_OutputPorts[nPortId].nLength;
+
+	if (pChanged->is_changed && (pChanged->first_slot < nLength)) {
+		const uint16_t nLast = min(pChanged->last_slot, (uint16_t) (nLength - 1));
+		m_pLightSet->SetDataRange(nPortId, m_OutputPorts[nPortId].pData, nLength, pChanged->first_slot, (nLast - pChanged->first_slot) + 1);
+	} else {
+		m_pLightSet->SetData(nPortId, m_OutputPorts[nPortId].pData, nLength);
+	}
+
+	pChanged->is_changed = false;
+
+#if defined (__circle__)
+	const uint32_t nOutputMicros = CTimer::Get()->GetClockTicks();
+#else
+	const uint32_t nOutputMicros = micros();
+#endif
+	const uint32_t nLatency = nOutputMicros - m_OutputPorts[nPortId].nArrivalMicros;
+
+	m_OutputPorts[nPortId].nOutputMicros = nOutputMicros;
+
+	m_Latency.nCount++;
+	m_Latency.nMin = min(m_Latency.nMin, nLatency);
+	m_Latency.nMax = max(m_Latency.nMax, nLatency);
+
+	const unsigned nBin = (nLatency == 0) ? 0 : (32 - __builtin_clz(nLatency));
+	m_Latency.nBins[min(nBin, (unsigned) (ARTNET_LATENCY_BINS - 1))]++;
+}
+
+/**
+ * No ArtSync is received for 4 seconds, the data waiting for it is sent now.
+ */
+void ArtNetNode::LeaveSynchronousMode(void) {
+	m_State.IsSynchronousMode = false;
+#ifdef SENDDIAG
+	SendDiag("Leaving Synchronous Mode", ARTNET_DP_LOW);
+#endif
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		if (m_OutputPorts[i].IsDataPending) {
+			SetLightSetData(i);
+			m_OutputPorts[i].IsDataPending = false;
+		}
+	}
+}
+
+/**
+ * Send the DMX data which is waiting longer than the deadline for an ArtSync.
+ */
+void ArtNetNode::CheckSyncDeadline(void) {
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		if (m_OutputPorts[i].IsDataPending && ((m_nCurrentPacketMicros - m_OutputPorts[i].nPendingMicros) >= m_nSyncDeadline)) {
+#ifdef SENDDIAG
+			SendDiag("ArtSync missed, send pending data", ARTNET_DP_LOW);
+#endif
+			SetLightSetData(i);
+			m_OutputPorts[i].IsDataPending = false;
+		}
+	}
+}
+
+/**
+ * Merge the data of all the sources of the port
+ * @param nPortId
+ * @param pData The data of the latest source, used for LTP
  * @param nLength
  * @return
  */
 bool ArtNetNode::IsMergedDmxDataChanged(const uint8_t nPortId, const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+	struct TOutputPort *pPort = &m_OutputPorts[nPortId];
 
-	if (!m_State.IsMergeMode) {
+	if (!(pPort->port.nStatus & GO_OUTPUT_IS_MERGING)) {
 		m_State.IsMergeMode = true;
 		m_State.IsChanged = true;
-		uint8_t nStatus = m_OutputPorts[nPortId].port.nStatus;
-		m_OutputPorts[nPortId].port.nStatus = nStatus | (1 << 3);	// Bit 3 : Set – Output is merging ArtNet data.
+		m_State.IsPollReplyPortsChanged = true;
+		pPort->port.nStatus = pPort->port.nStatus | GO_OUTPUT_IS_MERGING;
 	}
 
+	if (pPort->mergeMode == ARTNET_MERGE_HTP) {
+		const uint8_t *pSources[ARTNET_NODE_MAX_SOURCES];
+		unsigned nSources = 0;
 
-	if (m_OutputPorts[nPortId].mergeMode == ARTNET_MERGE_HTP) {
-
-		if (nLength != m_OutputPorts[nPortId].nLength) {
-			m_OutputPorts[nPortId].nLength = nLength;
-			for (unsigned i = 0; i < nLength; i++) {
-				uint8_t data = max(m_OutputPorts[nPortId].dataA[i], m_OutputPorts[nPortId].dataB[i]);
-				m_OutputPorts[nPortId].data[i] = data;
+		for (unsigned i = 0; i < ARTNET_NODE_MAX_SOURCES; i++) {
+			if ((pPort->sources[i].nIp != 0) && (pPort->sources[i].nBuffer != ARTNET_MERGE_BUFFER_NONE)) {
+				pSources[nSources++] = m_MergeBuffers[pPort->sources[i].nBuffer];
 			}
-			return true;
 		}
 
-		for (unsigned i = 0; i < nLength; i++) {
-			uint8_t data = max(m_OutputPorts[nPortId].dataA[i], m_OutputPorts[nPortId].dataB[i]);
-			if (data != m_OutputPorts[nPortId].data[i]) {
-				m_OutputPorts[nPortId].data[i] = data;
-				isChanged = true;
-			}
+		assert(nSources >= 2);
+
+		const uint8_t *pA = pSources[0];
+		const uint8_t *pB = pSources[nSources - 1];
+
+#if ARTNET_NODE_MAX_SOURCES > 2
+		for (unsigned i = 1; i < nSources - 1; i++) {
+			(void) lightset_merge_htp(m_MergeScratch, pA, pSources[i], nLength, 0);
+			pA = m_MergeScratch;
+		}
+#endif
+
+		if (pPort->pData != pPort->data) {
+			pPort->pData = pPort->data;
+			pPort->nLength = 0;
 		}
 
-		return isChanged;
+		if (nLength != pPort->nLength) {
+			pPort->nLength = nLength;
+			(void) lightset_merge_htp(pPort->data, pA, pB, nLength, 0);
+			lightset_merge_mark(&pPort->changed, 0, nLength);
+			return true;
+		}
+
+		return lightset_merge_htp(pPort->data, pA, pB, nLength, &pPort->changed);
 	} else {
 		return IsDmxDataChanged(nPortId, pData, nLength);
 	}
 }
 
 /**
- *
+ * A source which has not sent data for \ref ARTNET_MERGE_TIMEOUT_SECONDS is removed from the port.
+ * The port stops merging when a single source is left.
  */
 void ArtNetNode::CheckMergeTimeouts(const uint8_t nPortId) {
-	const time_t timeOutA = m_nCurrentPacketTime - m_OutputPorts[nPortId].timeA;
-	const time_t timeOutB = m_nCurrentPacketTime - m_OutputPorts[nPortId].timeB;
+	struct TOutputPort *pPort = &m_OutputPorts[nPortId];
 
-	if (timeOutA > (time_t)ARTNET_MERGE_TIMEOUT_SECONDS) {
-		m_OutputPorts[nPortId].ipA = 0;
-		m_State.IsMergeMode = false;
-	}
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_SOURCES; i++) {
+		struct TMergeSource *pSource = &pPort->sources[i];
 
-	if (timeOutB > (time_t)ARTNET_MERGE_TIMEOUT_SECONDS) {
-		m_OutputPorts[nPortId].ipB = 0;
-		m_State.IsMergeMode = false;
+		if ((pSource->nIp != 0) && ((m_nCurrentPacketTime - pSource->nTime) > (time_t)ARTNET_MERGE_TIMEOUT_SECONDS)) {
+			pSource->nIp = 0;
+			FreeMergeBuffer(pSource);
+			pPort->nSources--;
+		}
 	}
 
-	if (!m_State.IsMergeMode) {
+	if ((pPort->nSources <= 1) && (pPort->port.nStatus & GO_OUTPUT_IS_MERGING)) {
 		m_State.IsChanged = true;
-		const uint8_t nStatus = m_OutputPorts[nPortId].port.nStatus;
-		m_OutputPorts[nPortId].port.nStatus = nStatus & ~GO_OUTPUT_IS_MERGING;
+		m_State.IsPollReplyPortsChanged = true;
+		pPort->port.nStatus = pPort->port.nStatus & ~GO_OUTPUT_IS_MERGING;
+
+		m_State.IsMergeMode = false;
+
+		for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+			if (m_OutputPorts[i].port.nStatus & GO_OUTPUT_IS_MERGING) {
+				m_State.IsMergeMode = true;
+				break;
+			}
+		}
 #ifdef SENDDIAG
 		SendDiag("Leaving Merging Mode", ARTNET_DP_LOW);
 #endif
 	}
 }
 
+/**
+ * Take a buffer from the merge buffer arena
+ * @return The buffer index, \ref ARTNET_MERGE_BUFFER_NONE when all buffers are in use
+ */
+uint8_t ArtNetNode::AllocMergeBuffer(void) {
+	if (m_nMergeBuffersFree == 0) {
+		return ARTNET_MERGE_BUFFER_NONE;
+	}
+
+	return m_MergeBuffersFree[--m_nMergeBuffersFree];
+}
+
+/**
+ * Hand the merge buffer of the source back to the arena
+ * @param pSource
+ */
+void ArtNetNode::FreeMergeBuffer(struct TMergeSource *pSource) {
+	if (pSource->nBuffer == ARTNET_MERGE_BUFFER_NONE) {
+		return;
+	}
+
+	assert(m_nMergeBuffersFree < ARTNET_NODE_MERGE_BUFFERS);
+
+	m_MergeBuffersFree[m_nMergeBuffersFree++] = pSource->nBuffer;
+	pSource->nBuffer = ARTNET_MERGE_BUFFER_NONE;
+}
+
 /**
  *
  */
 void ArtNetNode::HandlePoll(void) {
-	const struct TArtPoll *packet = (struct TArtPoll *)&(m_ArtNetPacket.ArtPacket.ArtPoll);
+	const struct TArtPoll *packet = (struct TArtPoll *)&(m_pArtNetPacket->ArtPacket.ArtPoll);
 
 	if (packet->ProtVerLo != (uint8_t) ARTNET_PROTOCOL_REVISION) {
 		return;
@@ -810,8 +1441,8 @@ void ArtNetNode::HandlePoll(void) {
 		m_State.SendArtDiagData = true;
 
 		if (m_State.IPAddressArtPoll == 0) {
-			m_State.IPAddressArtPoll = m_ArtNetPacket.IPAddressFrom;
-		} else if (!m_State.IsMultipleControllersReqDiag && (m_State.IPAddressArtPoll != m_ArtNetPacket.IPAddressFrom)) {
+			m_State.IPAddressArtPoll = m_pArtNetPacket->IPAddressFrom;
+		} else if (!m_State.IsMultipleControllersReqDiag && (m_State.IPAddressArtPoll != m_pArtNetPacket->IPAddressFrom)) {
 			// If there are multiple controllers requesting diagnostics, diagnostics shall be broadcast.
 			m_State.IPAddressDiagSend = m_Node.IPAddressBroadcast;
 			m_State.IsMultipleControllersReqDiag = true;
@@ -826,7 +1457,7 @@ void ArtNetNode::HandlePoll(void) {
 
 		// If there are multiple controllers requesting diagnostics, diagnostics shall be broadcast. (Ignore ArtPoll->TalkToMe->3).
 		if (!m_State.IsMultipleControllersReqDiag && (packet->TalkToMe & TTM_SEND_DIAG_UNICAST)) {
-			m_State.IPAddressDiagSend = m_ArtNetPacket.IPAddressFrom;
+			m_State.IPAddressDiagSend = m_pArtNetPacket->IPAddressFrom;
 		} else {
 			m_State.IPAddressDiagSend = m_Node.IPAddressBroadcast;
 		}
@@ -835,14 +1466,246 @@ void ArtNetNode::HandlePoll(void) {
 		m_State.IPAddressDiagSend = (uint32_t) 0;
 	}
 
-	SendPollRelply(true);
+	if (IsPollThrottled()) {
+		return;
+	}
+
+	if (m_nPollReplyDelay == 0) {
+		SendPollRelply(true);
+		return;
+	}
+
+	// The ArtPollReply is broadcast, so a pending reply answers all the controllers polling meanwhile
+	if (!m_bIsPollReplyPending) {
+		m_bIsPollReplyPending = true;
+		m_nPollReplyMicros = m_nCurrentPacketMicros + (Random() % m_nPollReplyDelay);
+	}
+}
+
+/**
+ * A controller gets at most one ArtPollReply per \ref m_nPollReplyInterval.
+ *
+ * @return true when the ArtPoll is not answered
+ */
+bool ArtNetNode::IsPollThrottled(void) {
+	const uint32_t IPAddressFrom = m_pArtNetPacket->IPAddressFrom;
+	struct TPollSource *pOldest = &m_PollSources[0];
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_POLL_SOURCES; i++) {
+		struct TPollSource *pSource = &m_PollSources[i];
+
+		if (pSource->nIp == IPAddressFrom) {
+			if ((m_nCurrentPacketMicros - pSource->nMicros) < m_nPollReplyInterval) {
+				return true;
+			}
+
+			pSource->nMicros = m_nCurrentPacketMicros;
+			return false;
+		}
+
+		if ((pSource->nIp == 0) || ((m_nCurrentPacketMicros - pSource->nMicros) > (m_nCurrentPacketMicros - pOldest->nMicros))) {
+			pOldest = pSource;
+		}
+	}
+
+	pOldest->nIp = IPAddressFrom;
+	pOldest->nMicros = m_nCurrentPacketMicros;
+
+	return false;
+}
+
+/**
+ * xorshift32
+ *
+ * @return
+ */
+uint32_t ArtNetNode::Random(void) {
+	m_nRandom ^= m_nRandom << 13;
+	m_nRandom ^= m_nRandom >> 17;
+	m_nRandom ^= m_nRandom << 5;
+
+	return m_nRandom;
+}
+
+/**
+ * Learn the nodes with an output port for the Port-Address of an input port.
+ * The ArtDmx of that input port is sent to these nodes by unicast.
+ */
+void ArtNetNode::HandlePollReply(void) {
+	const struct TArtPollReply *packet = (struct TArtPollReply *)&(m_pArtNetPacket->ArtPacket.ArtPollReply);
+	const uint32_t IPAddressFrom = m_pArtNetPacket->IPAddressFrom;
+
+	if ((m_State.nActiveInputPorts == 0) || (IPAddressFrom == m_Node.IPAddressLocal)) {
+		return;
+	}
+
+	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+		if (!(packet->PortTypes[i] & ARTNET_ENABLE_OUTPUT)) {
+			continue;
+		}
+
+		const uint16_t nPortAddress = ((packet->NetSwitch & 0x7F) << 8) | ((packet->SubSwitch & 0x0F) << 4) | (packet->SwOut[i] & 0x0F);
+
+		for (unsigned j = 0; j < ARTNET_NODE_MAX_PORTS; j++) {
+			struct TInputPort *pPort = &m_InputPorts[j];
+
+			if (!pPort->bIsEnabled || (pPort->port.nPortAddress != nPortAddress)) {
+				continue;
+			}
+
+			struct TSubscriber *pFree = 0;
+			unsigned k;
+
+			for (k = 0; k < ARTNET_NODE_MAX_SUBSCRIBERS; k++) {
+				if (pPort->subscribers[k].nIp == IPAddressFrom) {
+					pPort->subscribers[k].nTime = m_nCurrentPacketTime;
+					break;
+				}
+				// An entry which timed out is free again
+				if ((pFree == 0) && ((pPort->subscribers[k].nIp == 0) || ((m_nCurrentPacketTime - pPort->subscribers[k].nTime) > (time_t) ARTNET_SUBSCRIBER_TIMEOUT_SECONDS))) {
+					pFree = &pPort->subscribers[k];
+				}
+			}
+
+			if (k < ARTNET_NODE_MAX_SUBSCRIBERS) {
+				continue;
+			}
+
+			if (pFree != 0) {
+				pFree->nIp = IPAddressFrom;
+				pFree->nTime = m_nCurrentPacketTime;
+			} else {
+				pPort->bIsSubscribersFull = true;
+				pPort->nSubscribersFullTime = m_nCurrentPacketTime;
+			}
+		}
+	}
+}
+
+/**
+ * Send the DMX data of the input ports. Changed data is sent right away,
+ * unchanged data after the keep alive time.
+ */
+void ArtNetNode::HandleDmxIn(void) {
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		struct TInputPort *pPort = &m_InputPorts[i];
+
+		if (!pPort->bIsEnabled) {
+			continue;
+		}
+
+		uint16_t nLength;
+		bool IsChanged;
+
+		const uint8_t *pData = m_pLightSetInput->GetData(i, &nLength, &IsChanged);
+
+		if (pData == 0) {
+			if (pPort->port.nStatus & GI_DATA_RECIEVED) {
+				pPort->port.nStatus = pPort->port.nStatus & ~GI_DATA_RECIEVED;
+				m_State.IsChanged = true;
+				m_State.IsPollReplyPortsChanged = true;
+			}
+			continue;
+		}
+
+		if (!(pPort->port.nStatus & GI_DATA_RECIEVED)) {
+			pPort->port.nStatus = pPort->port.nStatus | GI_DATA_RECIEVED;
+			m_State.IsChanged = true;
+			m_State.IsPollReplyPortsChanged = true;
+		}
+
+		if (IsChanged || ((m_nCurrentPacketMicros - pPort->nMicros) >= m_nInputKeepAlive)) {
+			pPort->nMicros = m_nCurrentPacketMicros;
+			SendDmx(i, pData, nLength);
+		}
+	}
+}
+
+/**
+ *
+ * @param nPortIndex
+ * @param pData
+ * @param nLength
+ */
+void ArtNetNode::SendDmx(const uint8_t nPortIndex, const uint8_t *pData, const uint16_t nLength) {
+	struct TInputPort *pPort = &m_InputPorts[nPortIndex];
+
+	// The length must be an even number in the range 2 – 512
+	const uint16_t nCopyLength = min(nLength, (uint16_t) ARTNET_DMX_LENGTH);
+	const uint16_t nDataLength = max((uint16_t) 2, (uint16_t) ((nCopyLength + 1) & ~1));
+
+	memcpy(m_ArtDmxOut.Data, pData, nCopyLength);
+
+	for (uint16_t i = nCopyLength; i < nDataLength; i++) {
+		m_ArtDmxOut.Data[i] = 0;
+	}
+
+	if (++pPort->nSequence == 0) {
+		pPort->nSequence = 1;
+	}
+
+	m_ArtDmxOut.Sequence = pPort->nSequence;
+	m_ArtDmxOut.Physical = nPortIndex;
+	m_ArtDmxOut.PortAddress = pPort->port.nPortAddress;
+	m_ArtDmxOut.LengthHi = (uint8_t) (nDataLength >> 8);
+	m_ArtDmxOut.Length = (uint8_t) (nDataLength & 0xFF);
+
+	const uint16_t nSize = (uint16_t) (sizeof(struct TArtDmx) - ARTNET_DMX_LENGTH + nDataLength);
+
+	bool IsUnicast = false;
+
+	// Back to unicast when no node was left out of the table for the subscriber timeout
+	if (pPort->bIsSubscribersFull && ((m_nCurrentPacketTime - pPort->nSubscribersFullTime) > (time_t) ARTNET_SUBSCRIBER_TIMEOUT_SECONDS)) {
+		pPort->bIsSubscribersFull = false;
+	}
+
+	if (!m_bInputBroadcast && !pPort->bIsSubscribersFull) {
+		for (unsigned i = 0; i < ARTNET_NODE_MAX_SUBSCRIBERS; i++) {
+			struct TSubscriber *pSubscriber = &pPort->subscribers[i];
+
+			if (pSubscriber->nIp == 0) {
+				continue;
+			}
+
+			if ((m_nCurrentPacketTime - pSubscriber->nTime) > (time_t) ARTNET_SUBSCRIBER_TIMEOUT_SECONDS) {
+				pSubscriber->nIp = 0;
+				continue;
+			}
+#if defined (__circle__)
+			CIPAddress IPAddressTo;
+			IPAddressTo.Set(pSubscriber->nIp);
+
+			if ((m_Socket.SendTo((const void *)&(m_ArtDmxOut), nSize, MSG_DONTWAIT, IPAddressTo, (u16)NODE_UDP_PORT)) != (int)nSize) {
+				CLogger::Get()->Write(FromArtNetNode, LogError, "Cannot send");
+			}
+#else
+			udp_sendto((const uint8_t *)&(m_ArtDmxOut), nSize, pSubscriber->nIp, (uint16_t)NODE_UDP_PORT);
+#endif
+			IsUnicast = true;
+		}
+	}
+
+	if (IsUnicast) {
+		return;
+	}
+
+#if defined (__circle__)
+	CIPAddress BroadcastIP;
+	BroadcastIP.Set(m_Node.IPAddressBroadcast);
+
+	if ((m_Socket.SendTo((const void *)&(m_ArtDmxOut), nSize, MSG_DONTWAIT, BroadcastIP, (u16)NODE_UDP_PORT)) != (int)nSize) {
+		CLogger::Get()->Write(FromArtNetNode, LogError, "Cannot send");
+	}
+#else
+	udp_sendto((const uint8_t *)&(m_ArtDmxOut), nSize, m_Node.IPAddressBroadcast, (uint16_t)NODE_UDP_PORT);
+#endif
 }
 
 /**
  *
  */
 void ArtNetNode::HandleDmx(void) {
-	const struct TArtDmx *packet = (struct TArtDmx *)&(m_ArtNetPacket.ArtPacket.ArtDmx);
+	const struct TArtDmx *packet = (struct TArtDmx *)&(m_pArtNetPacket->ArtPacket.ArtDmx);
 
 	if (packet->ProtVerLo != (uint8_t) ARTNET_PROTOCOL_REVISION) {
 		return;
@@ -851,110 +1714,260 @@ void ArtNetNode::HandleDmx(void) {
 	unsigned data_length = (unsigned) bytes_to_short(packet->LengthHi, packet->Length);
 	data_length = min(data_length, ARTNET_DMX_LENGTH);
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
-		if ((packet->PortAddress == m_OutputPorts[i].port.nPortAddress) &&  m_OutputPorts[i].bIsEnabled) {
-			uint32_t ipA = m_OutputPorts[i].ipA;
-			uint32_t ipB = m_OutputPorts[i].ipB;
+	if ((packet->PortAddress >> 8) != (m_Node.NetSwitch & 0x7F)) {
+		return;
+	}
+
+	const uint8_t i = m_PortAddressIndex[packet->PortAddress & 0xFF];
+
+	if ((i == ARTNET_PORT_INDEX_NONE) || !(m_OutputPorts[i].protocol & PORT_PROTOCOL_ARTNET)) {
+		return;
+	}
+
+	(void) MergeDmx(i, packet->Data, CID_ARTNET, (uint16_t) data_length);
+}
+
+/**
+ * Handle a sACN data packet. The sACN universe is the Port-Address with the same number.
+ * The sACN sources are merged with the Art-Net sources of the port, by the merge mode of the port.
+ */
+void ArtNetNode::HandleE131(void) {
+	if (e131_validate((const uint8_t *) &(m_pArtNetPacket->ArtPacket), (uint16_t) m_pArtNetPacket->length, &m_E131View) != E131_PACKET_DATA) {
+		return;
+	}
 
-			bool sendNewData = false;
+	// Only the levels. The preview data shall not be used to generate live output.
+	if ((m_E131View.nStartCode != (uint8_t) E131_START_CODE_DMX) || (m_E131View.nOptions & E131_OPTIONS_MASK_PREVIEW_DATA)) {
+		return;
+	}
 
-			m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus |GO_DATA_IS_BEING_TRANSMITTED;
+	// Universes above the 15 bit Port-Address do not match the Net
+	if ((m_E131View.nUniverse >> 8) != (m_Node.NetSwitch & 0x7F)) {
+		return;
+	}
+
+	const uint8_t i = m_PortAddressIndex[m_E131View.nUniverse & 0xFF];
+
+	if ((i == ARTNET_PORT_INDEX_NONE) || !(m_OutputPorts[i].protocol & PORT_PROTOCOL_SACN)) {
+		return;
+	}
+
+	struct TOutputPort *pPort = &m_OutputPorts[i];
+	struct TMergeSource *pSource = 0;
+
+	// 6.2.2 Sources are identified by their CID, as sources can share an IP address
+	for (unsigned j = 0; j < ARTNET_NODE_MAX_SOURCES; j++) {
+		if ((pPort->sources[j].nIp == m_pArtNetPacket->IPAddressFrom) && (memcmp(pPort->sources[j].Cid, m_E131View.pCid, E131_CID_LENGTH) == 0)) {
+			pSource = &pPort->sources[j];
+			break;
+		}
+	}
+
+	if (pSource != 0) {
+		// 6.9.2 Sequence Numbering
+		const int8_t diff = (int8_t) (m_E131View.nSequence - pSource->nSequence);
+
+		if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
+			return;
+		}
+	}
 
-			if (m_State.IsMergeMode) {
-				CheckMergeTimeouts(i);
+	// The source has stopped, so it leaves the merge right away instead of timing out
+	if (m_E131View.nOptions & E131_OPTIONS_MASK_STREAM_TERMINATED) {
+		if (pSource != 0) {
+			RemoveSource(i, pSource);
+		}
+		return;
+	}
+
+	pSource = MergeDmx(i, m_E131View.pData, m_E131View.pCid, m_E131View.nSlots);
+
+	if (pSource != 0) {
+		pSource->nSequence = m_E131View.nSequence;
+	}
+}
+
+/**
+ * The source leaves the port, and the output is the merge of the sources left.
+ * Without a source left the output is blanked, its levels are not held.
+ *
+ * @param i The output port
+ * @param pSource
+ */
+void ArtNetNode::RemoveSource(const uint8_t i, struct TMergeSource *pSource) {
+	struct TOutputPort *pPort = &m_OutputPorts[i];
+	bool isChanged;
+
+	pSource->nIp = 0;
+	FreeMergeBuffer(pSource);
+	pPort->nSources--;
+
+	if (pPort->nSources == 0) {
+		isChanged = (pPort->nLength != 0);
+		memset(pPort->pData, 0, pPort->nLength);
+		lightset_merge_mark(&pPort->changed, 0, pPort->nLength);
+	} else if ((pPort->nSources == 1) || (pPort->mergeMode == ARTNET_MERGE_LTP)) {
+		// The port was merging, so the sources left have their latest data in a buffer. LTP takes the latest source.
+		const struct TMergeSource *pLatest = 0;
+
+		for (unsigned j = 0; j < ARTNET_NODE_MAX_SOURCES; j++) {
+			if ((pPort->sources[j].nIp != 0) && ((pLatest == 0) || (pPort->sources[j].nTime > pLatest->nTime))) {
+				pLatest = &pPort->sources[j];
 			}
+		}
 
-			if (ipA == 0 && ipB == 0) {
-#ifdef SENDDIAG
-				SendDiag("1. first packet recv on this port", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
+		assert(pLatest->nBuffer != ARTNET_MERGE_BUFFER_NONE);
+		isChanged = IsDmxDataChanged(i, m_MergeBuffers[pLatest->nBuffer], pPort->nLength);
+	} else {
+		isChanged = IsMergedDmxDataChanged(i, 0, pPort->nLength);
+	}
 
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == 0) {
-#ifdef SENDDIAG
-				SendDiag("2. continued transmission from the same ip (source A)", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
+	CheckMergeTimeouts(i);
 
-			} else if (ipA == 0 && ipB == m_ArtNetPacket.IPAddressFrom) {
-#ifdef SENDDIAG
-				SendDiag("3. continued transmission from the same ip (source B)", ARTNET_DP_LOW);
-#endif
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
+	if (isChanged) {
+		UpdateOutput(i);
+	}
+}
 
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == 0) {
+/**
+ * The data of the port is sent, or is pending until the ArtSync in synchronous mode.
+ *
+ * @param i The output port
+ */
+void ArtNetNode::UpdateOutput(const uint8_t i) {
+	struct TOutputPort *pPort = &m_OutputPorts[i];
+
+	pPort->nArrivalMicros = m_nCurrentPacketMicros;
+
+	if (!m_State.IsSynchronousMode) {
 #ifdef SENDDIAG
-				SendDiag("4. new source, start the merge", ARTNET_DP_LOW);
+		SendDiag("Send new data", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].ipB = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
-
-			} else if (ipA == 0 && ipB != m_ArtNetPacket.IPAddressFrom) {
+		SetLightSetData(i);
+	} else {
 #ifdef SENDDIAG
-				SendDiag("5. new source, start the merge", ARTNET_DP_LOW);
+		SendDiag("DMX data pending", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
+		if (!pPort->IsDataPending) {
+			pPort->nPendingMicros = m_nCurrentPacketMicros;
+			pPort->IsDataPending = true;
+		}
+	}
+}
+
+/**
+ * The DMX data of a source for an output port, from Art-Net or sACN.
+ * The sources are kept by IP address and CID, and merged when there is more than one.
+ *
+ * @param i The output port
+ * @param pData The DMX data in the received packet
+ * @param pCid The CID of a sACN source, \ref CID_ARTNET for Art-Net
+ * @param data_length
+ * @return The source, 0 when the data is discarded
+ */
+struct TMergeSource *ArtNetNode::MergeDmx(const uint8_t i, const uint8_t *pData, const uint8_t *pCid, const uint16_t data_length) {
+	const uint32_t IPAddressFrom = m_pArtNetPacket->IPAddressFrom;
+	struct TOutputPort *pPort = &m_OutputPorts[i];
+
+	bool sendNewData = false;
+
+	if (!(pPort->port.nStatus & GO_DATA_IS_BEING_TRANSMITTED)) {
+		pPort->port.nStatus = pPort->port.nStatus | GO_DATA_IS_BEING_TRANSMITTED;
+		m_State.IsPollReplyPortsChanged = true;
+	}
+
+	if (pPort->nSources > 1) {
+		CheckMergeTimeouts(i);
+	}
+
+	struct TMergeSource *pSource = 0;
+	struct TMergeSource *pFree = 0;
+
+	for (unsigned j = 0; j < ARTNET_NODE_MAX_SOURCES; j++) {
+		if ((pPort->sources[j].nIp == IPAddressFrom) && (memcmp(pPort->sources[j].Cid, pCid, E131_CID_LENGTH) == 0)) {
+			pSource = &pPort->sources[j];
+			break;
+		}
+		if ((pFree == 0) && (pPort->sources[j].nIp == 0)) {
+			pFree = &pPort->sources[j];
+		}
+	}
+
+	if (pSource != 0) {
+		pSource->nTime = m_nCurrentPacketTime;
 
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
+		if (pPort->nSources == 1) {
 #ifdef SENDDIAG
-				SendDiag("6. continue merge", ARTNET_DP_LOW);
+			SendDiag("2. continued transmission from the same ip", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
-
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
+			FreeMergeBuffer(pSource);
+			sendNewData = SwapDmxData(i, pData, data_length);
+		} else {
 #ifdef SENDDIAG
-				SendDiag("7. continue merge", ARTNET_DP_LOW);
+			SendDiag("3. continue merge", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
-
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
-				SendDiag("8. Source matches both buffers, this shouldn't be happening!", ARTNET_DP_LOW);
-				return;
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
-				SendDiag("9. More than two sources, discarding data", ARTNET_DP_LOW);
-				return;
-			} else {
-				SendDiag("0. No cases matched, this shouldn't happen!", ARTNET_DP_LOW);
-				return;
-			}
+			uint8_t *pBuffer = m_MergeBuffers[pSource->nBuffer];
+			memcpy(pBuffer, pData, data_length);
+			sendNewData = IsMergedDmxDataChanged(i, pBuffer, data_length);
+		}
 
-			if (sendNewData || m_bDirectUpdate) {
-				if (!m_State.IsSynchronousMode) {
+	} else if (pPort->nSources == 0) {
 #ifdef SENDDIAG
-					SendDiag("Send new data", ARTNET_DP_LOW);
+		SendDiag("1. first packet recv on this port", ARTNET_DP_LOW);
 #endif
-					m_pLightSet->SetData(i, m_OutputPorts[i].data, m_OutputPorts[i].nLength);
-				} else {
+		pFree->nIp = IPAddressFrom;
+		memcpy(pFree->Cid, pCid, E131_CID_LENGTH);
+		pFree->nTime = m_nCurrentPacketTime;
+		pPort->nSources = 1;
+		sendNewData = SwapDmxData(i, pData, data_length);
+
+	} else if (pFree == 0) {
+		SendDiag("9. More than ARTNET_NODE_MAX_SOURCES sources, discarding data", ARTNET_DP_LOW);
+		return 0;
+
+	} else {
 #ifdef SENDDIAG
-					SendDiag("DMX data pending", ARTNET_DP_LOW);
+		SendDiag("4. new source, start or join the merge", ARTNET_DP_LOW);
 #endif
-					m_OutputPorts[i].IsDataPending = true;
+		if (pPort->nSources == 1) {
+			// The single source so far has no buffer, its latest data is the data sent.
+			for (unsigned j = 0; j < ARTNET_NODE_MAX_SOURCES; j++) {
+				struct TMergeSource *pFirst = &pPort->sources[j];
+
+				if ((pFirst->nIp != 0) && (pFirst->nBuffer == ARTNET_MERGE_BUFFER_NONE)) {
+					if ((pFirst->nBuffer = AllocMergeBuffer()) == ARTNET_MERGE_BUFFER_NONE) {
+						SendDiag("9. No merge buffer available, discarding data", ARTNET_DP_LOW);
+						return 0;
+					}
+					memcpy(m_MergeBuffers[pFirst->nBuffer], pPort->pData, pPort->nLength);
 				}
-			} else {
-#ifdef SENDDIAG
-				SendDiag("Data not changed", ARTNET_DP_LOW);
-#endif
 			}
-			// Discontinue the loop. No need to return for other ports
-			return;
 		}
+
+		if ((pFree->nBuffer = AllocMergeBuffer()) == ARTNET_MERGE_BUFFER_NONE) {
+			SendDiag("9. No merge buffer available, discarding data", ARTNET_DP_LOW);
+			return 0;
+		}
+
+		pFree->nIp = IPAddressFrom;
+		memcpy(pFree->Cid, pCid, E131_CID_LENGTH);
+		pFree->nTime = m_nCurrentPacketTime;
+		pPort->nSources++;
+
+		uint8_t *pBuffer = m_MergeBuffers[pFree->nBuffer];
+		memcpy(pBuffer, pData, data_length);
+		sendNewData = IsMergedDmxDataChanged(i, pBuffer, data_length);
+	}
+
+	if (sendNewData || m_bDirectUpdate) {
+		UpdateOutput(i);
+	} else {
+#ifdef SENDDIAG
+		SendDiag("Data not changed", ARTNET_DP_LOW);
+#endif
 	}
+
+	return (pSource != 0) ? pSource : pFree;
 }
 
 /**
@@ -967,9 +1980,9 @@ void ArtNetNode::HandleDmx(void) {
  * a node shall time out to non-synchronous operation if an ArtSync is not received for 4 seconds or more.
  */
 void ArtNetNode::HandleSync(void) {
-	const struct TArtSync *packet = (struct TArtSync*)&(m_ArtNetPacket.ArtPacket.ArtSync);
+	const struct TArtSync *packet = (struct TArtSync*)&(m_pArtNetPacket->ArtPacket.ArtSync);
 
-	if (packet->ProtVerLo != (uint8_t) ARTNET_PROTOCOL_REVISION) {
+	if ((packet->ProtVerLo != (uint8_t) ARTNET_PROTOCOL_REVISION) || (m_pLightSet == 0)) {
 		return;
 	}
 
@@ -979,22 +1992,26 @@ void ArtNetNode::HandleSync(void) {
 #else
 	m_State.ArtSyncTime = sys_time(NULL);
 #endif
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+	m_pLightSet->BeginUpdate();
+
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
 		if (m_OutputPorts[i].IsDataPending) {
 #ifdef SENDDIAG
 			SendDiag("Send pending data", ARTNET_DP_LOW);
 #endif
-			m_pLightSet->SetData(i, m_OutputPorts[i].data, 	m_OutputPorts[i].nLength);
+			SetLightSetData(i);
 			m_OutputPorts[i].IsDataPending = false;
 		}
 	}
+
+	m_pLightSet->EndUpdate();
 }
 
 /**
  * A Controller or monitoring device on the network can reprogram numerous controls of a node remotely.
  */
 void ArtNetNode::HandleAddress(void) {
-	const struct TArtAddress *packet = (struct TArtAddress *) &(m_ArtNetPacket.ArtPacket.ArtAddress);
+	const struct TArtAddress *packet = (struct TArtAddress *) &(m_pArtNetPacket->ArtPacket.ArtAddress);
 
 	if (packet->ProtVerLo != (uint8_t) ARTNET_PROTOCOL_REVISION) {
 		return;
@@ -1018,10 +2035,17 @@ void ArtNetNode::HandleAddress(void) {
 		m_State.reportCode = ARTNET_RCLONAMEOK;
 	}
 
+	// The ports of the page, BindIndex 0 (no binding) is the root device. A page which does not exist programs no ports.
+	const unsigned nPage = (packet->BindIndex == 0) ? 0 : (unsigned) (packet->BindIndex - 1);
+	const bool bIsPageValid = (nPage < (unsigned) ARTNET_NODE_MAX_PAGES);
+
+	// The ArtPollReply of the page reports the Sub-Net of its ports
+	const uint8_t nPageSubSwitch = (uint8_t) ((nPage * ARTNET_MAX_PORTS) / 16);
+
 	if (packet->SubSwitch == PROGRAM_DEFAULTS) {
 		SetSubnetSwitch(NODE_DEFAULT_SUBNET_SWITCH);
-	} else if (packet->SubSwitch & PROGRAM_CHANGE_MASK) {
-		SetSubnetSwitch(packet->SubSwitch & ~PROGRAM_CHANGE_MASK);
+	} else if (bIsPageValid && (packet->SubSwitch & PROGRAM_CHANGE_MASK) && ((packet->SubSwitch & 0x0F) >= nPageSubSwitch)) {
+		SetSubnetSwitch((packet->SubSwitch & 0x0F) - nPageSubSwitch);
 	}
 
 	if (packet->NetSwitch == PROGRAM_DEFAULTS) {
@@ -1030,20 +2054,42 @@ void ArtNetNode::HandleAddress(void) {
 		SetNetSwitch(packet->NetSwitch & ~PROGRAM_CHANGE_MASK);
 	}
 
-	for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+	const unsigned nPortFirst = nPage * ARTNET_MAX_PORTS;
+	const unsigned nPorts = bIsPageValid ? min((unsigned) ARTNET_MAX_PORTS, (unsigned) ARTNET_NODE_MAX_PORTS - nPortFirst) : 0;
+
+	for (unsigned i = 0; i < nPorts; i++) {
+		const uint8_t nPortIndex = (uint8_t) (nPortFirst + i);
+
 		if (packet->SwOut[i] == PROGRAM_NO_CHANGE) {
 			continue;
 		} else if (packet->SwOut[i] == PROGRAM_DEFAULTS) {
-			SetUniverseSwitch(i, ARTNET_OUTPUT_PORT, NODE_DEFAULT_UNIVERSE);
+			SetUniverseSwitch(nPortIndex, ARTNET_OUTPUT_PORT, NODE_DEFAULT_UNIVERSE);
 		} else if (packet->SwOut[i] & PROGRAM_CHANGE_MASK) {
-			SetUniverseSwitch(i, ARTNET_OUTPUT_PORT, packet->SwOut[i] & ~PROGRAM_CHANGE_MASK);
+			SetUniverseSwitch(nPortIndex, ARTNET_OUTPUT_PORT, packet->SwOut[i] & ~PROGRAM_CHANGE_MASK);
+		}
+	}
+
+	for (unsigned i = 0; i < nPorts; i++) {
+		const uint8_t nPortIndex = (uint8_t) (nPortFirst + i);
+
+		if (!m_InputPorts[nPortIndex].bIsEnabled || (packet->SwIn[i] == PROGRAM_NO_CHANGE)) {
+			continue;
+		} else if (packet->SwIn[i] == PROGRAM_DEFAULTS) {
+			SetUniverseSwitch(nPortIndex, ARTNET_INPUT_PORT, NODE_DEFAULT_UNIVERSE);
+		} else if (packet->SwIn[i] & PROGRAM_CHANGE_MASK) {
+			SetUniverseSwitch(nPortIndex, ARTNET_INPUT_PORT, packet->SwIn[i] & ~PROGRAM_CHANGE_MASK);
 		}
 	}
+
+	// The port commands address port (Command & 0x03) of the page, as SwOut and SwIn do
+	const uint8_t nCommandPort = (uint8_t) (nPortFirst + (packet->Command & 0x03));
+	const bool bIsCommandPortValid = bIsPageValid && (nCommandPort < ARTNET_NODE_MAX_PORTS);
+
 	switch (packet->Command) {
 	case ARTNET_PC_CANCEL:
 		// If Node is currently in merge mode, cancel merge mode upon receipt of next ArtDmx packet.
 		m_State.IsMergeMode = false;
-		for (unsigned i = 0; i < ARTNET_MAX_PORTS; i++) {
+		for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
 			m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus & ~GO_OUTPUT_IS_MERGING;
 		}
 #ifdef SENDDIAG
@@ -1060,89 +2106,60 @@ void ArtNetNode::HandleAddress(void) {
 		m_pBlinkTask->SetFrequency(3);
 		break;
 	case ARTNET_PC_MERGE_LTP_O:
-		m_OutputPorts[0].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[0].port.nStatus = m_OutputPorts[0].port.nStatus | GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_0", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_LTP_1:
-		m_OutputPorts[1].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[1].port.nStatus = m_OutputPorts[1].port.nStatus | GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_1", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_LTP_2:
-		m_OutputPorts[2].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[2].port.nStatus = m_OutputPorts[2].port.nStatus | GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_2", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_LTP_3:
-		m_OutputPorts[3].mergeMode = ARTNET_MERGE_LTP;
-		m_OutputPorts[3].port.nStatus = m_OutputPorts[3].port.nStatus | GO_MERGE_MODE_LTP;
+		if (bIsCommandPortValid) {
+			m_OutputPorts[nCommandPort].mergeMode = ARTNET_MERGE_LTP;
+			m_OutputPorts[nCommandPort].port.nStatus = m_OutputPorts[nCommandPort].port.nStatus | GO_MERGE_MODE_LTP;
 #ifdef SENDDIAG
-		SendDiag("Setting Merge Mode LTP_1", ARTNET_DP_LOW);
+			SendDiag("Setting Merge Mode LTP", ARTNET_DP_LOW);
 #endif
+		}
 		break;
 	case ARTNET_PC_MERGE_HTP_0:
-		m_OutputPorts[0].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[0].port.nStatus = m_OutputPorts[0].port.nStatus & ~GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_0", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_HTP_1:
-		m_OutputPorts[1].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[1].port.nStatus = m_OutputPorts[1].port.nStatus & ~GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_1", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_HTP_2:
-		m_OutputPorts[2].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[2].port.nStatus = m_OutputPorts[2].port.nStatus & ~GO_MERGE_MODE_LTP;
-#ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_2", ARTNET_DP_LOW);
-#endif
-		break;
 	case ARTNET_PC_MERGE_HTP_3:
-		m_OutputPorts[3].mergeMode = ARTNET_MERGE_HTP;
-		m_OutputPorts[3].port.nStatus = m_OutputPorts[3].port.nStatus & ~GO_MERGE_MODE_LTP;
+		if (bIsCommandPortValid) {
+			m_OutputPorts[nCommandPort].mergeMode = ARTNET_MERGE_HTP;
+			m_OutputPorts[nCommandPort].port.nStatus = m_OutputPorts[nCommandPort].port.nStatus & ~GO_MERGE_MODE_LTP;
 #ifdef SENDDIAG
-		SendDiag("Setting Merge Mode HTP_3", ARTNET_DP_LOW);
+			SendDiag("Setting Merge Mode HTP", ARTNET_DP_LOW);
 #endif
-		break;
-	case ARTNET_PC_CLR_0:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[0].data[i] = 0;
 		}
-		m_pLightSet->SetData (0, m_OutputPorts[0].data, m_OutputPorts[0].nLength);
 		break;
-	case ARTNET_PC_CLR_1:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[1].data[i] = 0;
+	case ARTNET_PC_ARTNET_SEL_0:
+	case ARTNET_PC_ARTNET_SEL_1:
+	case ARTNET_PC_ARTNET_SEL_2:
+	case ARTNET_PC_ARTNET_SEL_3:
+		if (bIsCommandPortValid) {
+			SetPortProtocol(nCommandPort, PORT_PROTOCOL_ARTNET);
 		}
-		m_pLightSet->SetData (1, m_OutputPorts[1].data, m_OutputPorts[1].nLength);
 		break;
-	case ARTNET_PC_CLR_2:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[2].data[i] = 0;
+	case ARTNET_PC_ACN_SEL_0:
+	case ARTNET_PC_ACN_SEL_1:
+	case ARTNET_PC_ACN_SEL_2:
+	case ARTNET_PC_ACN_SEL_3:
+		if (bIsCommandPortValid) {
+			SetPortProtocol(nCommandPort, PORT_PROTOCOL_SACN);
 		}
-		m_pLightSet->SetData (2, m_OutputPorts[2].data, m_OutputPorts[2].nLength);
 		break;
+	case ARTNET_PC_CLR_0:
+	case ARTNET_PC_CLR_1:
+	case ARTNET_PC_CLR_2:
 	case ARTNET_PC_CLR_3:
-		for (unsigned i = 0; i < ARTNET_DMX_LENGTH; i++) {
-			m_OutputPorts[3].data[i] = 0;
+		if (bIsCommandPortValid && (m_pLightSet != 0)) {
+			memset(m_OutputPorts[nCommandPort].pData, 0, ARTNET_DMX_LENGTH);
+			m_pLightSet->SetData(nCommandPort, m_OutputPorts[nCommandPort].pData, m_OutputPorts[nCommandPort].nLength);
 		}
-		m_pLightSet->SetData (3, m_OutputPorts[3].data, m_OutputPorts[3].nLength);
 		break;
 	default:
 		break;
 	}
 
+	m_State.IsPollReplyPortsChanged = true;
+
 	SendPollRelply(true);
 }
 
@@ -1150,7 +2167,7 @@ void ArtNetNode::HandleAddress(void) {
  *
  */
 void ArtNetNode::HandleTimeCode(void) {
-	const struct TArtTimeCode *packet = (struct TArtTimeCode *) &(m_ArtNetPacket.ArtPacket.ArtTimeCode);
+	const struct TArtTimeCode *packet = (struct TArtTimeCode *) &(m_pArtNetPacket->ArtPacket.ArtTimeCode);
 
 	if (packet->ProtVerLo != (uint8_t) ARTNET_PROTOCOL_REVISION) {
 		return;
@@ -1168,3 +2185,188 @@ void ArtNetNode::HandleTimeCode(void) {
 void ArtNetNode::SetTimeCodeHandler(ArtNetTimeCode *pArtNetTimeCode) {
 	m_pArtNetTimeCode = pArtNetTimeCode;
 }
+
+/**
+ *
+ * @param pLightSetRdm
+ */
+void ArtNetNode::SetRdmHandler(LightSetRdm *pLightSetRdm) {
+	m_pLightSetRdm = pLightSetRdm;
+
+	if (pLightSetRdm != 0) {
+		m_Node.Status1 = m_Node.Status1 | STATUS1_RDM_CAPABLE;
+	} else {
+		m_Node.Status1 = m_Node.Status1 & ~STATUS1_RDM_CAPABLE;
+	}
+
+	m_PollReply.Status1 = m_Node.Status1;
+}
+
+/**
+ * The TOD is answered from the cache of the RDM controller, there is no discovery on the DMX line.
+ */
+void ArtNetNode::HandleTodRequest(void) {
+	const struct TArtTodRequest *packet = (struct TArtTodRequest *)&(m_pArtNetPacket->ArtPacket.ArtTodRequest);
+
+	if ((m_pLightSetRdm == 0) || (packet->Command != ARTNET_TOD_FULL) || ((packet->Net & 0x7F) != (m_Node.NetSwitch & 0x7F))) {
+		return;
+	}
+
+	const uint8_t nCount = min(packet->AdCount, (uint8_t) sizeof packet->Address);
+
+	for (unsigned i = 0; i < nCount; i++) {
+		const uint8_t nPortIndex = m_PortAddressIndex[packet->Address[i]];
+
+		if (nPortIndex != ARTNET_PORT_INDEX_NONE) {
+			SendTod(nPortIndex);
+		}
+	}
+}
+
+/**
+ *
+ */
+void ArtNetNode::HandleTodControl(void) {
+	const struct TArtTodControl *packet = (struct TArtTodControl *)&(m_pArtNetPacket->ArtPacket.ArtTodControl);
+
+	if ((m_pLightSetRdm == 0) || ((packet->Net & 0x7F) != (m_Node.NetSwitch & 0x7F))) {
+		return;
+	}
+
+	const uint8_t nPortIndex = m_PortAddressIndex[packet->Address];
+
+	if (nPortIndex == ARTNET_PORT_INDEX_NONE) {
+		return;
+	}
+
+	if (packet->Command == ARTNET_TOD_CONTROL_FLUSH) {
+		// The new TOD is sent when the discovery has changed it
+		m_pLightSetRdm->Full(nPortIndex);
+	}
+
+	SendTod(nPortIndex);
+}
+
+/**
+ * The request is queued, the response is sent by \ref HandleRdmResponse when it has arrived.
+ */
+void ArtNetNode::HandleRdm(void) {
+	const struct TArtRdm *packet = (struct TArtRdm *)&(m_pArtNetPacket->ArtPacket.ArtRdm);
+	const int nHeaderSize = (int) (sizeof(struct TArtRdm) - ARTNET_RDM_DATA_LENGTH);
+
+	if ((m_pLightSetRdm == 0) || (packet->Command != ARTNET_RDM_PROCESS) || ((packet->Net & 0x7F) != (m_Node.NetSwitch & 0x7F))) {
+		return;
+	}
+
+	if (m_pArtNetPacket->length <= nHeaderSize) {
+		return;
+	}
+
+	const uint8_t nPortIndex = m_PortAddressIndex[packet->Address];
+
+	if (nPortIndex == ARTNET_PORT_INDEX_NONE) {
+		return;
+	}
+
+	const uint16_t nLength = min((uint16_t) (m_pArtNetPacket->length - nHeaderSize), (uint16_t) ARTNET_RDM_DATA_LENGTH);
+
+	m_RdmRequest[0] = ARTNET_RDM_START_CODE;
+	memcpy(&m_RdmRequest[1], packet->Data, nLength);
+
+	// The controller of the request is the tag, the response is sent to it only
+	(void) m_pLightSetRdm->Request(nPortIndex, m_RdmRequest, m_pArtNetPacket->IPAddressFrom);
+}
+
+/**
+ * Send the responses which have arrived for the queued ArtRdm requests.
+ */
+void ArtNetNode::HandleRdmResponse(void) {
+	const int nHeaderSize = (int) (sizeof(struct TArtRdm) - ARTNET_RDM_DATA_LENGTH);
+	const uint8_t *pResponse;
+	uint8_t nPortIndex;
+	uint32_t nIPAddressTo;
+
+	while ((pResponse = m_pLightSetRdm->GetResponse(&nPortIndex, &nIPAddressTo)) != 0) {
+		if ((pResponse[0] != ARTNET_RDM_START_CODE) || (nPortIndex >= ARTNET_NODE_MAX_PORTS)) {
+			continue;
+		}
+
+		// Message Length includes the start code, the checksum follows the message
+		const uint16_t nResponseLength = min((uint16_t) (pResponse[2] + 2 - 1), (uint16_t) ARTNET_RDM_DATA_LENGTH);
+
+		memcpy(m_ArtRdm.Data, &pResponse[1], nResponseLength);
+
+		m_ArtRdm.Net = (uint8_t) (m_OutputPorts[nPortIndex].port.nPortAddress >> 8);
+		m_ArtRdm.Address = (uint8_t) (m_OutputPorts[nPortIndex].port.nPortAddress & 0xFF);
+
+		const uint16_t nSize = (uint16_t) (nHeaderSize + nResponseLength);
+
+#if defined (__circle__)
+		CIPAddress IPAddressTo;
+		IPAddressTo.Set(nIPAddressTo);
+
+		if ((m_Socket.SendTo((const void *)&m_ArtRdm, nSize, MSG_DONTWAIT, IPAddressTo, (u16)NODE_UDP_PORT)) != (int)nSize) {
+			CLogger::Get()->Write(FromArtNetNode, LogError, "Cannot send");
+		}
+#else
+		udp_sendto((const uint8_t *)&m_ArtRdm, nSize, nIPAddressTo, (uint16_t)NODE_UDP_PORT);
+#endif
+	}
+}
+
+/**
+ * Send the TOD of the output ports for which the discovery has found changes.
+ */
+void ArtNetNode::HandleTodChanges(void) {
+	for (unsigned i = 0; i < ARTNET_NODE_MAX_PORTS; i++) {
+		if (m_OutputPorts[i].bIsEnabled && m_pLightSetRdm->IsTodChanged(i)) {
+			SendTod(i);
+		}
+	}
+}
+
+/**
+ * A TOD with more than \ref ARTNET_TOD_MAX_UIDS is sent in blocks.
+ *
+ * @param nPortIndex
+ */
+void ArtNetNode::SendTod(const uint8_t nPortIndex) {
+	uint16_t nUidTotal;
+	const uint8_t *pTod = m_pLightSetRdm->GetTod(nPortIndex, &nUidTotal);
+	uint16_t nUidSent = 0;
+	uint8_t nBlock = 0;
+
+#if defined (__circle__)
+	CIPAddress BroadcastIP;
+	BroadcastIP.Set(m_Node.IPAddressBroadcast);
+#endif
+
+	m_ArtTodData.Port = (uint8_t) (1 + (nPortIndex % ARTNET_MAX_PORTS));
+	m_ArtTodData.BindIndex = (ARTNET_NODE_MAX_PAGES > 1) ? (uint8_t) (1 + (nPortIndex / ARTNET_MAX_PORTS)) : 0;
+	m_ArtTodData.Net = (uint8_t) (m_OutputPorts[nPortIndex].port.nPortAddress >> 8);
+	m_ArtTodData.CommandResponse = ARTNET_TOD_FULL;
+	m_ArtTodData.Address = (uint8_t) (m_OutputPorts[nPortIndex].port.nPortAddress & 0xFF);
+	m_ArtTodData.UidTotalHi = (uint8_t) (nUidTotal >> 8);
+	m_ArtTodData.UidTotalLo = (uint8_t) (nUidTotal & 0xFF);
+
+	do {
+		const uint8_t nUidCount = (uint8_t) min(nUidTotal - nUidSent, (int) ARTNET_TOD_MAX_UIDS);
+
+		m_ArtTodData.BlockCount = nBlock++;
+		m_ArtTodData.UidCount = nUidCount;
+
+		memcpy(m_ArtTodData.Tod, &pTod[nUidSent * ARTNET_RDM_UID_WIDTH], (size_t) nUidCount * ARTNET_RDM_UID_WIDTH);
+
+		nUidSent += nUidCount;
+
+		const uint16_t nSize = (uint16_t) (sizeof(struct TArtTodData) - sizeof m_ArtTodData.Tod + (nUidCount * ARTNET_RDM_UID_WIDTH));
+
+#if defined (__circle__)
+		if ((m_Socket.SendTo((const void *)&(m_ArtTodData), nSize, MSG_DONTWAIT, BroadcastIP, (u16)NODE_UDP_PORT)) != (int)nSize) {
+			CLogger::Get()->Write(FromArtNetNode, LogError, "Cannot send");
+		}
+#else
+		udp_sendto((const uint8_t *)&(m_ArtTodData), nSize, m_Node.IPAddressBroadcast, (uint16_t)NODE_UDP_PORT);
+#endif
+	} while (nUidSent < nUidTotal);
+}
@@ -38,12 +38,16 @@ static const char PARAMS_SUBNET[] ALIGNED = "subnet";					///<
 static const char PARAMS_UNIVERSE[] ALIGNED = "universe";				///<
 static const char PARAMS_OUTPUT[] ALIGNED = "output";					///< dmx {default}, spi, mon
 static const char PARAMS_TIMECODE[] ALIGNED = "use_timecode";			///< Use the TimeCode call-back handler, 0 {default}
+static const char PARAMS_SYNC_DEADLINE[] ALIGNED = "sync_deadline";		///< Microseconds to wait for a missed ArtSync, 0 {default} is wait for ArtSync
+static const char PARAMS_DIRECTION[] ALIGNED = "direction";				///< "input" : the DMX received is transmitted as ArtDmx
 
 static uint8_t ArtNetParamsNet ALIGNED = 0;								///<
 static uint8_t ArtNetParamsSubnet ALIGNED = 0;							///<
 static uint8_t ArtNetParamsUniverse ALIGNED = 0;						///<
 static _output_type ArtNetParamsOutputType ALIGNED = OUTPUT_TYPE_DMX;	///<
 static bool ArtNetParamsUseTimeCode = false;							///<
+static uint32_t ArtNetParamsSyncDeadline ALIGNED = 0;					///<
+static bool ArtNetParamsIsInput = false;								///<
 
 /**
  *
@@ -53,6 +57,7 @@ static void process_line_read(const char *line) {
 	char value[8] ALIGNED;
 	uint8_t len = 3;
 	uint8_t value8;
+	uint32_t value32;
 
 	if (sscan_uint8_t(line, PARAMS_TIMECODE, &value8) == 2) {
 		if (value8 != 0) {
@@ -61,6 +66,20 @@ static void process_line_read(const char *line) {
 		return;
 	}
 
+	if (sscan_uint32_t(line, PARAMS_SYNC_DEADLINE, &value32) == 2) {
+		ArtNetParamsSyncDeadline = value32;
+		return;
+	}
+
+	len = 5;
+	if (sscan_char_p(line, PARAMS_DIRECTION, value, &len) == 2) {
+		if(memcmp(value, "input", 5) == 0) {
+			ArtNetParamsIsInput = true;
+		}
+		return;
+	}
+
+	len = 3;
 	if (sscan_uint8_t(line, PARAMS_NET, &value8) == 2) {
 		ArtNetParamsNet = value8;
 	} else if (sscan_uint8_t(line, PARAMS_SUBNET, &value8) == 2) {
@@ -86,6 +105,8 @@ ArtNetParams::ArtNetParams(void) {
 	ArtNetParamsUniverse = 0;
 	ArtNetParamsOutputType= OUTPUT_TYPE_DMX;
 	ArtNetParamsUseTimeCode = false;
+	ArtNetParamsSyncDeadline = 0;
+	ArtNetParamsIsInput = false;
 }
 
 /**
@@ -134,6 +155,22 @@ const bool ArtNetParams::IsUseTimeCode(void) {
 	return ArtNetParamsUseTimeCode;
 }
 
+/**
+ *
+ * @return
+ */
+const uint32_t ArtNetParams::GetSyncDeadline(void) {
+	return ArtNetParamsSyncDeadline;
+}
+
+/**
+ *
+ * @return true when the DMX received is transmitted as ArtDmx
+ */
+const bool ArtNetParams::IsInput(void) {
+	return ArtNetParamsIsInput;
+}
+
 /**
  *
  */
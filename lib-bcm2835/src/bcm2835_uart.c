@@ -30,27 +30,6 @@
 #include "bcm2835_aux.h"
 #include "bcm2835_uart.h"
 
-#define UART1_LCR_7BITS		0x02 // 7 bits mode
-#define UART1_LCR_8BITS		0x03 // 8 bits mode
-#define UART1_LCR_BREAK		0x40 // send break
-#define UART1_LCR_DLAB		0x80 // DLAB access
-
-#define UART1_LSR_DR		0x01 // Receive Data ready
-#define UART1_LSR_OE		0x02 // Receiver overrun error
-#define UART1_LSR_THRE		0x20 // Transmitter holding register
-#define UART1_LSR_TEMT 		0x40 // Transmitter empty
-
-#define UART1_CNTL_REC_ENBL	0x01 // receiver enable
-#define UART1_CNTL_TRN_ENBL	0x02 // transmitter enable
-#define UART1_CNTL_AUTO_RTR	0x04 // RTR set by RX FF level
-#define UART1_CNTL_AUTO_CTS	0x08 // CTS auto stops transmitter
-#define UART1_CNTL_FLOW3	0x00 // Stop on RX FF 3 entries left
-#define UART1_CNTL_FLOW2	0x10 // Stop on RX FF 2 entries left
-#define UART1_CNTL_FLOW1	0x20 // Stop on RX FF 1 entries left
-#define UART1_CNTL_FLOW4	0x30 // Stop on RX FF 4 entries left
-#define UART1_CNTL_AURTRINV	0x40 // Invert AUTO RTR polarity
-#define UART1_CNTL_AUCTSINV	0x80 // Invert AUTO CTS polarity
-
 /**
  * @ingroup UART
  *
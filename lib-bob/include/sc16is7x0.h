@@ -34,6 +34,8 @@
 //Default baudrate
 #define SC16IS7X0_DEFAULT_BAUDRATE			115200
 
+#define SC16IS7X0_FIFO_SIZE					64	///< Transmit and receive FIFO
+
 #define SC16IS7X0_RHR        (0x00)	///< Receive Holding Register - Read only
 #define SC16IS7X0_THR        (0X00)
 #define SC16IS7X0_IER        (0X01)
@@ -251,11 +251,35 @@ int sc16is740_read(const device_info_t *device_info, void *buffer, unsigned coun
 }
 
 /**
+ * The bytes are written to the transmit FIFO in a single SPI transfer, as many as there is space for.
  *
  * @param buffer
  * @param count
- * @return
+ * @return The number of bytes written
  */
-int sc16is740_write(/*@unused@*/const device_info_t *device_info, /*@unused@*/const void *buffer, /*@unused@*/unsigned count) {
-	return -1;	// TODO: not supported yet
+int sc16is740_write(const device_info_t *device_info, const void *buffer, unsigned count) {
+	const uint8_t *p = (const uint8_t *) buffer;
+	char spiData[1 + SC16IS7X0_FIFO_SIZE];
+	unsigned i;
+
+	const unsigned space = (unsigned) sc16is740_reg_read(device_info, SC16IS7X0_TXLVL);
+
+	if (count > space) {
+		count = space;
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	spiData[0] = (char) (SC16IS7X0_THR << 3);
+
+	for (i = 0; i < count; i++) {
+		spiData[1 + i] = (char) p[i];
+	}
+
+	sc16is740_setup(device_info);
+	bcm2835_spi_writenb(spiData, 1 + count);
+
+	return (int) count;
 }
@@ -32,8 +32,19 @@
 #include "util.h"
 
 #define DMX_DATA_BUFFER_SIZE					516									///< including SC, aligned 4
-#define DMX_DATA_BUFFER_INDEX_ENTRIES			(1 << 1)							///<
-#define DMX_DATA_BUFFER_INDEX_MASK 				(DMX_DATA_BUFFER_INDEX_ENTRIES - 1)	///<
+
+/**
+ * The maximum number of received DMX frames in the receive ring, a power of 2.
+ * The default keeps the output latency at one frame. An application with a slow consumer
+ * raises it at build time, and then selects the depth with \ref dmx_set_receive_depth.
+ */
+#if !defined (DMX_DATA_BUFFER_INDEX_ENTRIES)
+ #define DMX_DATA_BUFFER_INDEX_ENTRIES			(1 << 1)
+#endif
+
+#if (DMX_DATA_BUFFER_INDEX_ENTRIES < 2) || ((DMX_DATA_BUFFER_INDEX_ENTRIES & (DMX_DATA_BUFFER_INDEX_ENTRIES - 1)) != 0)
+ #error DMX_DATA_BUFFER_INDEX_ENTRIES must be a power of 2
+#endif
 
 #define DMX_TRANSMIT_BREAK_TIME_MIN				92		///< 92 us
 #define DMX_TRANSMIT_BREAK_TIME_TYPICAL			176		///< 176 us
@@ -59,8 +70,10 @@ typedef enum {
 struct _dmx_statistics {
 	uint32_t mark_after_break;							///<
 	uint32_t slots_in_packet;							///<
-	uint32_t break_to_break;							///<
+	uint32_t break_to_break;							///< 0 when the previous BREAK was not followed by a DMX start code
 	uint32_t slot_to_slot;								///<
+	uint32_t break_to_start_code;						///< From the BREAK to the start code, this is the BREAK + MAB
+	uint32_t slots_time;								///< From the start code to the last slot
 };
 
 struct _dmx_data {
@@ -68,9 +81,27 @@ struct _dmx_data {
 	struct _dmx_statistics statistics;					///<
 };
 
+/**
+ * The slots changed in the frame returned by \ref dmx_is_data_changed_slots. Slot 0 is the start code.
+ */
+struct _dmx_data_changed {
+	uint16_t first_slot;								///< Index of the first changed slot
+	uint16_t last_slot;									///< Index of the last changed slot
+	uint32_t bitmap[(DMX_DATA_BUFFER_SIZE + 31) / 32];	///< Bit (slot % 32) of bitmap[slot / 32] is set for a changed slot
+};
+
 struct _total_statistics {
 	uint32_t dmx_packets;								///<
 	uint32_t rdm_packets;								///<
+	uint32_t dmx_overruns;								///< The number of times the receive ring was full, the consumer did not keep up
+	uint32_t dmx_packets_dropped;						///< The DMX frames discarded because the receive ring was full
+	uint32_t dmx_high_water;							///< The maximum number of DMX frames waiting in the receive ring
+};
+
+struct _dmx_send_statistics {
+	uint32_t frames;									///< The DMX frames sent
+	uint32_t frames_superseded;							///< The DMX frames replaced by newer data before these were sent
+	uint32_t irq_micros;								///< The time spent in the transmit interrupt handlers
 };
 
 #ifdef __cplusplus
@@ -80,6 +111,7 @@ extern "C" {
 extern void dmx_init(void);
 
 extern void dmx_set_send_data(const uint8_t *, const uint16_t);
+extern /*@shared@*/const uint8_t *dmx_get_send_data(void) ASSUME_ALIGNED;
 extern void dmx_clear_data(void);
 extern void dmx_set_port_direction(const _dmx_port_direction, const bool);
 extern const _dmx_port_direction dmx_get_port_direction(void);
@@ -87,13 +119,18 @@ extern void dmx_data_send(const uint8_t *, const uint16_t);
 extern /*@shared@*/const /*@null@*/uint8_t *dmx_get_available(void) ASSUME_ALIGNED;
 extern /*@shared@*/const uint8_t *dmx_get_current_data(void) ASSUME_ALIGNED;
 extern /*@shared@*/const uint8_t *dmx_is_data_changed(void);
+extern /*@shared@*/const uint8_t *dmx_is_data_changed_slots(struct _dmx_data_changed *);
+extern const bool dmx_is_slots_changed(const struct _dmx_data_changed *, const uint16_t, const uint16_t);
 extern const uint32_t dmx_get_output_break_time(void);
 extern void dmx_set_output_break_time(const uint32_t);
 extern const uint32_t dmx_get_output_mab_time(void);
 extern void dmx_set_output_mab_time(const uint32_t);
 extern void dmx_reset_total_statistics(void);
 extern /*@shared@*/const volatile struct _total_statistics *dmx_get_total_statistics(void) ASSUME_ALIGNED;
+extern /*@shared@*/const volatile struct _dmx_send_statistics *dmx_get_send_statistics(void) ASSUME_ALIGNED;
 extern const volatile uint32_t dmx_get_updates_per_seconde(void);
+extern void dmx_set_receive_depth(const uint16_t);
+extern const uint16_t dmx_get_receive_depth(void);
 extern const uint16_t dmx_get_send_data_length(void);
 extern const uint32_t dmx_get_output_period(void);
 extern void dmx_set_output_period(const uint32_t);
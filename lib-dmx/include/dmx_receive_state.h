@@ -0,0 +1,88 @@
+/**
+ * @file dmx_receive_state.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMX_RECEIVE_STATE_H_
+#define DMX_RECEIVE_STATE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dmx.h"
+#include "rdm.h"
+
+///< State of receiving DMX/RDM Bytes
+typedef enum {
+	IDLE = 0,	///<
+	BREAK,		///<
+	MAB,		///<
+	DMXDATA,	///<
+	RDMDATA,	///<
+	CHECKSUMH,	///<
+	CHECKSUML,	///<
+	RDMDISCFE,	///<
+	RDMDISCEUID,///<
+	RDMDISCECS	///<
+} _dmx_state;
+
+/**
+ * The DMX512/RDM receive state machine with its receive rings. There is no hardware access,
+ * the bytes received and their timestamps are handed over by \ref dmx_receive_byte.
+ */
+struct _dmx_receive {
+	struct _dmx_data dmx_data[DMX_DATA_BUFFER_INDEX_ENTRIES];					///< The DMX receive ring
+	uint8_t rdm_data_buffer[RDM_DATA_BUFFER_INDEX_ENTRIES][RDM_DATA_BUFFER_SIZE];	///< The RDM receive ring
+	volatile struct _total_statistics total_statistics;							///<
+	volatile uint16_t dmx_data_buffer_index_head;								///<
+	volatile uint16_t dmx_data_buffer_index_tail;								///<
+	uint16_t dmx_data_buffer_index_mask;										///< The receive depth in use - 1
+	volatile bool dmx_is_overrun;												///< The receive ring is full
+	volatile uint16_t rdm_data_buffer_index_head;								///<
+	volatile uint16_t rdm_data_buffer_index_tail;								///<
+	volatile uint8_t dmx_receive_state;											///< Current state of DMX receive
+	volatile uint16_t dmx_data_index;											///<
+	volatile uint32_t dmx_micros_previous;										///< Timestamp of the previous byte
+	volatile bool dmx_is_previous_break_dmx;									///< Is the previous break from a DMX packet?
+	volatile uint32_t dmx_break_to_break_latest;								///<
+	volatile uint32_t dmx_break_to_break_previous;								///<
+	volatile uint32_t dmx_start_code_micros;									///< Timestamp of the start code of the DMX packet being received
+	volatile uint16_t rdm_checksum;												///<
+	volatile uint8_t rdm_disc_index;											///<
+	volatile uint32_t rdm_data_receive_end;										///<
+	volatile uint32_t timeout_micros;											///< End of packet check, see \ref dmx_receive_byte
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void dmx_receive_init(struct _dmx_receive *);
+extern bool dmx_receive_byte(struct _dmx_receive *, const uint32_t, const uint8_t, const bool);
+extern bool dmx_receive_timeout(struct _dmx_receive *, const uint32_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMX_RECEIVE_STATE_H_ */
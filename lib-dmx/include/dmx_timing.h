@@ -0,0 +1,67 @@
+/**
+ * @file dmx_timing.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMX_TIMING_H_
+#define DMX_TIMING_H_
+
+#include <stdint.h>
+
+#include "dmx.h"
+
+#define DMX_TIMING_HISTOGRAM_BINS	16	///< Bin 0 and the last bin hold the values outside the range
+
+/**
+ * Bin 0 holds the values below bin_low. Bin n holds bin_low + (n - 1) * bin_width up to the next bin.
+ */
+struct _dmx_timing_histogram {
+	uint32_t count;									///< Number of values
+	uint32_t min;									///<
+	uint32_t max;									///<
+	uint64_t sum;									///< For the mean
+	uint32_t bin_low;								///<
+	uint32_t bin_width;								///<
+	uint32_t bins[DMX_TIMING_HISTOGRAM_BINS];		///<
+};
+
+struct _dmx_timing {
+	struct _dmx_timing_histogram break_mab;			///< BREAK + MAB in us
+	struct _dmx_timing_histogram slot_to_slot;		///< The mean slot to slot time of a packet in us
+	struct _dmx_timing_histogram refresh_rate;		///< Packets per second, from break to break
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void dmx_timing_reset(void);
+extern void dmx_timing_add(const struct _dmx_statistics *);
+extern /*@shared@*/const struct _dmx_timing *dmx_timing_get(void);
+extern const uint32_t dmx_timing_get_mean(const struct _dmx_timing_histogram *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DMX_TIMING_H_ */
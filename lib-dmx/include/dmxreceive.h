@@ -0,0 +1,50 @@
+/**
+ * @file dmxreceive.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMXRECEIVE_H_
+#define DMXRECEIVE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dmx.h"
+#include "lightsetinput.h"
+
+class DMXReceive: public LightSetInput {
+public:
+	DMXReceive(void);
+	~DMXReceive(void);
+
+	void Start(void);
+	void Stop(void);
+
+	const uint8_t *GetData(const uint8_t, uint16_t *, bool *);
+
+private:
+	uint8_t m_Data[DMX_UNIVERSE_SIZE];	///< Copy of the latest DMX data received, without the start code
+	uint16_t m_nLength;					///< 0 when nothing is received
+};
+
+#endif /* DMXRECEIVE_H_ */
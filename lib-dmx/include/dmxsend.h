@@ -62,13 +62,15 @@ public:
 	uint32_t GetPeriodTimeRequested(void);
 
 	void SetData(const uint8_t, const uint8_t *, const uint16_t);
+	void SetDataRange(const uint8_t, const uint8_t *, const uint16_t, const uint16_t, const uint16_t);
+
+	const volatile struct _dmx_send_statistics *GetSendStatistics(void);
 
 private:
 	void SerialIRQHandler (void);
 	void TimerIRQHandler (void);
 
 	void ClearOutputData(void);
-	bool SetDataTry(const uint8_t *, const uint16_t);	// returns FALSE if transfer is active
 };
 
 #endif /* DMXSEND_H_ */
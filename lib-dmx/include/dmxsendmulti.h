@@ -0,0 +1,82 @@
+/**
+ * @file dmxsendmulti.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef DMXSENDMULTI_H_
+#define DMXSENDMULTI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dmx.h"
+#include "lightset.h"
+
+/**
+ * The maximum number of DMX output ports. Override at build time.
+ */
+#if !defined (DMX_MULTI_MAX_PORTS)
+ #define DMX_MULTI_MAX_PORTS	8
+#endif
+
+enum TDMXMultiUart {
+	DMX_MULTI_UART_PL011,		///< PL011 on GPIO14
+	DMX_MULTI_UART_MINI,		///< Mini UART on GPIO14, instead of the PL011. It has 1 stop bit only, so the slots are sent one by one with a MARK between.
+	DMX_MULTI_UART_SC16IS740	///< SC16IS740 on SPI, one for each chip select
+};
+
+/**
+ * DMX output on several UARTs, each port with its own BREAK, MAB and period.
+ * The ports are numbered in the order these are added, this is the port of the LightSet.
+ *
+ * A single system timer interrupt (IRQ_TIMER_1) schedules the BREAK, MAB and the FIFO refills of all ports.
+ * The ports with a SC16IS740 own the SPI bus while the output is started.
+ */
+class DMXSendMulti: public LightSet {
+public:
+	DMXSendMulti(void);
+	~DMXSendMulti(void);
+
+	bool AddPort(const TDMXMultiUart, const uint8_t);
+	uint8_t GetPorts(void);
+
+	void Start(void);
+	void Stop(void);
+
+	void SetBreakTime(const uint8_t, const uint32_t);
+	uint32_t GetBreakTime(const uint8_t);
+	void SetMabTime(const uint8_t, const uint32_t);
+	uint32_t GetMabTime(const uint8_t);
+	void SetPeriodTime(const uint8_t, const uint32_t);
+	uint32_t GetPeriodTime(const uint8_t);
+
+	void SetData(const uint8_t, const uint8_t *, const uint16_t);
+	void SetDataRange(const uint8_t, const uint8_t *, const uint16_t, const uint16_t, const uint16_t);
+
+	const volatile struct _dmx_send_statistics *GetSendStatistics(void);
+
+private:
+	void UpdatePeriodTime(const uint8_t);
+};
+
+#endif /* DMXSENDMULTI_H_ */
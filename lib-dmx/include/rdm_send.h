@@ -28,6 +28,10 @@
 
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern void rdm_send_data(const uint8_t *, const uint16_t);
 #if defined(RDM_RESPONDER)
 extern void rdm_send_discovery_respond_message(const uint8_t *, const uint16_t);
@@ -37,4 +41,9 @@ extern void rdm_send_respond_message_ack_timer(uint8_t *, const uint16_t);
 extern void rdm_send_increment_message_count(void);
 extern void rdm_send_decrement_message_count(void);
 #endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* RDM_SEND_H_ */
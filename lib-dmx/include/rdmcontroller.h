@@ -0,0 +1,144 @@
+/**
+ * @file rdmcontroller.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef RDMCONTROLLER_H_
+#define RDMCONTROLLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "rdm.h"
+#include "lightsetrdm.h"
+
+/**
+ * The maximum number of devices in the Table of Devices. Override at build time.
+ */
+#if !defined (RDM_CONTROLLER_MAX_UIDS)
+ #define RDM_CONTROLLER_MAX_UIDS	200
+#endif
+
+/**
+ * The number of requests waiting to be sent. Override at build time.
+ */
+#if !defined (RDM_CONTROLLER_REQUEST_ENTRIES)
+ #define RDM_CONTROLLER_REQUEST_ENTRIES	4
+#endif
+
+/**
+ * Depth first binary search of the 48-bit UID space
+ */
+#define RDM_CONTROLLER_STACK_SIZE	((RDM_UID_SIZE * 8) + 2)
+
+typedef enum {
+	RDM_CONTROLLER_STATE_IDLE,				///< Waiting for the next discovery
+	RDM_CONTROLLER_STATE_MUTE_KNOWN,		///< Check the devices in the TOD
+	RDM_CONTROLLER_STATE_WAIT_MUTE_KNOWN,	///<
+	RDM_CONTROLLER_STATE_BRANCH,			///< Search for new devices
+	RDM_CONTROLLER_STATE_WAIT_BRANCH,		///<
+	RDM_CONTROLLER_STATE_WAIT_MUTE_NEW,		///<
+	RDM_CONTROLLER_STATE_WAIT_RESPONSE		///< The response to a request, the discovery is resumed after
+} _rdm_controller_state;
+
+struct TRdmControllerBranch {
+	uint64_t nLower;	///<
+	uint64_t nUpper;	///<
+};
+
+struct TRdmControllerRequest {
+	uint32_t nTag;		///< Returned with the response
+	uint8_t nPort;		///<
+	uint8_t Data[sizeof(struct _rdm_command) + RDM_MESSAGE_CHECKSUM_SIZE];	///< Starting with the start code
+};
+
+/**
+ * RDM controller on the DMX port of lib-dmx (dmx.c), dmx_init must have been called.
+ *
+ * The discovery runs in the background, one message per \ref Run. After a full discovery, the TOD is
+ * refreshed incrementally : the known devices are muted one by one, devices not responding are removed,
+ * and the branch search only finds the devices which are new.
+ *
+ * The requests are queued and sent by \ref Run in between the discovery messages, a response is kept until \ref GetResponse.
+ */
+class RDMController: public LightSetRdm {
+public:
+	RDMController(const uint8_t *);
+	~RDMController(void);
+
+	void Run(void);
+	void Full(const uint8_t);
+	const uint8_t *GetTod(const uint8_t, uint16_t *);
+	const bool IsTodChanged(const uint8_t);
+	bool Request(const uint8_t, const uint8_t *, const uint32_t);
+	const uint8_t *GetResponse(uint8_t *, uint32_t *);
+
+	void SetRefreshTime(const uint32_t);
+	const uint32_t GetRefreshTime(void);
+
+private:
+	void SendMessage(const uint8_t *, const uint8_t, const uint16_t, const uint8_t *, const uint8_t);
+	void Send(const uint8_t *, const uint16_t);
+	void Restore(void);
+	bool RunRequest(void);
+	void HandleResponse(const uint8_t *);
+	bool IsMuteResponse(const uint8_t *, const uint8_t *);
+	bool DecodeDiscoveryResponse(const uint8_t *, uint8_t *);
+	void AddUid(const uint8_t *);
+	void RemoveUid(const uint16_t);
+	void Push(const uint64_t, const uint64_t);
+
+private:
+	uint8_t m_Uid[RDM_UID_SIZE];				///< The UID of the controller
+	uint8_t m_nTransactionNumber;				///<
+	uint8_t m_Message[sizeof(struct _rdm_command) + RDM_MESSAGE_CHECKSUM_SIZE];	///< The discovery message
+	uint8_t m_Response[sizeof(struct _rdm_command) + RDM_MESSAGE_CHECKSUM_SIZE];	///< Copy of the response for \ref GetResponse
+	uint8_t m_nResponsePort;					///<
+	uint32_t m_nResponseTag;					///<
+	bool m_bIsResponseAvailable;				///<
+
+	struct TRdmControllerRequest m_Requests[RDM_CONTROLLER_REQUEST_ENTRIES];	///< The queue of requests
+	uint8_t m_nRequestHead;						///< The request being sent
+	uint8_t m_nRequestCount;					///<
+
+	uint8_t m_Tod[RDM_CONTROLLER_MAX_UIDS][RDM_UID_SIZE];	///< The Table of Devices
+	uint16_t m_nUidCount;						///<
+	bool m_bIsTodChanged;						///< Changed by the discovery running, reported when it is finished
+
+	_rdm_controller_state m_tState;				///<
+	_rdm_controller_state m_tStateResume;		///< The discovery step after the response to a request
+	bool m_bIsDiscoveryPending;					///< Start a discovery without waiting for the refresh time
+	uint32_t m_nRefreshMicros;					///< Time between the discoveries
+	uint32_t m_nDiscoveryMicros;				///< End of the latest discovery
+	uint32_t m_nSendMicros;						///< Time of the latest message sent
+	bool m_bIsOutput;							///< The port direction to restore after the response
+
+	uint16_t m_nMuteIndex;						///< The device of the TOD being muted
+	uint8_t m_nRetries;							///<
+	uint8_t m_FoundUid[RDM_UID_SIZE];			///< The device being muted by the branch search
+	struct TRdmControllerBranch m_Branch;		///< The branch being searched
+	struct TRdmControllerBranch m_Stack[RDM_CONTROLLER_STACK_SIZE];	///< The branches still to search
+	uint8_t m_nStackTop;						///<
+};
+
+#endif /* RDMCONTROLLER_H_ */
@@ -0,0 +1,315 @@
+/**
+ * @file benchmark.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Push synthetic DMX512 frames, RDM packets and RDM discovery responses through the receive state machine,
+ * check what comes out of the rings and report the CPU time per byte.
+ *
+ * benchmark [-l loops]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dmx.h"
+#include "dmx_receive_state.h"
+#include "rdm.h"
+#include "rdm_e120.h"
+
+#define CYCLES				64		///< A cycle is a DMX frame, a RDM packet and a discovery response
+#define SLOT_TIME			44		///< 250 kbit/s, 11 bits
+#define BREAK_TO_START_CODE	100		///< BREAK + MAB
+#define SHORT_FRAME_SLOTS	100		///< Every 4th frame, ended by the slot timeout
+#define DISC_LENGTH			24		///< 7 x 0xFE, 0xAA, EUID, ECS
+
+struct _event {
+	uint32_t micros;
+	uint8_t data;
+	bool is_break;
+};
+
+struct _expected {
+	uint16_t slots;
+	uint8_t seed;
+	uint8_t rdm[RDM_DATA_BUFFER_SIZE];
+	uint16_t rdm_length;
+	bool is_rdm_valid;
+	uint8_t disc[DISC_LENGTH];
+};
+
+static struct _dmx_receive r;
+static struct _event *events;
+static uint32_t events_count;
+static uint32_t events_size;
+static struct _expected expected[CYCLES];
+static const uint8_t *expected_rdm[2 * CYCLES];		///< The RDM ring entries in order, the valid RDM packets and the discovery responses
+static uint16_t expected_rdm_length[2 * CYCLES];
+static uint32_t expected_rdm_count;
+
+static void event_add(uint32_t *micros, const uint8_t data, const bool is_break, const uint32_t duration) {
+	if (events_count == events_size) {
+		events_size = events_size == 0 ? 4096 : 2 * events_size;
+		events = realloc(events, events_size * sizeof(struct _event));
+
+		if (events == NULL) {
+			perror("realloc");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	events[events_count].micros = *micros;
+	events[events_count].data = data;
+	events[events_count].is_break = is_break;
+	events_count++;
+
+	*micros += duration;
+}
+
+static void generate(void) {
+	uint32_t micros = 0;
+	uint16_t c, i;
+
+	for (c = 0; c < CYCLES; c++) {
+		struct _expected *e = &expected[c];
+
+		// DMX512
+		e->slots = (c % 4 == 3) ? SHORT_FRAME_SLOTS : DMX_UNIVERSE_SIZE;
+		e->seed = (uint8_t) (c * 7);
+
+		event_add(&micros, 0, true, BREAK_TO_START_CODE);
+		event_add(&micros, DMX512_START_CODE, false, SLOT_TIME);
+
+		for (i = 1; i <= e->slots; i++) {
+			event_add(&micros, (uint8_t) (e->seed + i), false, SLOT_TIME);
+		}
+
+		micros += 200;
+
+		// RDM, every 8th with a wrong checksum
+		const uint8_t pdl = (uint8_t) (c % 8);
+		uint16_t checksum = 0;
+
+		e->rdm[0] = E120_SC_RDM;
+		e->rdm[1] = E120_SC_SUB_MESSAGE;
+		e->rdm[2] = (uint8_t) (24 + pdl);
+
+		for (i = 3; i < e->rdm[2]; i++) {
+			e->rdm[i] = (uint8_t) (c + i);
+		}
+
+		e->rdm[23] = pdl;
+
+		for (i = 0; i < e->rdm[2]; i++) {
+			checksum += e->rdm[i];
+		}
+
+		e->is_rdm_valid = (c % 8 != 5);
+
+		if (!e->is_rdm_valid) {
+			checksum++;
+		}
+
+		e->rdm[e->rdm[2]] = (uint8_t) (checksum >> 8);
+		e->rdm[e->rdm[2] + 1] = (uint8_t) checksum;
+		e->rdm_length = e->rdm[2] + 2;
+
+		if (e->is_rdm_valid) {
+			expected_rdm[expected_rdm_count] = e->rdm;
+			expected_rdm_length[expected_rdm_count++] = e->rdm_length;
+		}
+
+		event_add(&micros, 0, true, BREAK_TO_START_CODE);
+
+		for (i = 0; i < e->rdm_length; i++) {
+			event_add(&micros, e->rdm[i], false, SLOT_TIME);
+		}
+
+		micros += 200;
+
+		// Discovery response, there is no BREAK
+		for (i = 0; i < 7; i++) {
+			e->disc[i] = 0xFE;
+		}
+
+		e->disc[7] = 0xAA;
+
+		for (i = 8; i < DISC_LENGTH; i++) {
+			e->disc[i] = (uint8_t) (c ^ (i * 17)) | 0xAA;
+		}
+
+		for (i = 0; i < DISC_LENGTH; i++) {
+			event_add(&micros, e->disc[i], false, SLOT_TIME);
+		}
+
+		expected_rdm[expected_rdm_count] = e->disc;
+		expected_rdm_length[expected_rdm_count++] = DISC_LENGTH;
+
+		micros += 200;
+	}
+}
+
+/**
+ * The timer compare of the firmware : when the next event is later than the timeout, the timeout fires first.
+ */
+inline static void run_event(const struct _event *e, const uint32_t offset, bool *is_timeout) {
+	const uint32_t micros = e->micros + offset;
+
+	while (*is_timeout && ((int32_t) (micros - r.timeout_micros) >= 0)) {
+		*is_timeout = dmx_receive_timeout(&r, r.timeout_micros);
+	}
+
+	if (dmx_receive_byte(&r, micros, e->data, e->is_break)) {
+		*is_timeout = true;
+	}
+}
+
+static int verify(void) {
+	uint32_t n, dmx = 0, rdm = 0;
+	bool is_timeout = false;
+	int errors = 0;
+
+	dmx_receive_init(&r);
+
+	for (n = 0; n < events_count; n++) {
+		run_event(&events[n], 0, &is_timeout);
+
+		if (r.dmx_data_buffer_index_head != r.dmx_data_buffer_index_tail) {
+			const struct _dmx_data *d = &r.dmx_data[r.dmx_data_buffer_index_tail];
+			const struct _expected *e = &expected[dmx];
+			uint16_t i;
+
+			if (d->statistics.slots_in_packet != e->slots) {
+				fprintf(stderr, "frame %u : slots %u, expected %u\n", (unsigned) dmx, (unsigned) d->statistics.slots_in_packet, (unsigned) e->slots);
+				errors++;
+			}
+
+			if ((d->statistics.slot_to_slot != SLOT_TIME) || (d->statistics.break_to_start_code != BREAK_TO_START_CODE)) {
+				fprintf(stderr, "frame %u : slot to slot %u, break to start code %u\n", (unsigned) dmx, (unsigned) d->statistics.slot_to_slot, (unsigned) d->statistics.break_to_start_code);
+				errors++;
+			}
+
+			for (i = 1; i <= e->slots; i++) {
+				if (d->data[i] != (uint8_t) (e->seed + i)) {
+					fprintf(stderr, "frame %u : slot %u is %u\n", (unsigned) dmx, (unsigned) i, (unsigned) d->data[i]);
+					errors++;
+					break;
+				}
+			}
+
+			r.dmx_data_buffer_index_tail = (r.dmx_data_buffer_index_tail + 1) & r.dmx_data_buffer_index_mask;
+			dmx++;
+		}
+
+		if (r.rdm_data_buffer_index_head != r.rdm_data_buffer_index_tail) {
+			const uint8_t *p = r.rdm_data_buffer[r.rdm_data_buffer_index_tail];
+
+			if (rdm >= expected_rdm_count) {
+				fprintf(stderr, "RDM packet not expected\n");
+				errors++;
+			} else if (memcmp(p, expected_rdm[rdm], expected_rdm_length[rdm]) != 0) {
+				fprintf(stderr, "RDM packet %u differs\n", (unsigned) rdm);
+				errors++;
+			}
+
+			rdm++;
+			r.rdm_data_buffer_index_tail = (r.rdm_data_buffer_index_tail + 1) & RDM_DATA_BUFFER_INDEX_MASK;
+		}
+	}
+
+	if (dmx != CYCLES || rdm != expected_rdm_count) {
+		fprintf(stderr, "%u DMX frames and %u RDM packets received, expected %u and %u\n", (unsigned) dmx, (unsigned) rdm, (unsigned) CYCLES, (unsigned) expected_rdm_count);
+		errors++;
+	}
+
+	if (r.total_statistics.dmx_packets != CYCLES || r.total_statistics.rdm_packets != CYCLES) {
+		fprintf(stderr, "statistics : %u DMX, %u RDM\n", (unsigned) r.total_statistics.dmx_packets, (unsigned) r.total_statistics.rdm_packets);
+		errors++;
+	}
+
+	return errors;
+}
+
+int main(int argc, char **argv) {
+	uint32_t loops = 100;
+	uint32_t l, n;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:")) != -1) {
+		switch (opt) {
+		case 'l':
+			loops = (uint32_t) strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-l loops]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	generate();
+
+	const int errors = verify();
+
+	if (errors != 0) {
+		fprintf(stderr, "%d errors\n", errors);
+		return EXIT_FAILURE;
+	}
+
+	printf("%u frames checked, %u events per loop\n", (unsigned) CYCLES, (unsigned) events_count);
+
+	struct timespec start, end;
+	bool is_timeout = false;
+	const uint32_t loop_time = events[events_count - 1].micros + 1000;
+
+	dmx_receive_init(&r);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (l = 0; l < loops; l++) {
+		const uint32_t offset = l * loop_time;
+
+		for (n = 0; n < events_count; n++) {
+			run_event(&events[n], offset, &is_timeout);
+			r.dmx_data_buffer_index_tail = r.dmx_data_buffer_index_head;
+			r.rdm_data_buffer_index_tail = r.rdm_data_buffer_index_head;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	const double ns = (double) (end.tv_sec - start.tv_sec) * 1e9 + (double) (end.tv_nsec - start.tv_nsec);
+	const double bytes = (double) loops * (double) events_count;
+
+	printf("%.0f events in %.3f ms, %.2f ns per byte\n", bytes, ns / 1e6, ns / bytes);
+	printf("DMX %u, RDM %u, overruns %u\n", (unsigned) r.total_statistics.dmx_packets, (unsigned) r.total_statistics.rdm_packets, (unsigned) r.total_statistics.dmx_overruns);
+
+	free(events);
+
+	return EXIT_SUCCESS;
+}
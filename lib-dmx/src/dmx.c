@@ -3,7 +3,8 @@
  *
  * @brief This file implements the DMX512/RDM receive state-machine. It
  * uses the Fast Interrupt Request (FIQ) for accurate timing.
- * The Interrupt Request (IRQ) is used for sending DMX data.
+ * The Interrupt Request (IRQ) is used for sending DMX data, the slots are
+ * written to the transmit FIFO from the FIQ (PL011 transmit interrupt).
  *
  */
 /* Copyright (C) 2015, 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
@@ -44,56 +45,35 @@
 #include "gpio.h"
 #include "util.h"
 #include "dmx.h"
+#include "dmx_receive_state.h"
+#include "dmx_timing.h"
 #include "rdm.h"
 #include "rdm_e120.h"
 
-///< State of receiving DMX/RDM Bytes
-typedef enum {
-	IDLE = 0,	///<
-	BREAK,		///<
-	MAB,		///<
-	DMXDATA,	///<
-	RDMDATA,	///<
-	CHECKSUMH,	///<
-	CHECKSUML,	///<
-	RDMDISCFE,	///<
-	RDMDISCEUID,///<
-	RDMDISCECS	///<
-} _dmx_state;
-
-static volatile uint16_t dmx_data_buffer_index_head = (uint16_t) 0;				///<
-static volatile uint16_t dmx_data_buffer_index_tail = (uint16_t) 0;				///<
-static struct _dmx_data dmx_data[DMX_DATA_BUFFER_INDEX_ENTRIES] ALIGNED;		///<
 static uint8_t dmx_data_previous[DMX_DATA_BUFFER_SIZE] ALIGNED;					///<
-static uint8_t dmx_receive_state = IDLE;										///< Current state of DMX receive
-static volatile uint16_t dmx_data_index = (uint16_t) 0;							///<
 static uint32_t dmx_output_break_time = (uint32_t) DMX_TRANSMIT_BREAK_TIME_MIN;	///<
 static uint32_t dmx_output_mab_time = (uint32_t) DMX_TRANSMIT_MAB_TIME_MIN;		///<
 static uint32_t dmx_output_period = DMX_TRANSMIT_PERIOD_DEFAULT;				///<
 static uint32_t dmx_output_period_requested = DMX_TRANSMIT_PERIOD_DEFAULT;		///<
 static uint16_t dmx_send_data_length = (uint16_t) DMX_UNIVERSE_SIZE + 1;		///< SC + UNIVERSE SIZE
 static uint8_t dmx_port_direction = DMX_PORT_DIRECTION_INP;						///<
-static volatile uint32_t dmx_fiq_micros_current = (uint32_t) 0;					///< Timestamp FIQ
-static volatile uint32_t dmx_fiq_micros_previous = (uint32_t) 0;				///< Timestamp previous FIQ
-static volatile bool dmx_is_previous_break_dmx = false;							///< Is the previous break from a DMX packet?
-static volatile uint32_t dmx_break_to_break_latest = (uint32_t) 0;				///<
-static volatile uint32_t dmx_break_to_break_previous = (uint32_t) 0;			///<
 static volatile uint32_t dmx_slots_in_packet_previous = (uint32_t) 0;			///<
 static volatile uint8_t dmx_send_state = IDLE;									///<
 static volatile bool dmx_send_always = false;									///<
 //static volatile uint32_t dmx_irq_micros = 0;									///<
 static volatile uint32_t dmx_send_break_micros = (uint32_t) 0;					///<
+static volatile uint16_t dmx_send_slot = (uint16_t) 0;							///< The next slot to write to the transmit FIFO
+static uint8_t dmx_send_buffer[2][DMX_DATA_BUFFER_SIZE] ALIGNED;				///< Front (sent) and back (written) buffer
+static volatile uint8_t dmx_send_buffer_front = (uint8_t) 0;					///<
+static volatile uint16_t dmx_send_buffer_length = (uint16_t) DMX_UNIVERSE_SIZE + 1;///< The length of the front buffer
+static volatile bool dmx_send_is_writing = false;								///< The back buffer is being written
+static volatile bool dmx_send_is_pending = false;								///< The back buffer holds a frame not sent yet
+static volatile struct _dmx_send_statistics dmx_send_statistics ALIGNED;		///<
 
-static volatile uint16_t rdm_data_buffer_index_head = (uint16_t) 0;				///<
-static volatile uint16_t rdm_data_buffer_index_tail = (uint16_t) 0;				///<
-static uint8_t rdm_data_buffer[RDM_DATA_BUFFER_INDEX_ENTRIES][RDM_DATA_BUFFER_SIZE] ALIGNED;///<
-static volatile uint16_t rdm_checksum = (uint16_t) 0;							///<
-static volatile uint32_t rdm_data_receive_end = (uint32_t) 0;					///<
-static volatile uint8_t rdm_disc_index = (uint8_t) 0;							///<
+static struct _dmx_receive dmx_receive ALIGNED;									///< The receive state machine and rings
 
 static volatile uint32_t dmx_updates_per_seconde= (uint32_t) 0;					///<
 static uint32_t dmx_packets_previous = (uint32_t) 0;							///<
-static volatile struct _total_statistics total_statistics ALIGNED;				///<
 
 /**
  * @ingroup dmx
@@ -105,6 +85,38 @@ const volatile uint32_t dmx_get_updates_per_seconde(void) {
 	return dmx_updates_per_seconde;
 }
 
+/**
+ * @ingroup dmx
+ *
+ * Set the number of DMX frames in the receive ring. A deeper ring absorbs a consumer
+ * which is slow now and then, at the cost of latency when it does not keep up at all.
+ * Call this while the receiving is stopped.
+ *
+ * @param depth Rounded up to a power of 2, 2 .. \ref DMX_DATA_BUFFER_INDEX_ENTRIES
+ */
+void dmx_set_receive_depth(const uint16_t depth) {
+	uint16_t entries = (uint16_t) 2;
+
+	while ((entries < depth) && (entries < (uint16_t) DMX_DATA_BUFFER_INDEX_ENTRIES)) {
+		entries = entries << 1;
+	}
+
+	dmx_receive.dmx_data_buffer_index_mask = entries - 1;
+
+	dmx_receive.dmx_data_buffer_index_head = (uint16_t) 0;
+	dmx_receive.dmx_data_buffer_index_tail = (uint16_t) 0;
+	dmx_receive.dmx_is_overrun = false;
+}
+
+/**
+ * @ingroup dmx
+ *
+ * @return
+ */
+const uint16_t dmx_get_receive_depth(void) {
+	return dmx_receive.dmx_data_buffer_index_mask + 1;
+}
+
 /**
  * @ingroup dmx
  *
@@ -140,13 +152,38 @@ static void dmx_set_send_data_length(uint16_t send_data_length) {
 /**
  * @ingroup dmx
  *
+ * The data is written to the back buffer, which becomes the front buffer at the start of the next BREAK.
+ * The frame being sent is never changed, and there is no waiting for the interrupts.
+ * A frame which is replaced before it is sent is counted as superseded.
+ *
  * @param data
  * @param length
  */
 void dmx_set_send_data(const uint8_t *data, const uint16_t length) {
-	(void *)_memcpy(dmx_data[0].data, data, (size_t)length);
+	dmx_send_is_writing = true;
+	dmb();
+
+	if (dmx_send_is_pending) {
+		dmx_send_statistics.frames_superseded++;
+	}
+
+	(void *)_memcpy(dmx_send_buffer[dmx_send_buffer_front ^ 1], data, (size_t)length);
 
 	dmx_set_send_data_length(length);
+
+	dmb();
+	dmx_send_is_pending = true;
+	dmx_send_is_writing = false;
+	dmb();
+}
+
+/**
+ * @ingroup dmx
+ *
+ * @return The DMX data being sent, beginning with the start code
+ */
+const uint8_t *dmx_get_send_data(void) {
+	return dmx_send_buffer[dmx_send_buffer_front];
 }
 
 /**
@@ -154,8 +191,23 @@ void dmx_set_send_data(const uint8_t *data, const uint16_t length) {
  *
  */
 void dmx_clear_data(void) {
-	uint32_t i = sizeof(dmx_data) / sizeof(uint32_t);
-	uint32_t *p = (uint32_t *)dmx_data;
+	uint32_t i = sizeof(dmx_receive.dmx_data) / sizeof(uint32_t);
+	uint32_t *p = (uint32_t *)dmx_receive.dmx_data;
+
+	while (i-- != (uint32_t) 0) {
+		*p++ = (uint32_t) 0;
+	}
+
+	i = sizeof(dmx_send_buffer) / sizeof(uint32_t);
+	p = (uint32_t *)dmx_send_buffer;
+
+	while (i-- != (uint32_t) 0) {
+		*p++ = (uint32_t) 0;
+	}
+
+	// The changes are reported against all zeros
+	i = sizeof(dmx_data_previous) / sizeof(uint32_t);
+	p = (uint32_t *)dmx_data_previous;
 
 	while (i-- != (uint32_t) 0) {
 		*p++ = (uint32_t) 0;
@@ -186,11 +238,11 @@ const uint16_t dmx_get_send_data_length(void) {
  * @return
  */
 const uint8_t *rdm_get_available(void)  {
-	if (rdm_data_buffer_index_head == rdm_data_buffer_index_tail) {
+	if (dmx_receive.rdm_data_buffer_index_head == dmx_receive.rdm_data_buffer_index_tail) {
 		return NULL;
 	} else {
-		const uint8_t *p = &rdm_data_buffer[rdm_data_buffer_index_tail][0];
-		rdm_data_buffer_index_tail = (rdm_data_buffer_index_tail + 1) & RDM_DATA_BUFFER_INDEX_MASK;
+		const uint8_t *p = &dmx_receive.rdm_data_buffer[dmx_receive.rdm_data_buffer_index_tail][0];
+		dmx_receive.rdm_data_buffer_index_tail = (dmx_receive.rdm_data_buffer_index_tail + 1) & RDM_DATA_BUFFER_INDEX_MASK;
 		return p;
 	}
 }
@@ -201,21 +253,24 @@ const uint8_t *rdm_get_available(void)  {
  * @return
  */
 const uint8_t *rdm_get_current_data(void) {
-	return &rdm_data_buffer[rdm_data_buffer_index_tail][0];
+	return &dmx_receive.rdm_data_buffer[dmx_receive.rdm_data_buffer_index_tail][0];
 }
 
 /**
  * @ingroup dmx
  *
+ * The timing of each packet taken from the receive ring is added to \ref dmx_timing_get.
+ *
  * @return
  */
 const uint8_t *dmx_get_available(void)  {
 	dmb();
-	if (dmx_data_buffer_index_head == dmx_data_buffer_index_tail) {
+	if (dmx_receive.dmx_data_buffer_index_head == dmx_receive.dmx_data_buffer_index_tail) {
 		return NULL;
 	} else {
-		const uint8_t *p = dmx_data[dmx_data_buffer_index_tail].data;
-		dmx_data_buffer_index_tail = (dmx_data_buffer_index_tail + 1) & DMX_DATA_BUFFER_INDEX_MASK;
+		const uint8_t *p = dmx_receive.dmx_data[dmx_receive.dmx_data_buffer_index_tail].data;
+		dmx_timing_add(&dmx_receive.dmx_data[dmx_receive.dmx_data_buffer_index_tail].statistics);
+		dmx_receive.dmx_data_buffer_index_tail = (dmx_receive.dmx_data_buffer_index_tail + 1) & dmx_receive.dmx_data_buffer_index_mask;
 		return p;
 	}
 }
@@ -226,7 +281,7 @@ const uint8_t *dmx_get_available(void)  {
  * @return
  */
 const uint8_t *dmx_get_current_data(void) {
-	return dmx_data[dmx_data_buffer_index_tail].data;
+	return dmx_receive.dmx_data[dmx_receive.dmx_data_buffer_index_tail].data;
 }
 
 /**
@@ -236,7 +291,17 @@ const uint8_t *dmx_get_current_data(void) {
  */
 const volatile uint8_t dmx_get_receive_state(void) {
 	dmb();
-	return dmx_receive_state;
+	return dmx_receive.dmx_receive_state;
+}
+
+/**
+ * Bit n of the result is set when slot n of the 4 slots packed in the word differs.
+ * The high bit of each slot is set when any bit of that slot is set, without a carry into the next slot.
+ */
+inline static uint32_t dmx_changed_slots_mask(const uint32_t diff) {
+	const uint32_t m = ((((diff & 0x7F7F7F7F) + 0x7F7F7F7F) | diff) & 0x80808080) >> 7;
+
+	return (m | (m >> 7) | (m >> 14) | (m >> 21)) & 0x0F;
 }
 
 /**
@@ -248,6 +313,19 @@ const volatile uint8_t dmx_get_receive_state(void) {
  * @return
  */
 const uint8_t *dmx_is_data_changed(void) {
+	return dmx_is_data_changed_slots(NULL);
+}
+
+/**
+ * @ingroup dmx
+ *
+ * As \ref dmx_is_data_changed, and the changed slots are reported from the same compare.
+ * When slots in packet is changed, all slots are reported as changed.
+ *
+ * @param changed Optional, only valid when the data is changed
+ * @return
+ */
+const uint8_t *dmx_is_data_changed_slots(struct _dmx_data_changed *changed) {
 	uint16_t i;
 	uint8_t const *p = (uint8_t *)dmx_get_available();
 	uint32_t *src = (uint32_t *)p;
@@ -267,12 +345,35 @@ const uint8_t *dmx_is_data_changed(void) {
 			dst++;
 			src++;
 		}
+		if (changed != NULL) {
+			changed->first_slot = 0;
+			changed->last_slot = DMX_DATA_BUFFER_SIZE - 1;
+			for (i = 0; i < sizeof(changed->bitmap) / sizeof(changed->bitmap[0]); i++) {
+				changed->bitmap[i] = (uint32_t) ~0;
+			}
+		}
 		return p;
 	}
 
+	if (changed != NULL) {
+		for (i = 0; i < sizeof(changed->bitmap) / sizeof(changed->bitmap[0]); i++) {
+			changed->bitmap[i] = 0;
+		}
+	}
+
 	for (i = 0; i < DMX_DATA_BUFFER_SIZE / 4; i++) {
-		if (*dst != *src) {
+		const uint32_t diff = *dst ^ *src;
+
+		if (diff != 0) {
 			*dst = *src;
+			if (changed != NULL) {
+				// Little endian : the lowest slot is in the least significant byte
+				if (!is_changed) {
+					changed->first_slot = (uint16_t) (i * 4 + __builtin_ctz(diff) / 8);
+				}
+				changed->last_slot = (uint16_t) (i * 4 + 3 - __builtin_clz(diff) / 8);
+				changed->bitmap[i / 8] |= dmx_changed_slots_mask(diff) << ((i % 8) * 4);
+			}
 			is_changed = true;
 		}
 		dst++;
@@ -282,6 +383,35 @@ const uint8_t *dmx_is_data_changed(void) {
 	return (is_changed ? p : NULL);
 }
 
+/**
+ * @ingroup dmx
+ *
+ * @param changed As filled in by \ref dmx_is_data_changed_slots
+ * @param slot First slot of the range
+ * @param count Number of slots
+ * @return true when any slot in the range is changed
+ */
+const bool dmx_is_slots_changed(const struct _dmx_data_changed *changed, const uint16_t slot, const uint16_t count) {
+	const uint16_t last = MIN((uint16_t) (slot + count - 1), changed->last_slot);
+	uint16_t i;
+
+	if ((count == 0) || (slot > changed->last_slot) || (slot + count - 1 < changed->first_slot)) {
+		return false;
+	}
+
+	for (i = MAX(slot, changed->first_slot); i <= last; i++) {
+		const uint32_t bits = changed->bitmap[i / 32] >> (i % 32);
+
+		if (bits != 0) {
+			return (i + __builtin_ctz(bits)) <= last;
+		}
+
+		i |= 31;	// Next word
+	}
+
+	return false;
+}
+
 /**
  * @ingroup dmx
  *
@@ -297,7 +427,7 @@ const _dmx_port_direction dmx_get_port_direction(void) {
  * @return
  */
 const uint32_t rdm_get_data_receive_end(void) {
-	return rdm_data_receive_end;
+	return dmx_receive.rdm_data_receive_end;
 }
 
 /**
@@ -345,8 +475,11 @@ void dmx_set_output_mab_time(const uint32_t mab_time) {
  *
  */
 void dmx_reset_total_statistics(void) {
-	total_statistics.dmx_packets = (uint32_t) 0;
-	total_statistics.rdm_packets = (uint32_t) 0;
+	dmx_receive.total_statistics.dmx_packets = (uint32_t) 0;
+	dmx_receive.total_statistics.rdm_packets = (uint32_t) 0;
+	dmx_receive.total_statistics.dmx_overruns = (uint32_t) 0;
+	dmx_receive.total_statistics.dmx_packets_dropped = (uint32_t) 0;
+	dmx_receive.total_statistics.dmx_high_water = (uint32_t) 0;
 }
 
 /**
@@ -355,13 +488,25 @@ void dmx_reset_total_statistics(void) {
  * @return
  */
 const volatile struct _total_statistics *dmx_get_total_statistics(void) {
-	return &total_statistics;
+	return &dmx_receive.total_statistics;
+}
+
+/**
+ * @ingroup dmx
+ *
+ * The time spent for sending DMX, the CPU headroom is what is left of each second.
+ *
+ * @return
+ */
+const volatile struct _dmx_send_statistics *dmx_get_send_statistics(void) {
+	return &dmx_send_statistics;
 }
 
 /**
  * @ingroup dmx
  *
  * Interrupt handler for continues receiving DMX512 data.
+ * The state machine is in \ref dmx_receive_byte, here is the hardware only.
  *
  */
 static void __attribute__((interrupt("FIQ"))) fiq_dmx_in_handler(void) {
@@ -371,166 +516,13 @@ static void __attribute__((interrupt("FIQ"))) fiq_dmx_in_handler(void) {
 	bcm2835_gpio_set(GPIO_ANALYZER_CH1);
 #endif
 
-	dmx_fiq_micros_current = BCM2835_ST->CLO;
-
+	const uint32_t micros = BCM2835_ST->CLO;
 	const uint32_t dr = BCM2835_PL011->DR;
 
-	if (dr & PL011_DR_BE) {
-		dmx_receive_state = BREAK;
-		dmx_break_to_break_latest = dmx_fiq_micros_current;
-#ifdef LOGIC_ANALYZER
-		bcm2835_gpio_set(GPIO_ANALYZER_CH2);	// BREAK
-		bcm2835_gpio_clr(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-	} else {
-		const uint8_t data = dr & 0xFF;
-
-		switch (dmx_receive_state) {
-		case IDLE:
-			if (data == 0xFE) {
-				dmx_receive_state = RDMDISCFE;
-				rdm_data_buffer[rdm_data_buffer_index_head][0] = 0xFE;
-				dmx_data_index = 1;
-			}
-			break;
-		case BREAK:
-			switch (data) {
-			case DMX512_START_CODE:
-				dmx_receive_state = DMXDATA;
-				dmx_data[dmx_data_buffer_index_head].data[0] = DMX512_START_CODE;
-				dmx_data_index = 1;
-				total_statistics.dmx_packets = total_statistics.dmx_packets + 1;
-				if (dmx_is_previous_break_dmx) {
-					dmx_data[dmx_data_buffer_index_head].statistics.break_to_break = dmx_break_to_break_latest - dmx_break_to_break_previous;
-					dmx_break_to_break_previous = dmx_break_to_break_latest;
-
-				} else {
-					dmx_is_previous_break_dmx = true;
-					dmx_break_to_break_previous = dmx_break_to_break_latest;
-				}
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_clr(GPIO_ANALYZER_CH2);	// BREAK
-			    bcm2835_gpio_set(GPIO_ANALYZER_CH3);	// DMX DATA
-#endif
-				break;
-			case E120_SC_RDM:
-				dmx_receive_state = RDMDATA;
-				rdm_data_buffer[rdm_data_buffer_index_head][0] = E120_SC_RDM;
-				rdm_checksum = E120_SC_RDM;
-				dmx_data_index = 1;
-				total_statistics.rdm_packets = total_statistics.rdm_packets + 1;
-				dmx_is_previous_break_dmx = false;
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_clr(GPIO_ANALYZER_CH2);	// BREAK
-			    bcm2835_gpio_set(GPIO_ANALYZER_CH3);	// DMX DATA
-#endif
-				break;
-			default:
-				dmx_receive_state = IDLE;
-				dmx_is_previous_break_dmx = false;
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_clr(GPIO_ANALYZER_CH2);	// BREAK
-				bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-				break;
-			}
-			break;
-		case DMXDATA:
-			dmx_data[dmx_data_buffer_index_head].statistics.slot_to_slot = dmx_fiq_micros_current - dmx_fiq_micros_previous;
-			if (dmx_data[dmx_data_buffer_index_head].statistics.slot_to_slot < 44) { // Broadcom BUG ? FIQ is late
-				dmx_data[dmx_data_buffer_index_head].statistics.slot_to_slot = (uint32_t)44;
-			}
-			dmx_data[dmx_data_buffer_index_head].data[dmx_data_index++] = data;
-		    BCM2835_ST->C1 = dmx_fiq_micros_current + dmx_data[0].statistics.slot_to_slot + (uint32_t)12;
-			if (dmx_data_index > DMX_UNIVERSE_SIZE) {
-				dmx_receive_state = IDLE;
-				dmx_data[dmx_data_buffer_index_head].statistics.slots_in_packet = DMX_UNIVERSE_SIZE;
-				dmx_data_buffer_index_head = (dmx_data_buffer_index_head + 1) & DMX_DATA_BUFFER_INDEX_MASK;
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_clr(GPIO_ANALYZER_CH3);	// DMX DATA
-				bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-			}
-			break;
-		case RDMDATA:
-			if (dmx_data_index > RDM_DATA_BUFFER_SIZE) {
-				dmx_receive_state = IDLE;
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-			} else {
-				rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] = data;
-				rdm_checksum += data;
-
-				const struct _rdm_command *p = (struct _rdm_command *)(&rdm_data_buffer[rdm_data_buffer_index_head][0]);
-				if (dmx_data_index == p->message_length) {
-					dmx_receive_state = CHECKSUMH;
-				}
-			}
-			break;
-		case CHECKSUMH:
-			rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] =	data;
-			rdm_checksum -= data << 8;
-			dmx_receive_state = CHECKSUML;
-			break;
-		case CHECKSUML:
-			rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] = data;
-			rdm_checksum -= data;
-			const struct _rdm_command *p = (struct _rdm_command *)(&rdm_data_buffer[rdm_data_buffer_index_head][0]);
-			if ((rdm_checksum == 0) && (p->sub_start_code == E120_SC_SUB_MESSAGE)) {
-				rdm_data_buffer_index_head = (rdm_data_buffer_index_head + 1) & RDM_DATA_BUFFER_INDEX_MASK;
-				rdm_data_receive_end = BCM2835_ST->CLO;
-			}
-			dmx_receive_state = IDLE;
-#ifdef LOGIC_ANALYZER
-			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-			break;
-		case RDMDISCFE:
-			switch (data) {
-			case 0xFE:
-				rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] = 0xFE;
-				break;
-			case 0xAA:
-				rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] = 0xAA;
-				dmx_receive_state = RDMDISCEUID;
-				rdm_disc_index = 0;
-				break;
-			default:
-				dmx_receive_state = IDLE;
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-				break;
-			}
-			break;
-		case RDMDISCEUID:
-			rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] = data;
-			rdm_disc_index++;
-			if (rdm_disc_index == 2 * RDM_UID_SIZE) {
-				dmx_receive_state = RDMDISCECS;
-				rdm_disc_index = 0;
-			}
-			break;
-		case RDMDISCECS:
-			rdm_data_buffer[rdm_data_buffer_index_head][dmx_data_index++] = data;
-			rdm_disc_index++;
-			if (rdm_disc_index == 4) {
-				rdm_data_buffer_index_head = (rdm_data_buffer_index_head + 1) & RDM_DATA_BUFFER_INDEX_MASK;
-				dmx_receive_state = IDLE;
-				rdm_data_receive_end = BCM2835_ST->CLO;
-#ifdef LOGIC_ANALYZER
-				bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-			}
-			break;
-		default:
-			break;
-		}
+	if (dmx_receive_byte(&dmx_receive, micros, (uint8_t) (dr & 0xFF), (dr & PL011_DR_BE) != 0)) {
+		BCM2835_ST->C1 = dmx_receive.timeout_micros;
 	}
 
-	dmx_fiq_micros_previous = dmx_fiq_micros_current;
-
 #ifdef LOGIC_ANALYZER
 	bcm2835_gpio_clr(GPIO_ANALYZER_CH1);
 #endif
@@ -539,63 +531,107 @@ static void __attribute__((interrupt("FIQ"))) fiq_dmx_in_handler(void) {
 }
 
 static void irq_timer1_dmx_receive(const uint32_t clo) {
-	if (dmx_receive_state == DMXDATA) {
-		if (clo - dmx_fiq_micros_current > dmx_data[0].statistics.slot_to_slot) {
-			dmx_receive_state = IDLE;
-			dmx_data[dmx_data_buffer_index_head].statistics.slots_in_packet = dmx_data_index - 1;
-			dmx_data_buffer_index_head = (dmx_data_buffer_index_head + 1) & DMX_DATA_BUFFER_INDEX_MASK;
-#ifdef LOGIC_ANALYZER
-			bcm2835_gpio_clr(GPIO_ANALYZER_CH3);	// DMX DATA
-			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
-#endif
-		} else {
-			BCM2835_ST->C1 = clo + dmx_data[dmx_data_buffer_index_head].statistics.slot_to_slot;
-		}
+	if (dmx_receive_timeout(&dmx_receive, clo)) {
+		BCM2835_ST->C1 = dmx_receive.timeout_micros;
 	}
 }
 
 static void irq_timer3_dmx_receive(const uint32_t clo) {
 	BCM2835_ST->C3 = clo + (uint32_t) 1000000;
-	dmx_updates_per_seconde = total_statistics.dmx_packets - dmx_packets_previous;
-	dmx_packets_previous = total_statistics.dmx_packets;
+	dmx_updates_per_seconde = dmx_receive.total_statistics.dmx_packets - dmx_packets_previous;
+	dmx_packets_previous = dmx_receive.total_statistics.dmx_packets;
+}
+
+/**
+ * @ingroup dmx
+ *
+ * Fill the transmit FIFO with the next slots.
+ *
+ * @return true when all slots are written
+ */
+inline static bool dmx_send_fill_fifo(void) {
+	while ((BCM2835_PL011->FR & PL011_FR_TXFF) == 0) {
+		if (dmx_send_slot >= dmx_send_buffer_length) {
+			return true;
+		}
+
+		BCM2835_PL011->DR = dmx_send_buffer[dmx_send_buffer_front][dmx_send_slot++];
+	}
+
+	return (dmx_send_slot >= dmx_send_buffer_length);
+}
+
+/**
+ * @ingroup dmx
+ *
+ * Interrupt handler for sending DMX512 data, the transmit FIFO level interrupt.
+ * The FIFO is refilled when it is 1/4 full, the CPU is free while the slots are shifted out.
+ *
+ */
+static void __attribute__((interrupt("FIQ"))) fiq_dmx_out_handler(void) {
+	dmb();
+
+	const uint32_t micros = BCM2835_ST->CLO;
+
+	if ((BCM2835_PL011->MIS & PL011_MIS_TXMIS) != 0) {
+		if (dmx_send_fill_fifo()) {
+			BCM2835_PL011->IMSC = BCM2835_PL011->IMSC & ~PL011_IMSC_TXIM;
+			dmx_send_state = IDLE;
+		}
+
+		BCM2835_PL011->ICR = PL011_ICR_TXIC;
+	}
+
+	dmx_send_statistics.irq_micros += BCM2835_ST->CLO - micros;
+
+	dmb();
 }
 
 static void irq_timer1_dmx_send(const uint32_t clo) {
 	switch (dmx_send_state) {
 	case IDLE:
 		BCM2835_ST->C1 = clo + dmx_output_break_time;
-		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2 | PL011_LCRH_BRK;
+		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2 | PL011_LCRH_FEN | PL011_LCRH_BRK;
 		dmx_send_break_micros = clo;
+		// Swap the buffers, unless the back buffer is being written. Then the previous frame is repeated.
+		if (dmx_send_is_pending && !dmx_send_is_writing) {
+			dmx_send_buffer_front = dmx_send_buffer_front ^ 1;
+			dmx_send_buffer_length = dmx_send_data_length;
+			dmx_send_is_pending = false;
+		}
 		dmb();
 		dmx_send_state = BREAK;
 		break;
 	case BREAK:
 		BCM2835_ST->C1 = clo + dmx_output_mab_time;
-		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2;
+		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2 | PL011_LCRH_FEN;
 		dmb();
 		dmx_send_state = MAB;
 		break;
-		//udelay(dmx_output_mab_time);
-		/* no break */
 	case MAB:
 		BCM2835_ST->C1 = dmx_send_break_micros + dmx_output_period;
-		/* dmx_send_state = DMXDATA; */
-		uint16_t i = 0;
-		for (i = 0; i < dmx_send_data_length; i++) {
-			while ((BCM2835_PL011->FR & PL011_FR_TXFF) != 0)
-				;
-			BCM2835_PL011->DR = dmx_data[0].data[i];
+		dmx_send_slot = (uint16_t) 0;
+		dmx_send_statistics.frames++;
+		if (dmx_send_fill_fifo()) {
+			dmb();
+			dmx_send_state = IDLE;
+		} else {
+			dmb();
+			dmx_send_state = DMXDATA;
+			BCM2835_PL011->IMSC = BCM2835_PL011->IMSC | PL011_IMSC_TXIM;
 		}
-		while ((BCM2835_PL011->FR & PL011_FR_BUSY) != 0)
-			;
-		dmb();
-		dmx_send_state = IDLE;
+		break;
+	case DMXDATA:
+		// The output period is shorter than the frame, the BREAK waits for the last slots
+		BCM2835_ST->C1 = clo + (uint32_t) 44;
 		break;
 	default:
 		dmb();
 		dmx_send_state = IDLE;
 		break;
 	}
+
+	dmx_send_statistics.irq_micros += BCM2835_ST->CLO - clo;
 }
 
 /**
@@ -609,6 +645,16 @@ static void dmx_start_data(void) {
 		dmb();
 		dmx_send_state = IDLE;
 
+		BCM2835_PL011->IMSC = (uint32_t) 0;
+		BCM2835_PL011->ICR = PL011_ICR_TXIC;
+		BCM2835_PL011->IFLS = PL011_IFLS_TXIFLSEL_1_4;	// TX interrupt when the transmit FIFO becomes 1/4 full
+
+		(void) arm_install_handler((unsigned)fiq_dmx_out_handler, ARM_VECTOR(ARM_VECTOR_FIQ));
+
+		dmb();
+
+		__enable_fiq();
+
 		irq_timer_set(IRQ_TIMER_1, irq_timer1_dmx_send);
 
 		const uint32_t clo = BCM2835_ST->CLO;
@@ -624,7 +670,12 @@ static void dmx_start_data(void) {
 		break;
 	case DMX_PORT_DIRECTION_INP:
 		dmb();
-		dmx_receive_state = IDLE;
+		dmx_receive.dmx_receive_state = IDLE;
+
+		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2;	// FIFO disabled, a FIQ for each slot received
+		BCM2835_PL011->IMSC = PL011_IMSC_RXIM;
+
+		(void) arm_install_handler((unsigned)fiq_dmx_in_handler, ARM_VECTOR(ARM_VECTOR_FIQ));
 
 		irq_timer_set(IRQ_TIMER_1, irq_timer1_dmx_receive);
 		irq_timer_set(IRQ_TIMER_3, irq_timer3_dmx_receive);
@@ -646,7 +697,8 @@ static void dmx_start_data(void) {
  * @ingroup dmx
  *
  * If \ref dmx_send_always is true, then the IRQ routine is outputting DMX512.
- * We need to wait until all data is sent. When finished the state machine is in state IDLE.
+ * We need to wait until all data is sent. When finished the state machine is in state IDLE,
+ * and the last slots are shifted out of the transmit FIFO.
  * At this time we can set the flag \ref dmx_send_always to false.
  *
  * The receiving of DMX data is stopped by disabling the FIQ.
@@ -665,15 +717,20 @@ static void dmx_stop_data(void) {
 		} while (BCM2835_ST->CLO - clo < dmx_output_period);
 		dmx_send_always = false;
 		irq_timer_set(IRQ_TIMER_1, NULL);
+
+		BCM2835_PL011->IMSC = BCM2835_PL011->IMSC & ~PL011_IMSC_TXIM;
+
+		while ((BCM2835_PL011->FR & PL011_FR_BUSY) != 0)
+			;
 	}
 
 	__disable_fiq();
 
 	dmb();
-	dmx_receive_state = IDLE;
+	dmx_receive.dmx_receive_state = IDLE;
 
 	for (i = 0; i < DMX_DATA_BUFFER_INDEX_ENTRIES; i++) {
-		dmx_data[i].statistics.slots_in_packet = 0;
+		dmx_receive.dmx_data[i].statistics.slots_in_packet = 0;
 	}
 }
 
@@ -777,17 +834,15 @@ void dmx_init(void) {
 
 	dmx_clear_data();
 
-	dmx_data_buffer_index_head = (uint16_t) 0;
-	dmx_data_buffer_index_tail = (uint16_t) 0;
-
-	rdm_data_buffer_index_head = (uint16_t) 0;
-	rdm_data_buffer_index_tail = (uint16_t) 0;
-
-	dmx_receive_state = IDLE;
+	dmx_receive_init(&dmx_receive);
 
 	dmx_send_state = IDLE;
 	dmx_send_always = false;
 
+	dmx_send_buffer_front = (uint8_t) 0;
+	dmx_send_is_writing = false;
+	dmx_send_is_pending = false;
+
 	irq_timer_init();
 
 	pl011_init();
@@ -0,0 +1,304 @@
+/**
+ * @file dmx_receive_state.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef LOGIC_ANALYZER
+#include "bcm2835_gpio.h"
+#include "gpio.h"
+#endif
+
+#include "dmx.h"
+#include "dmx_receive_state.h"
+#include "rdm.h"
+#include "rdm_e120.h"
+
+/**
+ * @ingroup dmx
+ *
+ * Reset the receive state machine and empty the rings. The receive depth is kept,
+ * a ring which is not configured yet gets all \ref DMX_DATA_BUFFER_INDEX_ENTRIES.
+ *
+ * @param r
+ */
+void dmx_receive_init(struct _dmx_receive *r) {
+	if (r->dmx_data_buffer_index_mask == (uint16_t) 0) {
+		r->dmx_data_buffer_index_mask = DMX_DATA_BUFFER_INDEX_ENTRIES - 1;
+	}
+
+	r->dmx_data_buffer_index_head = (uint16_t) 0;
+	r->dmx_data_buffer_index_tail = (uint16_t) 0;
+	r->dmx_is_overrun = false;
+
+	r->rdm_data_buffer_index_head = (uint16_t) 0;
+	r->rdm_data_buffer_index_tail = (uint16_t) 0;
+
+	r->dmx_receive_state = IDLE;
+	r->dmx_data_index = (uint16_t) 0;
+	r->dmx_is_previous_break_dmx = false;
+}
+
+/**
+ * A DMX frame is received completely, hand it to the consumer.
+ * When the ring is full, the frame is dropped and the slot is used for the next frame.
+ * The frames waiting are never overwritten, the consumer might be reading these.
+ */
+inline static void dmx_data_buffer_index_next(struct _dmx_receive *r) {
+	const uint16_t next = (r->dmx_data_buffer_index_head + 1) & r->dmx_data_buffer_index_mask;
+
+	if (next == r->dmx_data_buffer_index_tail) {
+		if (!r->dmx_is_overrun) {
+			r->dmx_is_overrun = true;
+			r->total_statistics.dmx_overruns = r->total_statistics.dmx_overruns + 1;
+		}
+		r->total_statistics.dmx_packets_dropped = r->total_statistics.dmx_packets_dropped + 1;
+		return;
+	}
+
+	r->dmx_data_buffer_index_head = next;
+	r->dmx_is_overrun = false;
+
+	const uint32_t waiting = (uint32_t) ((next - r->dmx_data_buffer_index_tail) & r->dmx_data_buffer_index_mask);
+
+	if (waiting > r->total_statistics.dmx_high_water) {
+		r->total_statistics.dmx_high_water = waiting;
+	}
+}
+
+/**
+ * @ingroup dmx
+ *
+ * Consume a single event of the line : a BREAK, or a byte received.
+ *
+ * @param r
+ * @param micros Timestamp of the event
+ * @param data The byte received, not used for a BREAK
+ * @param is_break
+ * @return true when the end of the DMX packet must be checked at r->timeout_micros, see \ref dmx_receive_timeout
+ */
+bool dmx_receive_byte(struct _dmx_receive *r, const uint32_t micros, const uint8_t data, const bool is_break) {
+	bool is_timeout = false;
+
+	if (is_break) {
+		r->dmx_receive_state = BREAK;
+		r->dmx_break_to_break_latest = micros;
+#ifdef LOGIC_ANALYZER
+		bcm2835_gpio_set(GPIO_ANALYZER_CH2);	// BREAK
+		bcm2835_gpio_clr(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+		r->dmx_micros_previous = micros;
+		return false;
+	}
+
+	struct _dmx_data *dmx = &r->dmx_data[r->dmx_data_buffer_index_head];
+	uint8_t *rdm = &r->rdm_data_buffer[r->rdm_data_buffer_index_head][0];
+
+	switch (r->dmx_receive_state) {
+	case IDLE:
+		if (data == 0xFE) {
+			r->dmx_receive_state = RDMDISCFE;
+			rdm[0] = 0xFE;
+			r->dmx_data_index = 1;
+		}
+		break;
+	case BREAK:
+		switch (data) {
+		case DMX512_START_CODE:
+			r->dmx_receive_state = DMXDATA;
+			dmx->data[0] = DMX512_START_CODE;
+			r->dmx_data_index = 1;
+			r->total_statistics.dmx_packets = r->total_statistics.dmx_packets + 1;
+			r->dmx_start_code_micros = micros;
+			dmx->statistics.break_to_start_code = micros - r->dmx_break_to_break_latest;
+			if (r->dmx_is_previous_break_dmx) {
+				dmx->statistics.break_to_break = r->dmx_break_to_break_latest - r->dmx_break_to_break_previous;
+				r->dmx_break_to_break_previous = r->dmx_break_to_break_latest;
+			} else {
+				r->dmx_is_previous_break_dmx = true;
+				r->dmx_break_to_break_previous = r->dmx_break_to_break_latest;
+				dmx->statistics.break_to_break = 0;
+			}
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_clr(GPIO_ANALYZER_CH2);	// BREAK
+			bcm2835_gpio_set(GPIO_ANALYZER_CH3);	// DMX DATA
+#endif
+			break;
+		case E120_SC_RDM:
+			r->dmx_receive_state = RDMDATA;
+			rdm[0] = E120_SC_RDM;
+			r->rdm_checksum = E120_SC_RDM;
+			r->dmx_data_index = 1;
+			r->total_statistics.rdm_packets = r->total_statistics.rdm_packets + 1;
+			r->dmx_is_previous_break_dmx = false;
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_clr(GPIO_ANALYZER_CH2);	// BREAK
+			bcm2835_gpio_set(GPIO_ANALYZER_CH3);	// DMX DATA
+#endif
+			break;
+		default:
+			r->dmx_receive_state = IDLE;
+			r->dmx_is_previous_break_dmx = false;
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_clr(GPIO_ANALYZER_CH2);	// BREAK
+			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+			break;
+		}
+		break;
+	case DMXDATA:
+		dmx->statistics.slot_to_slot = micros - r->dmx_micros_previous;
+		if (dmx->statistics.slot_to_slot < 44) { // Broadcom BUG ? FIQ is late
+			dmx->statistics.slot_to_slot = (uint32_t) 44;
+		}
+		dmx->data[r->dmx_data_index++] = data;
+		if (r->dmx_data_index > DMX_UNIVERSE_SIZE) {
+			r->dmx_receive_state = IDLE;
+			dmx->statistics.slots_in_packet = DMX_UNIVERSE_SIZE;
+			dmx->statistics.slots_time = micros - r->dmx_start_code_micros;
+			dmx_data_buffer_index_next(r);
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_clr(GPIO_ANALYZER_CH3);	// DMX DATA
+			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+		} else {
+			r->timeout_micros = micros + dmx->statistics.slot_to_slot + (uint32_t) 12;
+			is_timeout = true;
+		}
+		break;
+	case RDMDATA:
+		if (r->dmx_data_index > RDM_DATA_BUFFER_SIZE) {
+			r->dmx_receive_state = IDLE;
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+		} else {
+			rdm[r->dmx_data_index++] = data;
+			r->rdm_checksum += data;
+
+			const struct _rdm_command *p = (struct _rdm_command *) rdm;
+			if (r->dmx_data_index == p->message_length) {
+				r->dmx_receive_state = CHECKSUMH;
+			}
+		}
+		break;
+	case CHECKSUMH:
+		rdm[r->dmx_data_index++] = data;
+		r->rdm_checksum -= data << 8;
+		r->dmx_receive_state = CHECKSUML;
+		break;
+	case CHECKSUML: {
+		rdm[r->dmx_data_index++] = data;
+		r->rdm_checksum -= data;
+		const struct _rdm_command *p = (struct _rdm_command *) rdm;
+		if ((r->rdm_checksum == 0) && (p->sub_start_code == E120_SC_SUB_MESSAGE)) {
+			r->rdm_data_buffer_index_head = (r->rdm_data_buffer_index_head + 1) & RDM_DATA_BUFFER_INDEX_MASK;
+			r->rdm_data_receive_end = micros;
+		}
+		r->dmx_receive_state = IDLE;
+#ifdef LOGIC_ANALYZER
+		bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+		}
+		break;
+	case RDMDISCFE:
+		switch (data) {
+		case 0xFE:
+			rdm[r->dmx_data_index++] = 0xFE;
+			break;
+		case 0xAA:
+			rdm[r->dmx_data_index++] = 0xAA;
+			r->dmx_receive_state = RDMDISCEUID;
+			r->rdm_disc_index = 0;
+			break;
+		default:
+			r->dmx_receive_state = IDLE;
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+			break;
+		}
+		break;
+	case RDMDISCEUID:
+		rdm[r->dmx_data_index++] = data;
+		r->rdm_disc_index++;
+		if (r->rdm_disc_index == 2 * RDM_UID_SIZE) {
+			r->dmx_receive_state = RDMDISCECS;
+			r->rdm_disc_index = 0;
+		}
+		break;
+	case RDMDISCECS:
+		rdm[r->dmx_data_index++] = data;
+		r->rdm_disc_index++;
+		if (r->rdm_disc_index == 4) {
+			r->rdm_data_buffer_index_head = (r->rdm_data_buffer_index_head + 1) & RDM_DATA_BUFFER_INDEX_MASK;
+			r->dmx_receive_state = IDLE;
+			r->rdm_data_receive_end = micros;
+#ifdef LOGIC_ANALYZER
+			bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+		}
+		break;
+	default:
+		break;
+	}
+
+	r->dmx_micros_previous = micros;
+
+	return is_timeout;
+}
+
+/**
+ * @ingroup dmx
+ *
+ * The DMX packet has ended when there is no slot received within the slot to slot time.
+ *
+ * @param r
+ * @param micros
+ * @return true when the end of the DMX packet must be checked again at r->timeout_micros
+ */
+bool dmx_receive_timeout(struct _dmx_receive *r, const uint32_t micros) {
+	if (r->dmx_receive_state != DMXDATA) {
+		return false;
+	}
+
+	struct _dmx_data *dmx = &r->dmx_data[r->dmx_data_buffer_index_head];
+
+	if (micros - r->dmx_micros_previous > dmx->statistics.slot_to_slot) {
+		r->dmx_receive_state = IDLE;
+		dmx->statistics.slots_in_packet = r->dmx_data_index - 1;
+		dmx->statistics.slots_time = r->dmx_micros_previous - r->dmx_start_code_micros;
+		dmx_data_buffer_index_next(r);
+#ifdef LOGIC_ANALYZER
+		bcm2835_gpio_clr(GPIO_ANALYZER_CH3);	// DMX DATA
+		bcm2835_gpio_set(GPIO_ANALYZER_CH4);	// IDLE
+#endif
+		return false;
+	}
+
+	r->timeout_micros = micros + dmx->statistics.slot_to_slot;
+
+	return true;
+}
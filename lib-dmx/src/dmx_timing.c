@@ -0,0 +1,140 @@
+/**
+ * @file dmx_timing.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "dmx.h"
+#include "dmx_timing.h"
+
+/**
+ * The analyzer runs on the timestamps taken by the receive FIQ, which are stored with each packet.
+ * It is updated from \ref dmx_get_available, so there is nothing added to the FIQ.
+ */
+static struct _dmx_timing dmx_timing = {
+		{ 0, 0, 0, 0, 96, 32, { 0 } },		// From 88 us BREAK + 8 us MAB
+		{ 0, 0, 0, 0, 44, 4, { 0 } },		// From 44 us, the time of a slot at 250 kbit/s
+		{ 0, 0, 0, 0, 4, 4, { 0 } }			// Hz
+};
+
+/**
+ *
+ * @param histogram
+ * @param value
+ */
+inline static void histogram_add(struct _dmx_timing_histogram *histogram, const uint32_t value) {
+	uint32_t bin;
+
+	if (histogram->count == 0) {
+		histogram->min = value;
+		histogram->max = value;
+	} else if (value < histogram->min) {
+		histogram->min = value;
+	} else if (value > histogram->max) {
+		histogram->max = value;
+	}
+
+	histogram->count++;
+	histogram->sum += value;
+
+	if (value < histogram->bin_low) {
+		bin = 0;
+	} else {
+		bin = 1 + ((value - histogram->bin_low) / histogram->bin_width);
+
+		if (bin > DMX_TIMING_HISTOGRAM_BINS - 1) {
+			bin = DMX_TIMING_HISTOGRAM_BINS - 1;
+		}
+	}
+
+	histogram->bins[bin]++;
+}
+
+/**
+ *
+ * @param histogram
+ */
+inline static void histogram_reset(struct _dmx_timing_histogram *histogram) {
+	uint32_t i;
+
+	histogram->count = 0;
+	histogram->min = 0;
+	histogram->max = 0;
+	histogram->sum = 0;
+
+	for (i = 0; i < DMX_TIMING_HISTOGRAM_BINS; i++) {
+		histogram->bins[i] = 0;
+	}
+}
+
+/**
+ * @ingroup dmx
+ *
+ */
+void dmx_timing_reset(void) {
+	histogram_reset(&dmx_timing.break_mab);
+	histogram_reset(&dmx_timing.slot_to_slot);
+	histogram_reset(&dmx_timing.refresh_rate);
+}
+
+/**
+ * @ingroup dmx
+ *
+ * @param statistics The statistics of a received DMX packet
+ */
+void dmx_timing_add(const struct _dmx_statistics *statistics) {
+	histogram_add(&dmx_timing.break_mab, statistics->break_to_start_code);
+
+	if (statistics->slots_in_packet != 0) {
+		histogram_add(&dmx_timing.slot_to_slot, statistics->slots_time / statistics->slots_in_packet);
+	}
+
+	if (statistics->break_to_break != 0) {
+		histogram_add(&dmx_timing.refresh_rate, (uint32_t) 1000000 / statistics->break_to_break);
+	}
+}
+
+/**
+ * @ingroup dmx
+ *
+ * @return
+ */
+const struct _dmx_timing *dmx_timing_get(void) {
+	return &dmx_timing;
+}
+
+/**
+ * @ingroup dmx
+ *
+ * @param histogram
+ * @return 0 when there are no values
+ */
+const uint32_t dmx_timing_get_mean(const struct _dmx_timing_histogram *histogram) {
+	if (histogram->count == 0) {
+		return 0;
+	}
+
+	return (uint32_t) (histogram->sum / histogram->count);
+}
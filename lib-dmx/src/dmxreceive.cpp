@@ -0,0 +1,95 @@
+/**
+ * @file dmxreceive.cpp
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dmx.h"
+#include "dmxreceive.h"
+#include "util.h"
+
+/**
+ *
+ */
+DMXReceive::DMXReceive(void) : m_nLength(0) {
+	dmx_init();
+}
+
+/**
+ *
+ */
+DMXReceive::~DMXReceive(void) {
+	this->Stop();
+}
+
+/**
+ *
+ */
+void DMXReceive::Start(void) {
+	dmx_set_port_direction(DMX_PORT_DIRECTION_INP, true);
+}
+
+/**
+ *
+ */
+void DMXReceive::Stop(void) {
+	dmx_set_port_direction(DMX_PORT_DIRECTION_INP, false);
+}
+
+/**
+ * There is one DMX input, port 0.
+ *
+ * @param nPort
+ * @param pLength
+ * @param pIsChanged
+ * @return
+ */
+const uint8_t *DMXReceive::GetData(const uint8_t nPort, uint16_t *pLength, bool *pIsChanged) {
+	*pIsChanged = false;
+
+	if (nPort != 0) {
+		return 0;
+	}
+
+	const uint8_t *p = dmx_is_data_changed();
+
+	if (p != 0) {
+		const struct _dmx_data *dmx_data = (struct _dmx_data *)p;
+		const uint16_t nLength = (uint16_t) MIN(dmx_data->statistics.slots_in_packet, (uint32_t) DMX_UNIVERSE_SIZE);
+
+		(void *)memcpy(m_Data, &p[1], (size_t)nLength);
+
+		m_nLength = nLength;
+		*pIsChanged = true;
+	}
+
+	if (m_nLength == 0) {
+		return 0;
+	}
+
+	*pLength = m_nLength;
+
+	return m_Data;
+}
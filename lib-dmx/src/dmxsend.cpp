@@ -56,12 +56,18 @@ static uint32_t m_OutputPeriod = DMX_TRANSMIT_PERIOD_DEFAULT;
 static uint32_t m_OutputPeriodRequested = DMX_TRANSMIT_PERIOD_DEFAULT;
 static uint16_t m_OutputDataLength = DMX_UNIVERSE_SIZE + 1;
 
-static uint8_t m_OutputBuffer[DMX_DATA_BUFFER_SIZE] ALIGNED;	///< SC + UNIVERSE SIZE
+static uint8_t m_OutputBuffer[2][DMX_DATA_BUFFER_SIZE] ALIGNED;	///< SC + UNIVERSE SIZE, front (sent) and back (written) buffer
+static volatile unsigned m_nFront;								///<
+static volatile uint16_t m_SendDataLength = DMX_UNIVERSE_SIZE + 1;	///< The length of the front buffer
+static volatile bool m_IsWriting;								///< The back buffer is being written
+static volatile bool m_IsPending;								///< The back buffer holds a frame not sent yet
 
 static volatile TDMXSendState m_State = DMXSendIdle;
 static volatile uint32_t m_SendBreakMicros;
 static volatile unsigned m_CurrentSlot;
 
+static volatile struct _dmx_send_statistics m_SendStatistics;
+
 /**
  * Timer interrupt
  */
@@ -80,6 +86,12 @@ void __attribute__((interrupt("IRQ"))) c_irq_handler(void) {
 		BCM2835_ST->C1 = m_TimerIRQMicros + m_OutputBreakTime;
 		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2 | PL011_LCRH_FEN | PL011_LCRH_BRK;
 		m_SendBreakMicros = m_TimerIRQMicros;
+		// Swap the buffers, unless the back buffer is being written. Then the previous frame is repeated.
+		if (m_IsPending && !m_IsWriting) {
+			m_nFront = m_nFront ^ 1;
+			m_SendDataLength = m_OutputDataLength;
+			m_IsPending = false;
+		}
 		dmb();
 		m_State = DMXSendBreak;
 		break;
@@ -91,16 +103,17 @@ void __attribute__((interrupt("IRQ"))) c_irq_handler(void) {
 		break;
 	case DMXSendMAB:
 		BCM2835_ST->C1 = m_SendBreakMicros + m_OutputPeriod;
+		m_SendStatistics.frames++;
 
 		for (m_CurrentSlot = 0; !(BCM2835_PL011->FR & PL011_FR_TXFF); m_CurrentSlot++) {
-			if (m_CurrentSlot >= m_OutputDataLength) {
+			if (m_CurrentSlot >= m_SendDataLength) {
 				break;
 			}
 
-			BCM2835_PL011->DR = m_OutputBuffer[m_CurrentSlot];
+			BCM2835_PL011->DR = m_OutputBuffer[m_nFront][m_CurrentSlot];
 		}
 
-		if (m_CurrentSlot < m_OutputDataLength) {
+		if (m_CurrentSlot < m_SendDataLength) {
 			m_State = DMXSendData;
 			BCM2835_PL011->IMSC = BCM2835_PL011->IMSC | PL011_IMSC_TXIM;
 		} else {
@@ -110,7 +123,7 @@ void __attribute__((interrupt("IRQ"))) c_irq_handler(void) {
 		break;
 	case DMXSendData:
 		printf("Output period too short (brk %d, mab %d, period %d, dlen %d, slot %d)\n",
-				(int)m_OutputBreakTime, (int)m_OutputMabTime, (int)m_OutputPeriod, (int)m_OutputDataLength, (int)m_CurrentSlot);
+				(int)m_OutputBreakTime, (int)m_OutputMabTime, (int)m_OutputPeriod, (int)m_SendDataLength, (int)m_CurrentSlot);
 		assert (0);
 		break;
 	default:
@@ -118,6 +131,7 @@ void __attribute__((interrupt("IRQ"))) c_irq_handler(void) {
 		break;
 	}
 
+	m_SendStatistics.irq_micros += BCM2835_ST->CLO - m_TimerIRQMicros;
 #ifdef DEBUG
 	bcm2835_gpio_clr(21);
 #endif
@@ -132,25 +146,29 @@ void __attribute__((interrupt("FIQ"))) c_fiq_handler(void) {
 #ifdef DEBUG
 	bcm2835_gpio_set(20);
 #endif
+	const uint32_t nMicros = BCM2835_ST->CLO;
+
 	assert(m_State == DMXSendData);
 
 	if (BCM2835_PL011->MIS == PL011_MIS_TXMIS) {
 
 		for (; !(BCM2835_PL011->FR & PL011_FR_TXFF); m_CurrentSlot++) {
-			if (m_CurrentSlot >= m_OutputDataLength) {
+			if (m_CurrentSlot >= m_SendDataLength) {
 				break;
 			}
 
-			BCM2835_PL011->DR = m_OutputBuffer[m_CurrentSlot];
+			BCM2835_PL011->DR = m_OutputBuffer[m_nFront][m_CurrentSlot];
 		}
 
-		if (m_CurrentSlot >= m_OutputDataLength) {
+		if (m_CurrentSlot >= m_SendDataLength) {
 			BCM2835_PL011->IMSC = BCM2835_PL011->IMSC & ~ PL011_IMSC_TXIM;
 			m_State = DMXSendInterPacket;
 		}
 
 		BCM2835_PL011->ICR = PL011_ICR_TXIC;
 	}
+
+	m_SendStatistics.irq_micros += BCM2835_ST->CLO - nMicros;
 #ifdef DEBUG
 	bcm2835_gpio_clr(20);
 #endif
@@ -396,43 +414,70 @@ void DMXSend::SetPeriodTime(const uint32_t period) {
  */
 void DMXSend::ClearOutputData(void) {
 	for (unsigned i = 0; i < DMX_DATA_BUFFER_SIZE; i++) {
-		m_OutputBuffer[i] = 0;
+		m_OutputBuffer[0][i] = 0;
+		m_OutputBuffer[1][i] = 0;
 	}
 }
 
 /**
  *
+ * @param nPortId
  * @param data
  * @param length
- * @return
  */
-bool DMXSend::SetDataTry(const uint8_t *data, const uint16_t length) {
-	assert(length <= DMX_UNIVERSE_SIZE);
-
-	if (m_State != DMXSendIdle && m_State != DMXSendInterPacket) {
-		return false;
-	}
 
-	(void *)memcpy(&m_OutputBuffer[1], data, (size_t)length);
-
-	SetDataLength(length+1);
+void DMXSend::SetData(const uint8_t nPortId, const uint8_t *data, const uint16_t length) {
+	SetDataRange(nPortId, data, length, 0, length);
 
-	return true;
+#if DEBUG_
+	monitor_line(MONITOR_LINE_STATS, "%d-%x:%x:%x-%d", nPortId, data[0], data[1], data[2], length);
+#endif
 }
 
 /**
+ * Only the changed slots are copied to the back buffer, which becomes the front buffer at the start of the next BREAK.
+ * The frame being sent is never changed, and there is no waiting for the interrupts.
+ * A frame which is replaced before it is sent is counted as superseded.
  *
  * @param nPortId
  * @param data
  * @param length
+ * @param offset First changed slot
+ * @param count Number of changed slots
  */
+void DMXSend::SetDataRange(const uint8_t nPortId, const uint8_t *data, const uint16_t length, const uint16_t offset, const uint16_t count) {
+	assert(length <= DMX_UNIVERSE_SIZE);
+	assert(offset + count <= length);
 
-void DMXSend::SetData(const uint8_t nPortId, const uint8_t *data, const uint16_t length) {
-	while (!SetDataTry (data, length)) {
-		// just wait
+	m_IsWriting = true;
+	dmb();
+
+	uint8_t *pBack = m_OutputBuffer[m_nFront ^ 1];
+
+	if (m_IsPending) {
+		m_SendStatistics.frames_superseded++;
+	} else if (count != length) {
+		// The back buffer holds the frame sent before the front buffer, the unchanged slots are taken from the front buffer
+		(void *)memcpy(pBack, m_OutputBuffer[m_nFront], (size_t)DMX_DATA_BUFFER_SIZE);
 	}
 
-#if DEBUG_
-	monitor_line(MONITOR_LINE_STATS, "%d-%x:%x:%x-%d", nPortId, data[0], data[1], data[2], length);
-#endif
+	(void *)memcpy(&pBack[1 + offset], &data[offset], (size_t)count);
+
+	if (m_OutputDataLength != length + 1) {
+		SetDataLength(length + 1);
+	}
+
+	dmb();
+	m_IsPending = true;
+	m_IsWriting = false;
+	dmb();
+}
+
+/**
+ * The time spent for sending DMX, the CPU headroom is what is left of each second.
+ *
+ * @return
+ */
+const volatile struct _dmx_send_statistics *DMXSend::GetSendStatistics(void) {
+	return &m_SendStatistics;
 }
@@ -0,0 +1,668 @@
+/**
+ * @file dmxsendmulti.cpp
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "arm/synchronize.h"
+#include "bcm2835.h"
+#include "bcm2835_gpio.h"
+#include "bcm2835_vc.h"
+#include "bcm2835_aux.h"
+#include "bcm2835_uart.h"
+#include "arm/pl011.h"
+
+#include "irq_timer.h"
+
+#include "device_info.h"
+#include "sc16is7x0.h"
+#include "sc16is740.h"
+
+#include "dmx.h"
+#include "dmxsendmulti.h"
+#include "util.h"
+
+#define DMX_MULTI_BAUDRATE		250000
+
+/**
+ * The FIFO is refilled when about half of it is sent, at 44 us per slot
+ */
+#define PL011_REFILL_MICROS		(8 * 44)
+#define SC16IS740_REFILL_MICROS	((SC16IS7X0_FIFO_SIZE / 2) * 44)
+
+/**
+ * The mini UART has 1 stop bit only, so a slot takes 40 us. The slots are written one by one,
+ * 44 us apart, and the MARK between the slots makes the second stop bit. Plus 4 us for the interrupt latency.
+ */
+#define MINI_UART_SLOT_MICROS	(44 + 4)
+
+#define BUSY_RETRY_MICROS		44			///< The last slot of the previous frame is still shifted out
+#define STOP_POLL_MICROS		1000		///<
+
+enum TDMXMultiPortState {
+	DMX_MULTI_PORT_IDLE,
+	DMX_MULTI_PORT_BREAK,
+	DMX_MULTI_PORT_MAB,
+	DMX_MULTI_PORT_DATA
+};
+
+struct TDMXMultiPort {
+	uint8_t OutputBuffer[2][DMX_DATA_BUFFER_SIZE] ALIGNED;	///< SC + UNIVERSE SIZE, front (sent) and back (written) buffer
+	device_info_t Device;						///< SC16IS740 only
+	TDMXMultiUart tUart;						///<
+	uint32_t nBreakTime;						///<
+	uint32_t nMabTime;							///<
+	uint32_t nPeriod;							///<
+	uint32_t nPeriodRequested;					///<
+	uint32_t nRefillMicros;						///<
+	uint16_t nOutputDataLength;					///< The length of the back buffer
+	volatile uint16_t nSendDataLength;			///< The length of the front buffer
+	volatile uint16_t nCurrentSlot;				///<
+	volatile unsigned nFront;					///<
+	volatile bool IsWriting;					///< The back buffer is being written
+	volatile bool IsPending;					///< The back buffer holds a frame not sent yet
+	volatile TDMXMultiPortState tState;			///<
+	volatile uint32_t nNextMicros;				///< Time of the next event of this port
+	volatile uint32_t nBreakMicros;				///< Start of the BREAK of the frame being sent
+};
+
+static struct TDMXMultiPort m_Ports[DMX_MULTI_MAX_PORTS] ALIGNED;
+static uint8_t m_nPorts;
+static volatile bool m_IsStarted;
+static volatile bool m_IsStopping;
+
+static volatile struct _dmx_send_statistics m_SendStatistics;
+
+/**
+ *
+ * @param pPort
+ * @param IsBreak
+ */
+inline static void uart_set_break(const struct TDMXMultiPort *pPort, const bool IsBreak) {
+	switch (pPort->tUart) {
+	case DMX_MULTI_UART_PL011:
+		BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2 | PL011_LCRH_FEN | (IsBreak ? PL011_LCRH_BRK : 0);
+		break;
+	case DMX_MULTI_UART_MINI:
+		BCM2835_UART1->LCR = UART1_LCR_8BITS | (IsBreak ? UART1_LCR_BREAK : 0);
+		break;
+	case DMX_MULTI_UART_SC16IS740:
+		sc16is740_reg_write(&pPort->Device, SC16IS7X0_LCR, LCR_BITS8 | LCR_BITS2 | LCR_NONE | (IsBreak ? LCR_BRK_ENA : LCR_BRK_DIS));
+		break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
+/**
+ *
+ * @param pPort
+ * @return true when the last slot is not shifted out yet
+ */
+inline static bool uart_is_busy(const struct TDMXMultiPort *pPort) {
+	switch (pPort->tUart) {
+	case DMX_MULTI_UART_PL011:
+		return (BCM2835_PL011->FR & PL011_FR_BUSY) != 0;
+	case DMX_MULTI_UART_MINI:
+		return (BCM2835_UART1->LSR & UART1_LSR_TEMT) == 0;
+	case DMX_MULTI_UART_SC16IS740:
+		return (sc16is740_reg_read(&pPort->Device, SC16IS7X0_LSR) & LSR_TEMT) == 0;
+	default:
+		assert(0);
+		break;
+	}
+
+	return false;
+}
+
+/**
+ * Write the slots of the front buffer until the FIFO is full.
+ *
+ * @param pPort
+ * @return true when all slots are written
+ */
+inline static bool uart_fill_fifo(struct TDMXMultiPort *pPort) {
+	const uint8_t *pData = pPort->OutputBuffer[pPort->nFront];
+	const uint16_t nLength = pPort->nSendDataLength;
+	uint16_t nSlot = pPort->nCurrentSlot;
+
+	switch (pPort->tUart) {
+	case DMX_MULTI_UART_PL011:
+		while ((nSlot < nLength) && !(BCM2835_PL011->FR & PL011_FR_TXFF)) {
+			BCM2835_PL011->DR = pData[nSlot++];
+		}
+		break;
+	case DMX_MULTI_UART_MINI:
+		if ((nSlot < nLength) && (BCM2835_UART1->LSR & UART1_LSR_TEMT)) {
+			BCM2835_UART1->IO = pData[nSlot++];
+		}
+		break;
+	case DMX_MULTI_UART_SC16IS740: {
+		const int nWritten = sc16is740_write(&pPort->Device, &pData[nSlot], (unsigned) (nLength - nSlot));
+		if (nWritten > 0) {
+			nSlot += (uint16_t) nWritten;
+		}
+	}
+		break;
+	default:
+		assert(0);
+		break;
+	}
+
+	pPort->nCurrentSlot = nSlot;
+
+	return nSlot >= nLength;
+}
+
+/**
+ * The BREAK, MAB and data of a single port. Returns with the time of the next event of the port.
+ *
+ * @param pPort
+ * @param nMicros
+ */
+inline static void port_run(struct TDMXMultiPort *pPort, const uint32_t nMicros) {
+	switch (pPort->tState) {
+	case DMX_MULTI_PORT_IDLE:
+		if (m_IsStopping) {
+			pPort->nNextMicros = nMicros + STOP_POLL_MICROS;
+			break;
+		}
+
+		if (uart_is_busy(pPort)) {
+			pPort->nNextMicros = nMicros + BUSY_RETRY_MICROS;
+			break;
+		}
+
+		// Swap the buffers, unless the back buffer is being written. Then the previous frame is repeated.
+		if (pPort->IsPending && !pPort->IsWriting) {
+			pPort->nFront = pPort->nFront ^ 1;
+			pPort->nSendDataLength = pPort->nOutputDataLength;
+			pPort->IsPending = false;
+		}
+
+		uart_set_break(pPort, true);
+		pPort->nBreakMicros = nMicros;
+		pPort->nNextMicros = nMicros + pPort->nBreakTime;
+		pPort->tState = DMX_MULTI_PORT_BREAK;
+		break;
+	case DMX_MULTI_PORT_BREAK:
+		uart_set_break(pPort, false);
+		pPort->nNextMicros = nMicros + pPort->nMabTime;
+		pPort->tState = DMX_MULTI_PORT_MAB;
+		break;
+	case DMX_MULTI_PORT_MAB:
+		pPort->nCurrentSlot = 0;
+		m_SendStatistics.frames++;
+		/* no break */
+	case DMX_MULTI_PORT_DATA:
+		if (uart_fill_fifo(pPort)) {
+			pPort->nNextMicros = pPort->nBreakMicros + pPort->nPeriod;
+			// The last slot has its MARK too, before the BREAK
+			if ((pPort->tUart == DMX_MULTI_UART_MINI) && ((int32_t) (pPort->nNextMicros - (nMicros + MINI_UART_SLOT_MICROS)) < 0)) {
+				pPort->nNextMicros = nMicros + MINI_UART_SLOT_MICROS;
+			}
+			pPort->tState = DMX_MULTI_PORT_IDLE;
+		} else {
+			pPort->nNextMicros = nMicros + pPort->nRefillMicros;
+			pPort->tState = DMX_MULTI_PORT_DATA;
+		}
+		break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
+/**
+ * Timer 1 interrupt, all ports which are due are handled and the compare is set for the earliest next event.
+ *
+ * @param clo
+ */
+static void irq_timer1_dmx_multi(const uint32_t clo) {
+	uint32_t nNextMicros = clo + 1000000;
+	uint8_t i;
+
+	for (i = 0; i < m_nPorts; i++) {
+		struct TDMXMultiPort *pPort = &m_Ports[i];
+
+		// The SPI transfers take time, so the time is read again for each port
+		const uint32_t nMicros = BCM2835_ST->CLO;
+
+		if ((int32_t) (nMicros - pPort->nNextMicros) >= 0) {
+			port_run(pPort, nMicros);
+		}
+
+		if ((int32_t) (pPort->nNextMicros - nNextMicros) < 0) {
+			nNextMicros = pPort->nNextMicros;
+		}
+	}
+
+	const uint32_t nMicros = BCM2835_ST->CLO;
+
+	// The compare only matches when it is ahead of the counter
+	if ((int32_t) (nNextMicros - nMicros) < 4) {
+		nNextMicros = nMicros + 4;
+	}
+
+	BCM2835_ST->C1 = nNextMicros;
+
+	m_SendStatistics.irq_micros += nMicros - clo;
+
+	dmb();
+}
+
+/**
+ *
+ */
+static void pl011_init(void) {
+	uint32_t value;
+
+	(void) bcm2835_vc_set_clock_rate(BCM2835_VC_CLOCK_ID_UART, 4000000);// Set UART clock rate to 4000000 (4MHz)
+
+	dmb();
+
+	BCM2835_PL011->CR = 0;												// Disable everything
+	value = BCM2835_GPIO->GPFSEL1;
+	value &= ~(7 << 12);
+	value |= BCM2835_GPIO_FSEL_ALT0 << 12;								// Pin 14 PL011_TXD
+	BCM2835_GPIO->GPFSEL1 = value;
+
+	bcm2835_gpio_set_pud(RPI_V2_GPIO_P1_08, BCM2835_GPIO_PUD_OFF);		// Disable pull-up/down
+
+	dmb();
+
+	BCM2835_PL011->IMSC = (uint32_t) 0;
+
+	// Poll the "flags register" to wait for the UART to stop transmitting or receiving
+	while ((BCM2835_PL011->FR & PL011_FR_BUSY) != 0);
+
+	// Flush the transmit FIFO by marking FIFOs as disabled in the "line control register"
+	BCM2835_PL011->LCRH &= ~PL011_LCRH_FEN;
+
+	// Clear all interrupt status
+	BCM2835_PL011->ICR = 0x7FF;
+
+	// UART Clock 4000000 (4MHz) , 250000 Bps
+	BCM2835_PL011->IBRD = 1;
+	BCM2835_PL011->FBRD = 0;
+
+	// Set 8, N, 2, FIFO enabled
+	BCM2835_PL011->LCRH = PL011_LCRH_WLEN8 | PL011_LCRH_STP2 | PL011_LCRH_FEN;
+
+	// Enable UART, TX only
+	BCM2835_PL011->CR = PL011_CR_TXE | PL011_CR_UARTEN;
+
+	dmb();
+}
+
+/**
+ * The mini UART is clocked by the core clock, which must not change (core_freq fixed in config.txt).
+ */
+static void mini_uart_init(void) {
+	uint32_t value;
+	int32_t core_clock = bcm2835_vc_get_clock_rate(BCM2835_VC_CLOCK_ID_CORE);
+
+	if (core_clock <= 0) {
+		core_clock = 250000000;
+	}
+
+	dmb();
+
+	BCM2835_AUX->ENABLE = BCM2835_AUX->ENABLE | BCM2835_AUX_ENABLE_UART1;
+	BCM2835_UART1->CNTL = 0x00;
+	BCM2835_UART1->LCR = UART1_LCR_8BITS;
+	BCM2835_UART1->MCR = 0x00;
+	BCM2835_UART1->IER = 0x00;
+	BCM2835_UART1->IIR = 0xC6;
+	BCM2835_UART1->BAUD = (uint32_t) core_clock / (8 * DMX_MULTI_BAUDRATE) - 1;	// Baud rate = sysclk/(8*(BAUD_REG+1))
+
+	value = BCM2835_GPIO->GPFSEL1;
+	value &= ~(7 << 12);
+	value |= BCM2835_GPIO_FSEL_ALT5 << 12;								// Pin 14 UART1_TXD
+	BCM2835_GPIO->GPFSEL1 = value;
+
+	bcm2835_gpio_set_pud(RPI_V2_GPIO_P1_08, BCM2835_GPIO_PUD_OFF);		// Disable pull-up/down
+
+	BCM2835_UART1->CNTL = UART1_CNTL_TRN_ENBL;							// TX only
+
+	dmb();
+}
+
+/**
+ *
+ * @param pDevice
+ * @return false when there is no SC16IS740 at the chip select
+ */
+static bool sc16is740_init(device_info_t *pDevice) {
+	sc16is740_start(pDevice);
+
+	if (!sc16is740_is_connected(pDevice)) {
+		return false;
+	}
+
+	sc16is740_set_baud(pDevice, DMX_MULTI_BAUDRATE);
+	sc16is740_set_format(pDevice, 8, SERIAL_PARITY_NONE, 2);
+	sc16is740_reg_write(pDevice, SC16IS7X0_FCR, 0x07);	// Enable the FIFO, reset RX and TX
+
+	return true;
+}
+
+/**
+ *
+ */
+DMXSendMulti::DMXSendMulti(void) {
+	m_nPorts = 0;
+	m_IsStarted = false;
+	m_IsStopping = false;
+
+	irq_timer_init();
+}
+
+/**
+ *
+ */
+DMXSendMulti::~DMXSendMulti(void) {
+	Stop();
+}
+
+/**
+ * The PL011 and the mini UART share the TXD pin (GPIO14), only one of these can be added.
+ *
+ * @param tUart
+ * @param nChipSelect SC16IS740 only
+ * @return false when the port cannot be added
+ */
+bool DMXSendMulti::AddPort(const TDMXMultiUart tUart, const uint8_t nChipSelect) {
+	if (m_IsStarted || (m_nPorts == DMX_MULTI_MAX_PORTS)) {
+		return false;
+	}
+
+	for (uint8_t i = 0; i < m_nPorts; i++) {
+		const TDMXMultiUart tOther = m_Ports[i].tUart;
+
+		if ((tUart != DMX_MULTI_UART_SC16IS740) && (tOther != DMX_MULTI_UART_SC16IS740)) {
+			return false;
+		}
+
+		if ((tUart == DMX_MULTI_UART_SC16IS740) && (tOther == DMX_MULTI_UART_SC16IS740) && (m_Ports[i].Device.chip_select == nChipSelect)) {
+			return false;
+		}
+	}
+
+	struct TDMXMultiPort *pPort = &m_Ports[m_nPorts];
+
+	(void *)memset(pPort, 0, sizeof(struct TDMXMultiPort));
+
+	pPort->tUart = tUart;
+
+	switch (tUart) {
+	case DMX_MULTI_UART_PL011:
+		pl011_init();
+		pPort->nRefillMicros = PL011_REFILL_MICROS;
+		break;
+	case DMX_MULTI_UART_MINI:
+		mini_uart_init();
+		pPort->nRefillMicros = MINI_UART_SLOT_MICROS;
+		break;
+	case DMX_MULTI_UART_SC16IS740:
+		pPort->Device.chip_select = nChipSelect;
+		pPort->Device.speed_hz = SC16IS7X0_SPI_SPEED_MAX_HZ;
+		if (!sc16is740_init(&pPort->Device)) {
+			return false;
+		}
+		pPort->nRefillMicros = SC16IS740_REFILL_MICROS;
+		break;
+	default:
+		return false;
+	}
+
+	pPort->nBreakTime = DMX_TRANSMIT_BREAK_TIME_MIN;
+	pPort->nMabTime = DMX_TRANSMIT_MAB_TIME_MIN;
+	pPort->nPeriod = DMX_TRANSMIT_PERIOD_DEFAULT;
+	pPort->nPeriodRequested = DMX_TRANSMIT_PERIOD_DEFAULT;
+	pPort->nOutputDataLength = DMX_UNIVERSE_SIZE + 1;
+	pPort->nSendDataLength = DMX_UNIVERSE_SIZE + 1;
+	pPort->tState = DMX_MULTI_PORT_IDLE;
+
+	m_nPorts++;
+
+	return true;
+}
+
+/**
+ *
+ * @return
+ */
+uint8_t DMXSendMulti::GetPorts(void) {
+	return m_nPorts;
+}
+
+/**
+ * The ports start one after the other, each with its own period.
+ */
+void DMXSendMulti::Start(void) {
+	if (m_IsStarted || (m_nPorts == 0)) {
+		return;
+	}
+
+	const uint32_t nMicros = BCM2835_ST->CLO;
+
+	for (uint8_t i = 0; i < m_nPorts; i++) {
+		m_Ports[i].tState = DMX_MULTI_PORT_IDLE;
+		m_Ports[i].nNextMicros = nMicros + 4;
+	}
+
+	m_IsStopping = false;
+	m_IsStarted = true;
+
+	dmb();
+
+	irq_timer_set(IRQ_TIMER_1, irq_timer1_dmx_multi);
+	BCM2835_ST->C1 = nMicros + 4;
+
+	dmb();
+}
+
+/**
+ * The frames being sent are completed.
+ */
+void DMXSendMulti::Stop(void) {
+	if (!m_IsStarted) {
+		return;
+	}
+
+	m_IsStopping = true;
+	dmb();
+
+	for (uint8_t i = 0; i < m_nPorts; i++) {
+		while (m_Ports[i].tState != DMX_MULTI_PORT_IDLE) {
+		}
+	}
+
+	irq_timer_set(IRQ_TIMER_1, NULL);
+
+	for (uint8_t i = 0; i < m_nPorts; i++) {
+		while (uart_is_busy(&m_Ports[i])) {
+		}
+	}
+
+	m_IsStarted = false;
+	dmb();
+}
+
+/**
+ *
+ * @param nPort
+ * @return
+ */
+uint32_t DMXSendMulti::GetBreakTime(const uint8_t nPort) {
+	assert(nPort < m_nPorts);
+
+	return m_Ports[nPort].nBreakTime;
+}
+
+/**
+ *
+ * @param nPort
+ * @param nBreakTime
+ */
+void DMXSendMulti::SetBreakTime(const uint8_t nPort, const uint32_t nBreakTime) {
+	assert(nPort < m_nPorts);
+
+	m_Ports[nPort].nBreakTime = MAX((uint32_t) DMX_TRANSMIT_BREAK_TIME_MIN, nBreakTime);
+
+	UpdatePeriodTime(nPort);	///< Recalculate output period for new BREAK time
+}
+
+/**
+ *
+ * @param nPort
+ * @return
+ */
+uint32_t DMXSendMulti::GetMabTime(const uint8_t nPort) {
+	assert(nPort < m_nPorts);
+
+	return m_Ports[nPort].nMabTime;
+}
+
+/**
+ *
+ * @param nPort
+ * @param nMabTime
+ */
+void DMXSendMulti::SetMabTime(const uint8_t nPort, const uint32_t nMabTime) {
+	assert(nPort < m_nPorts);
+
+	m_Ports[nPort].nMabTime = MAX((uint32_t) DMX_TRANSMIT_MAB_TIME_MIN, nMabTime);
+
+	UpdatePeriodTime(nPort);	///< Recalculate output period for new MAB time
+}
+
+/**
+ *
+ * @param nPort
+ * @return
+ */
+uint32_t DMXSendMulti::GetPeriodTime(const uint8_t nPort) {
+	assert(nPort < m_nPorts);
+
+	return m_Ports[nPort].nPeriod;
+}
+
+/**
+ *
+ * @param nPort
+ * @param nPeriod 0 is as fast as possible
+ */
+void DMXSendMulti::SetPeriodTime(const uint8_t nPort, const uint32_t nPeriod) {
+	assert(nPort < m_nPorts);
+
+	m_Ports[nPort].nPeriodRequested = nPeriod;
+
+	UpdatePeriodTime(nPort);
+}
+
+/**
+ * The period is never shorter than the BREAK, MAB and the slots take.
+ *
+ * @param nPort
+ */
+void DMXSendMulti::UpdatePeriodTime(const uint8_t nPort) {
+	struct TDMXMultiPort *pPort = &m_Ports[nPort];
+	const uint32_t slot_us = (pPort->tUart == DMX_MULTI_UART_MINI) ? MINI_UART_SLOT_MICROS : 44;
+	const uint32_t package_length_us = pPort->nBreakTime + pPort->nMabTime + (pPort->nOutputDataLength * slot_us);
+	const uint32_t period = pPort->nPeriodRequested;
+
+	if ((period != 0) && (period >= package_length_us)) {
+		pPort->nPeriod = period;
+	} else {
+		pPort->nPeriod = (uint32_t) MAX(DMX_TRANSMIT_BREAK_TO_BREAK_TIME_MIN, package_length_us + 44);
+	}
+}
+
+/**
+ *
+ * @param nPort
+ * @param data
+ * @param length
+ */
+void DMXSendMulti::SetData(const uint8_t nPort, const uint8_t *data, const uint16_t length) {
+	SetDataRange(nPort, data, length, 0, length);
+}
+
+/**
+ * As DMXSend::SetDataRange, for a single port.
+ *
+ * @param nPort
+ * @param data
+ * @param length
+ * @param offset First changed slot
+ * @param count Number of changed slots
+ */
+void DMXSendMulti::SetDataRange(const uint8_t nPort, const uint8_t *data, const uint16_t length, const uint16_t offset, const uint16_t count) {
+	assert(length <= DMX_UNIVERSE_SIZE);
+	assert(offset + count <= length);
+
+	if (nPort >= m_nPorts) {
+		return;
+	}
+
+	struct TDMXMultiPort *pPort = &m_Ports[nPort];
+
+	pPort->IsWriting = true;
+	dmb();
+
+	uint8_t *pBack = pPort->OutputBuffer[pPort->nFront ^ 1];
+
+	if (pPort->IsPending) {
+		m_SendStatistics.frames_superseded++;
+	} else if (count != length) {
+		// The back buffer holds the frame sent before the front buffer, the unchanged slots are taken from the front buffer
+		(void *)memcpy(pBack, pPort->OutputBuffer[pPort->nFront], (size_t)DMX_DATA_BUFFER_SIZE);
+	}
+
+	(void *)memcpy(&pBack[1 + offset], &data[offset], (size_t)count);
+
+	if (pPort->nOutputDataLength != length + 1) {
+		pPort->nOutputDataLength = length + 1;
+		UpdatePeriodTime(nPort);	///< Recalculate output period for new data length
+	}
+
+	dmb();
+	pPort->IsPending = true;
+	pPort->IsWriting = false;
+	dmb();
+}
+
+/**
+ * The statistics of all ports together.
+ *
+ * @return
+ */
+const volatile struct _dmx_send_statistics *DMXSendMulti::GetSendStatistics(void) {
+	return &m_SendStatistics;
+}
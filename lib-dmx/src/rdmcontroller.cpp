@@ -0,0 +1,587 @@
+/**
+ * @file rdmcontroller.cpp
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hardware.h"
+#include "util.h"
+
+#include "dmx.h"
+#include "rdm.h"
+#include "rdm_e120.h"
+#include "rdm_send.h"
+#include "rdmcontroller.h"
+
+#define RDM_CONTROLLER_DISCOVERY_TIMEOUT_MICROS	4500		///< 2.8 ms responder delay and a discovery response
+#define RDM_CONTROLLER_RESPONSE_TIMEOUT_MICROS	15000		///< 2.8 ms responder delay and a response of 257 slots
+#define RDM_CONTROLLER_REFRESH_SECONDS			60			///< Default time between the incremental discoveries
+#define RDM_CONTROLLER_MUTE_RETRIES				1			///< A device of the TOD is removed when it does not respond to the retry
+#define RDM_CONTROLLER_UID_MAX					0xFFFFFFFFFFFEULL	///< 0xFFFFFFFFFFFF is the broadcast UID
+
+#define RDM_DISCOVERY_PREAMBLE_MAX				7			///< Up to 7 preamble bytes of 0xFE
+#define RDM_DISCOVERY_SEPARATOR					0xAA		///<
+
+static uint64_t uid_to_u64(const uint8_t *uid) {
+	uint64_t n = 0;
+
+	for (unsigned i = 0; i < RDM_UID_SIZE; i++) {
+		n = (n << 8) | uid[i];
+	}
+
+	return n;
+}
+
+static void u64_to_uid(uint64_t n, uint8_t *uid) {
+	for (unsigned i = RDM_UID_SIZE; i-- > 0;) {
+		uid[i] = (uint8_t) (n & 0xFF);
+		n >>= 8;
+	}
+}
+
+/**
+ *
+ * @param pUid The UID of the controller
+ */
+RDMController::RDMController(const uint8_t *pUid) :
+		m_nTransactionNumber(0),
+		m_nResponsePort(0),
+		m_nResponseTag(0),
+		m_bIsResponseAvailable(false),
+		m_nRequestHead(0),
+		m_nRequestCount(0),
+		m_nUidCount(0),
+		m_bIsTodChanged(false),
+		m_tState(RDM_CONTROLLER_STATE_IDLE),
+		m_tStateResume(RDM_CONTROLLER_STATE_IDLE),
+		m_bIsDiscoveryPending(true),
+		m_nRefreshMicros((uint32_t) RDM_CONTROLLER_REFRESH_SECONDS * 1000000),
+		m_nDiscoveryMicros(0),
+		m_nSendMicros(0),
+		m_bIsOutput(false),
+		m_nMuteIndex(0),
+		m_nRetries(0),
+		m_nStackTop(0) {
+
+	memcpy(m_Uid, pUid, RDM_UID_SIZE);
+}
+
+/**
+ *
+ */
+RDMController::~RDMController(void) {
+}
+
+/**
+ *
+ * @param nSeconds Time between the incremental discoveries
+ */
+void RDMController::SetRefreshTime(const uint32_t nSeconds) {
+	m_nRefreshMicros = nSeconds * 1000000;
+}
+
+/**
+ *
+ * @return
+ */
+const uint32_t RDMController::GetRefreshTime(void) {
+	return m_nRefreshMicros / 1000000;
+}
+
+/**
+ * There is one DMX port, port 0.
+ *
+ * @param nPort
+ */
+void RDMController::Full(const uint8_t nPort) {
+	if (nPort != 0) {
+		return;
+	}
+
+	if (m_tState != RDM_CONTROLLER_STATE_IDLE) {
+		Restore();
+
+		if (m_tState == RDM_CONTROLLER_STATE_WAIT_RESPONSE) {
+			// The request in progress is dropped
+			HandleResponse(0);
+		}
+
+		m_tState = RDM_CONTROLLER_STATE_IDLE;
+	}
+
+	m_nUidCount = 0;
+	m_bIsTodChanged = true;
+	m_bIsDiscoveryPending = true;
+}
+
+/**
+ *
+ * @param nPort
+ * @param pUidCount
+ * @return
+ */
+const uint8_t *RDMController::GetTod(const uint8_t nPort, uint16_t *pUidCount) {
+	*pUidCount = (nPort == 0) ? m_nUidCount : 0;
+
+	return &m_Tod[0][0];
+}
+
+/**
+ * The changes are reported once the discovery is finished, not for every device found.
+ *
+ * @param nPort
+ * @return
+ */
+const bool RDMController::IsTodChanged(const uint8_t nPort) {
+	if ((nPort != 0) || (m_tState != RDM_CONTROLLER_STATE_IDLE) || !m_bIsTodChanged) {
+		return false;
+	}
+
+	m_bIsTodChanged = false;
+
+	return true;
+}
+
+/**
+ * One discovery message or request is sent, or one response is handled, per call.
+ * A queued request is sent in between the discovery messages, never while waiting for a discovery response.
+ */
+void RDMController::Run(void) {
+	const uint32_t nMicros = hardware_micros();
+	const uint8_t *p;
+	uint8_t pd[2 * RDM_UID_SIZE];
+
+	if ((m_tState == RDM_CONTROLLER_STATE_IDLE) || (m_tState == RDM_CONTROLLER_STATE_MUTE_KNOWN) || (m_tState == RDM_CONTROLLER_STATE_BRANCH)) {
+		if (RunRequest()) {
+			return;
+		}
+	}
+
+	switch (m_tState) {
+	case RDM_CONTROLLER_STATE_IDLE:
+		if (!m_bIsDiscoveryPending && ((nMicros - m_nDiscoveryMicros) < m_nRefreshMicros)) {
+			return;
+		}
+
+		m_bIsDiscoveryPending = false;
+
+		// Broadcast, there is no response
+		SendMessage(UID_ALL, E120_DISCOVERY_COMMAND, E120_DISC_UN_MUTE, 0, 0);
+		Restore();
+
+		m_nMuteIndex = 0;
+		m_nRetries = 0;
+		m_tState = RDM_CONTROLLER_STATE_MUTE_KNOWN;
+		break;
+	case RDM_CONTROLLER_STATE_MUTE_KNOWN:
+		if (m_nMuteIndex < m_nUidCount) {
+			SendMessage(m_Tod[m_nMuteIndex], E120_DISCOVERY_COMMAND, E120_DISC_MUTE, 0, 0);
+			m_tState = RDM_CONTROLLER_STATE_WAIT_MUTE_KNOWN;
+		} else {
+			m_nStackTop = 0;
+			Push(0, RDM_CONTROLLER_UID_MAX);
+			m_tState = RDM_CONTROLLER_STATE_BRANCH;
+		}
+		break;
+	case RDM_CONTROLLER_STATE_WAIT_MUTE_KNOWN:
+		p = rdm_get_available();
+
+		if ((p == 0) && ((nMicros - m_nSendMicros) < RDM_CONTROLLER_DISCOVERY_TIMEOUT_MICROS)) {
+			return;
+		}
+
+		Restore();
+
+		if (IsMuteResponse(p, m_Tod[m_nMuteIndex])) {
+			m_nMuteIndex++;
+			m_nRetries = 0;
+		} else if (m_nRetries < RDM_CONTROLLER_MUTE_RETRIES) {
+			m_nRetries++;
+		} else {
+			RemoveUid(m_nMuteIndex);
+			m_nRetries = 0;
+		}
+
+		m_tState = RDM_CONTROLLER_STATE_MUTE_KNOWN;
+		break;
+	case RDM_CONTROLLER_STATE_BRANCH:
+		if ((m_nStackTop == 0) || (m_nUidCount == RDM_CONTROLLER_MAX_UIDS)) {
+			m_nDiscoveryMicros = nMicros;
+			m_tState = RDM_CONTROLLER_STATE_IDLE;
+			return;
+		}
+
+		m_Branch = m_Stack[--m_nStackTop];
+
+		if (m_Branch.nLower == m_Branch.nUpper) {
+			u64_to_uid(m_Branch.nLower, m_FoundUid);
+			SendMessage(m_FoundUid, E120_DISCOVERY_COMMAND, E120_DISC_MUTE, 0, 0);
+			m_tState = RDM_CONTROLLER_STATE_WAIT_MUTE_NEW;
+		} else {
+			u64_to_uid(m_Branch.nLower, &pd[0]);
+			u64_to_uid(m_Branch.nUpper, &pd[RDM_UID_SIZE]);
+			SendMessage(UID_ALL, E120_DISCOVERY_COMMAND, E120_DISC_UNIQUE_BRANCH, pd, sizeof pd);
+			m_tState = RDM_CONTROLLER_STATE_WAIT_BRANCH;
+		}
+		break;
+	case RDM_CONTROLLER_STATE_WAIT_BRANCH:
+		p = rdm_get_available();
+
+		if ((p == 0) && ((nMicros - m_nSendMicros) < RDM_CONTROLLER_DISCOVERY_TIMEOUT_MICROS)) {
+			return;
+		}
+
+		Restore();
+
+		if (p == 0) {
+			// No device in this branch
+			m_tState = RDM_CONTROLLER_STATE_BRANCH;
+		} else if (DecodeDiscoveryResponse(p, m_FoundUid)) {
+			SendMessage(m_FoundUid, E120_DISCOVERY_COMMAND, E120_DISC_MUTE, 0, 0);
+			m_tState = RDM_CONTROLLER_STATE_WAIT_MUTE_NEW;
+		} else {
+			// Collision, split the branch
+			const uint64_t nMiddle = m_Branch.nLower + ((m_Branch.nUpper - m_Branch.nLower) / 2);
+			Push(nMiddle + 1, m_Branch.nUpper);
+			Push(m_Branch.nLower, nMiddle);
+			m_tState = RDM_CONTROLLER_STATE_BRANCH;
+		}
+		break;
+	case RDM_CONTROLLER_STATE_WAIT_MUTE_NEW:
+		p = rdm_get_available();
+
+		if ((p == 0) && ((nMicros - m_nSendMicros) < RDM_CONTROLLER_DISCOVERY_TIMEOUT_MICROS)) {
+			return;
+		}
+
+		Restore();
+
+		if (IsMuteResponse(p, m_FoundUid)) {
+			AddUid(m_FoundUid);
+			// There can be more devices in this branch
+			if (m_Branch.nLower != m_Branch.nUpper) {
+				Push(m_Branch.nLower, m_Branch.nUpper);
+			}
+		}
+
+		m_tState = RDM_CONTROLLER_STATE_BRANCH;
+		break;
+	case RDM_CONTROLLER_STATE_WAIT_RESPONSE:
+		p = rdm_get_available();
+
+		if ((p == 0) && ((nMicros - m_nSendMicros) < RDM_CONTROLLER_RESPONSE_TIMEOUT_MICROS)) {
+			return;
+		}
+
+		Restore();
+		HandleResponse(p);
+
+		m_tState = m_tStateResume;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Discovery requests are not queued, the discovery is done by the controller itself.
+ *
+ * @param nPort
+ * @param pRdmData The request starting with the start code
+ * @param nTag Returned with the response
+ * @return false when the request is not valid or the queue is full
+ */
+bool RDMController::Request(const uint8_t nPort, const uint8_t *pRdmData, const uint32_t nTag) {
+	const struct _rdm_command *pRequest = (const struct _rdm_command *) pRdmData;
+
+	if ((nPort != 0) || (pRequest->start_code != E120_SC_RDM) || (pRequest->message_length < RDM_MESSAGE_MINIMUM_SIZE) || (pRequest->command_class == E120_DISCOVERY_COMMAND)) {
+		return false;
+	}
+
+	if (m_nRequestCount == RDM_CONTROLLER_REQUEST_ENTRIES) {
+		return false;
+	}
+
+	struct TRdmControllerRequest *pEntry = &m_Requests[(m_nRequestHead + m_nRequestCount) % RDM_CONTROLLER_REQUEST_ENTRIES];
+
+	pEntry->nTag = nTag;
+	pEntry->nPort = nPort;
+	memcpy(pEntry->Data, pRdmData, (size_t) pRequest->message_length + RDM_MESSAGE_CHECKSUM_SIZE);
+
+	m_nRequestCount++;
+
+	return true;
+}
+
+/**
+ *
+ * @param pPort
+ * @param pTag
+ * @return The response starting with the start code, or 0 when there is none
+ */
+const uint8_t *RDMController::GetResponse(uint8_t *pPort, uint32_t *pTag) {
+	if (!m_bIsResponseAvailable) {
+		return 0;
+	}
+
+	m_bIsResponseAvailable = false;
+
+	*pPort = m_nResponsePort;
+	*pTag = m_nResponseTag;
+
+	return m_Response;
+}
+
+/**
+ * The request is kept in the queue until its response is handled. A request is not sent before the previous response is taken.
+ *
+ * @return true when a request is sent
+ */
+bool RDMController::RunRequest(void) {
+	if ((m_nRequestCount == 0) || m_bIsResponseAvailable) {
+		return false;
+	}
+
+	const struct _rdm_command *pRequest = (const struct _rdm_command *) m_Requests[m_nRequestHead].Data;
+
+	Send(m_Requests[m_nRequestHead].Data, (uint16_t) pRequest->message_length + RDM_MESSAGE_CHECKSUM_SIZE);
+
+	// Broadcast and vendorcast requests have no response
+	if ((pRequest->destination_uid[2] & pRequest->destination_uid[3] & pRequest->destination_uid[4] & pRequest->destination_uid[5]) == 0xFF) {
+		Restore();
+		HandleResponse(0);
+		return true;
+	}
+
+	m_tStateResume = m_tState;
+	m_tState = RDM_CONTROLLER_STATE_WAIT_RESPONSE;
+
+	return true;
+}
+
+/**
+ * The request at the head of the queue is removed. The response is kept for \ref GetResponse when it matches the request.
+ *
+ * @param p The received data, 0 for no response
+ */
+void RDMController::HandleResponse(const uint8_t *p) {
+	const struct TRdmControllerRequest *pEntry = &m_Requests[m_nRequestHead];
+	const struct _rdm_command *pRequest = (const struct _rdm_command *) pEntry->Data;
+	const struct _rdm_command *pResponse = (const struct _rdm_command *) p;
+
+	m_nRequestHead = (m_nRequestHead + 1) % RDM_CONTROLLER_REQUEST_ENTRIES;
+	m_nRequestCount--;
+
+	if ((p == 0) || (p[0] != E120_SC_RDM)) {
+		return;
+	}
+
+	if ((pResponse->transaction_number != pRequest->transaction_number) || (memcmp(pResponse->source_uid, pRequest->destination_uid, RDM_UID_SIZE) != 0)) {
+		return;
+	}
+
+	memcpy(m_Response, p, (size_t) pResponse->message_length + RDM_MESSAGE_CHECKSUM_SIZE);
+
+	m_nResponsePort = pEntry->nPort;
+	m_nResponseTag = pEntry->nTag;
+	m_bIsResponseAvailable = true;
+}
+
+/**
+ *
+ * @param pDestinationUid
+ * @param nCommandClass
+ * @param nParamId
+ * @param pParamData
+ * @param nParamDataLength
+ */
+void RDMController::SendMessage(const uint8_t *pDestinationUid, const uint8_t nCommandClass, const uint16_t nParamId, const uint8_t *pParamData, const uint8_t nParamDataLength) {
+	struct _rdm_command *p = (struct _rdm_command *) m_Message;
+	uint16_t nChecksum = 0;
+	unsigned i;
+
+	p->start_code = E120_SC_RDM;
+	p->sub_start_code = E120_SC_SUB_MESSAGE;
+	p->message_length = RDM_MESSAGE_MINIMUM_SIZE + nParamDataLength;
+	memcpy(p->destination_uid, pDestinationUid, RDM_UID_SIZE);
+	memcpy(p->source_uid, m_Uid, RDM_UID_SIZE);
+	p->transaction_number = m_nTransactionNumber++;
+	p->slot16.port_id = 1;
+	p->message_count = 0;
+	p->sub_device[0] = 0;
+	p->sub_device[1] = 0;
+	p->command_class = nCommandClass;
+	p->param_id[0] = (uint8_t) (nParamId >> 8);
+	p->param_id[1] = (uint8_t) (nParamId & 0xFF);
+	p->param_data_length = nParamDataLength;
+
+	if (nParamDataLength != 0) {
+		memcpy(p->param_data, pParamData, nParamDataLength);
+	}
+
+	for (i = 0; i < p->message_length; i++) {
+		nChecksum += m_Message[i];
+	}
+
+	m_Message[i++] = (uint8_t) (nChecksum >> 8);
+	m_Message[i] = (uint8_t) (nChecksum & 0xFF);
+
+	Send(m_Message, (uint16_t) p->message_length + RDM_MESSAGE_CHECKSUM_SIZE);
+}
+
+/**
+ * Send and turn the line around for the response. A DMX output is paused until \ref Restore.
+ *
+ * @param pData
+ * @param nLength
+ */
+void RDMController::Send(const uint8_t *pData, const uint16_t nLength) {
+	// Responses not taken, they are too late
+	while (rdm_get_available() != 0)
+		;
+
+	m_bIsOutput = (dmx_get_port_direction() == DMX_PORT_DIRECTION_OUTP);
+
+	dmx_set_port_direction(DMX_PORT_DIRECTION_OUTP, false);
+	rdm_send_data(pData, nLength);
+	udelay(RDM_RESPONDER_DATA_DIRECTION_DELAY);
+	dmx_set_port_direction(DMX_PORT_DIRECTION_INP, true);
+
+	m_nSendMicros = hardware_micros();
+}
+
+/**
+ *
+ */
+void RDMController::Restore(void) {
+	if (m_bIsOutput) {
+		dmx_set_port_direction(DMX_PORT_DIRECTION_OUTP, true);
+	}
+}
+
+/**
+ *
+ * @param p The received data, can be 0
+ * @param pUid
+ * @return
+ */
+bool RDMController::IsMuteResponse(const uint8_t *p, const uint8_t *pUid) {
+	const struct _rdm_command *pResponse = (const struct _rdm_command *) p;
+
+	if ((p == 0) || (p[0] != E120_SC_RDM)) {
+		return false;
+	}
+
+	if ((pResponse->command_class != E120_DISCOVERY_COMMAND_RESPONSE) || (pResponse->param_id[0] != (E120_DISC_MUTE >> 8)) || (pResponse->param_id[1] != (E120_DISC_MUTE & 0xFF))) {
+		return false;
+	}
+
+	return (memcmp(pResponse->source_uid, pUid, RDM_UID_SIZE) == 0);
+}
+
+/**
+ * 7.5 Discovery Unique Branch Response : the preamble, the separator, the encoded UID and the encoded checksum.
+ * Each byte is sent twice, OR'ed with 0xAA and with 0x55.
+ *
+ * @param p The received data
+ * @param pUid The decoded UID
+ * @return false when the response is not valid, which is a collision
+ */
+bool RDMController::DecodeDiscoveryResponse(const uint8_t *p, uint8_t *pUid) {
+	unsigned i;
+
+	for (i = 0; (i < RDM_DISCOVERY_PREAMBLE_MAX) && (p[i] == 0xFE); i++)
+		;
+
+	if (p[i++] != RDM_DISCOVERY_SEPARATOR) {
+		return false;
+	}
+
+	const uint8_t *pEuid = &p[i];
+	const uint8_t *pEcs = &p[i + (2 * RDM_UID_SIZE)];
+	uint16_t nChecksum = 0;
+
+	for (i = 0; i < (2 * RDM_UID_SIZE); i++) {
+		nChecksum += pEuid[i];
+	}
+
+	for (i = 0; i < RDM_UID_SIZE; i++) {
+		pUid[i] = pEuid[2 * i] & pEuid[(2 * i) + 1];
+	}
+
+	const uint16_t nEcs = ((pEcs[0] & pEcs[1]) << 8) | (pEcs[2] & pEcs[3]);
+
+	if (nChecksum != nEcs) {
+		return false;
+	}
+
+	const uint64_t nUid = uid_to_u64(pUid);
+
+	return (nUid >= m_Branch.nLower) && (nUid <= m_Branch.nUpper);
+}
+
+/**
+ *
+ * @param pUid
+ */
+void RDMController::AddUid(const uint8_t *pUid) {
+	for (unsigned i = 0; i < m_nUidCount; i++) {
+		if (memcmp(m_Tod[i], pUid, RDM_UID_SIZE) == 0) {
+			return;
+		}
+	}
+
+	if (m_nUidCount < RDM_CONTROLLER_MAX_UIDS) {
+		memcpy(m_Tod[m_nUidCount++], pUid, RDM_UID_SIZE);
+		m_bIsTodChanged = true;
+	}
+}
+
+/**
+ *
+ * @param nIndex
+ */
+void RDMController::RemoveUid(const uint16_t nIndex) {
+	m_nUidCount--;
+
+	if (nIndex != m_nUidCount) {
+		memcpy(m_Tod[nIndex], m_Tod[m_nUidCount], RDM_UID_SIZE);
+	}
+
+	m_bIsTodChanged = true;
+}
+
+/**
+ *
+ * @param nLower
+ * @param nUpper
+ */
+void RDMController::Push(const uint64_t nLower, const uint64_t nUpper) {
+	if (m_nStackTop < RDM_CONTROLLER_STACK_SIZE) {
+		m_Stack[m_nStackTop].nLower = nLower;
+		m_Stack[m_nStackTop].nUpper = nUpper;
+		m_nStackTop++;
+	}
+}
@@ -85,7 +85,7 @@ enum TVectorDMP {
 /**
  * Merge is implemented in either LTP or HTP mode
  */
-enum TMerge {
+enum TE131Merge {
 	E131_MERGE_HTP,		///< Highest Takes Precedence (HTP)
 	E131_MERGE_LTP		///< Latest Takes Precedence (LTP)
 };
@@ -98,9 +98,18 @@ enum TMerge {
  */
 enum TPriority {
 	E131_PRIORITY_LOWEST	= 1,	///<
+	E131_PRIORITY_DEFAULT	= 100,	///<
 	E131_PRIORITY_HIGHEST	= 200	///<
 };
 
+/**
+ * 7.5 START Code, the first property value of the DMP layer
+ */
+enum TStartCode {
+	E131_START_CODE_DMX			= 0x00,	///< Null START Code, the levels
+	E131_START_CODE_PRIORITY	= 0xDD	///< Per-address priority, a priority for each slot. 0 is the slot is not driven by the source
+};
+
 /**
  * 6.2.6 Options
  */
@@ -133,10 +142,17 @@ enum TUniverse {
 #define E131_MERGE_TIMEOUT_SECONDS					10	///<
 #define E131_PRIORITY_TIMEOUT_SECONDS				10	///<
 #define E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS	10	///<
+#define E131_UNIVERSE_DISCOVERY_TIMEOUT_SECONDS		(2 * E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS)	///< A discovered source is forgotten when two intervals are missed
 #define E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS		2.5	///<
+#define E131_SAMPLING_PERIOD_SECONDS				1.5	///< 6.2.3.1 Sources are collected before the highest priority is acted upon
+#define E131_PER_ADDRESS_PRIORITY_TIMEOUT_SECONDS	2.5	///< Without \ref E131_START_CODE_PRIORITY data the source reverts to its universe priority
+#define E131_KEEP_ALIVE_MILLIS						1000	///< 6.6.1 Unchanged data is transmitted at least once a second
+#define E131_TRANSMIT_SUPPRESSION_PACKETS			3	///< 6.6.1 Unchanged data is transmitted this many times before the keep alive timing
+#define E131_STREAM_TERMINATED_PACKETS				3	///< 6.2.6 Stream terminated is sent in three packets
 
 #define E131_CID_LENGTH					16
 #define E131_SOURCE_NAME_LENGTH			64
+#define E131_DISCOVERY_UNIVERSES_PER_PAGE	512	///< 8.5 List of Universes, up to 512 universes in a page
 #define E131_PACKET_IDENTIFIER_LENGTH	12
 
 #endif /* E131_H_ */
@@ -30,21 +30,75 @@
 
 #include "e131.h"
 #include "lightset.h"
+#include "lightset_merge.h"
 #include "e131packets.h"
+#include "e131validate.h"
+
+/**
+ * The maximum number of universes handled by a single bridge, each universe is a port of the LightSet.
+ * Override at build time.
+ */
+#if !defined (E131_MAX_PORTS)
+ #define E131_MAX_PORTS	4
+#endif
+
+/**
+ * The maximum number of sources tracked for a universe. The data of more sources is discarded.
+ * Override at build time.
+ */
+#if !defined (E131_MAX_SOURCES)
+ #define E131_MAX_SOURCES	4
+#endif
+
+/**
+ * The maximum number of other sources kept from their Universe Discovery packets.
+ * Override at build time.
+ */
+#if !defined (E131_MAX_DISCOVERED_SOURCES)
+ #define E131_MAX_DISCOVERED_SOURCES	8
+#endif
+
+/**
+ * The maximum number of universes kept for a discovered source, the universes after are not kept.
+ * Override at build time.
+ */
+#if !defined (E131_MAX_DISCOVERED_UNIVERSES)
+ #define E131_MAX_DISCOVERED_UNIVERSES	16
+#endif
+
+/**
+ * Universe lookup table entries
+ */
+#define E131_PORT_INDEX_NONE	0xFF	///< No port for this low byte of the universe
+#define E131_PORT_INDEX_SCAN	0xFE	///< More ports with the same low byte of the universe, search the ports
 
 /**
  *
  */
 struct TE131BridgeState {
-	uint8_t nPriority;
 	bool IsNetworkDataLoss;			///<
-	bool IsMergeMode;				///< Is the Bridge in merging mode?
 	bool IsTransmitting;			///<
-	bool IsSynchronized;			///< “Synchronized” or an “Unsynchronized” state.
-	bool IsForcedSynchronized;		///<
-	uint32_t SynchronizationTime;	///<
+	uint8_t nActivePorts;			///< Number of ports with a universe
 	uint32_t DiscoveryTime;			///<
 	uint16_t DiscoveryPacketLength;	///<
+	uint16_t nDiscoveryUniverses;	///< Number of universes in the Universe Discovery pages
+	bool IsDiscoveryListener;		///< The Universe Discovery packets of the other sources are kept
+	uint8_t nDiscoveredSources;		///< Number of entries used in the discovered sources
+	uint32_t DiscoveredSourcesTime;	///< The latest time the discovered sources were checked for timeouts
+};
+
+/**
+ * A source found by its Universe Discovery packets
+ */
+struct TE131DiscoveredSource {
+	uint32_t time;					///< The latest time of the Universe Discovery packet received from source
+	uint32_t ip;					///< The IP address for source
+	uint8_t cid[E131_CID_LENGTH];	///< Sender's CID. Sender's unique ID
+	char sourceName[E131_SOURCE_NAME_LENGTH];	///< User Assigned Name of Source, null-terminated
+	bool IsTruncated;				///< The source has more universes than \ref E131_MAX_DISCOVERED_UNIVERSES
+	uint8_t nextPage;				///< The page expected next
+	uint16_t nUniverses;			///< Number of universes in universes
+	uint16_t universes[E131_MAX_DISCOVERED_UNIVERSES];	///< Sorted list of the universes the source is transmitting
 };
 
 /**
@@ -52,23 +106,40 @@ struct TE131BridgeState {
  */
 struct TSource {
 	uint32_t time;					///< The latest time of the data received from source
-	uint32_t ip;					///< The IP address for source
-	uint8_t data[E131_DMX_LENGTH];	///< The data received from source
+	uint32_t ip;					///< The IP address for source, 0 when the entry is not used
 	uint8_t cid[E131_CID_LENGTH];	///< Sender's CID. Sender's unique ID
-	uint8_t sequenceNumberData;
+	uint8_t priority;				///< The priority of the latest data
+	uint8_t sequenceNumberData;		///<
+	uint16_t length;				///< Number of slots in data, the slots after are 0
+	uint8_t data[E131_DMX_LENGTH];	///< The data received from source
+	bool IsPerAddressPriority;		///< Per-address priority data is received, see \ref E131_PER_ADDRESS_PRIORITY_TIMEOUT_SECONDS
+	uint32_t priorityTime;			///< The latest time of the per-address priority data
+	uint8_t priorities[E131_DMX_LENGTH];	///< The priority of each slot. Without per-address priority all the slots have the universe priority
 };
 
 /**
- * struct to represent an output port
+ * struct to represent an output port, with the source, merge and synchronization state of its universe
  *
  */
 struct TOutputPort {
+	uint16_t nUniverse;				///< 0 is port not used
 	uint8_t data[E131_DMX_LENGTH];	///< Data sent
 	uint16_t length;				///< Length of sent DMX data
-	TMerge mergeMode;				///< \ref TMerge
-	bool IsDataPending;				///<
-	struct TSource sourceA;			///<
-	struct TSource sourceB;			///<
+	TE131Merge mergeMode;				///< \ref TE131Merge
+	uint8_t nPriority;				///< The highest priority of the sources, only the sources with this priority are output
+	bool IsMergeMode;				///< Is the port merging? More sources have the highest priority
+	bool IsSampling;				///< Sources are collected, nothing is output
+	bool HasSampled;				///< The sampling period is done once for the universe
+	uint32_t SamplingTime;			///< The start of the sampling period
+	bool IsDataPending;				///< The data is waiting for the synchronization packet
+	bool IsSynchronized;			///< “Synchronized” or an “Unsynchronized” state.
+	bool IsForcedSynchronized;		///< Force_Synchronization is 0 : stay synchronized when synchronization is lost
+	uint16_t nSynchronizationAddress;	///< Of the latest data, 0 when the universe is not synchronized
+	uint32_t SynchronizationTime;	///< The latest synchronization packet for nSynchronizationAddress
+	struct _lightset_merge_result changed;	///< The slots changed since the data was last handed to the LightSet
+	struct TSource sources[E131_MAX_SOURCES];	///<
+	uint8_t nSources;				///< The number of active sources
+	uint8_t nLatestSource;			///< The source of the latest data, for LTP
 };
 
 /**
@@ -83,11 +154,12 @@ public:
 
 	const uint8_t *GetSoftwareVersion(void);
 
-	const uint16_t getUniverse(void);
-	void setUniverse(const uint16_t);
+	const uint16_t getUniverse(const uint8_t);
+	void setUniverse(const uint8_t, const uint16_t);
+	const uint8_t getActiveOutputPorts(void);
 
-	const TMerge getMergeMode(void);
-	void setMergeMode(TMerge);
+	const TE131Merge getMergeMode(void);
+	void setMergeMode(TE131Merge);
 
 	const uint8_t *GetCid(void);
 	void setCid(const uint8_t[E131_CID_LENGTH]);
@@ -95,6 +167,11 @@ public:
 	const char *GetSourceName(void);
 	void setSourceName(const char[E131_SOURCE_NAME_LENGTH]);
 
+	const bool getDiscoveryListener(void);
+	void setDiscoveryListener(const bool);
+	const uint8_t getDiscoveredSources(void);
+	const struct TE131DiscoveredSource *getDiscoveredSource(const uint8_t);
+
 	int Run(void);
 
 private:
@@ -102,25 +179,33 @@ private:
 	void Stop(void);
 
 	void FillDiscoveryPacket(void);
-
-	const bool IsValidRoot(void);
-	const bool IsValidDataPacket(void);
-
-	void SetNetworkDataLossCondition(void);
-	void CheckMergeTimeouts(void);
-	const bool IsPriorityTimeOut(void);
+	void FillDiscoveryPage(const uint8_t, const uint8_t);
+	const uint8_t GetDiscoveryLastPage(void);
+	void UpdateUniverseIndex(void);
+	const uint8_t GetPortIndex(const uint16_t);
+	void JoinUniverse(const uint16_t);
+
+	void SetNetworkDataLossCondition(const uint8_t);
+	void CheckNetworkDataLoss(void);
+	void CheckSourceTimeouts(const uint8_t);
+	void SetUniversePriority(struct TSource *);
 	const bool isIpCidMatch(const struct TSource *);
-	const bool IsDmxDataChanged(const uint8_t *, const uint16_t);
-	const bool IsMergedDmxDataChanged(const uint8_t *, const uint16_t );
+	struct TSource *FindSource(const uint8_t);
+	void RemoveSource(const uint8_t, struct TSource *);
+	const bool IsDmxDataChanged(const uint8_t, const uint8_t *, const uint16_t);
+	const bool IsMergedDmxDataChanged(const uint8_t, const uint8_t **, const uint8_t, const uint16_t);
+	void UpdateOutput(const uint8_t);
 
 	void SendDiscoveryPacket(void);
+	void HandleDiscovery(void);
+	void CheckDiscoveredSourceTimeouts(void);
 
-	void HandleDmx(void);
+	void HandleDmx(const uint8_t);
 	void HandleSynchronization(void);
+	void SetLightSetData(const uint8_t);
 
 private:
 	LightSet *m_pLightSet;
-	uint16_t m_nUniverse;
 	uint8_t m_Cid[E131_CID_LENGTH];
 	char m_SourceName[E131_SOURCE_NAME_LENGTH];
 
@@ -130,9 +215,14 @@ private:
 	uint32_t m_nPreviousPacketMillis;
 
 	struct TE131BridgeState m_State;
-	struct TOutputPort m_OutputPort;
+	struct TOutputPort m_OutputPorts[E131_MAX_PORTS];
+	uint8_t m_UniverseIndex[256];	///< Port index for the low byte of the universe
+	uint16_t m_DiscoveryUniverses[E131_MAX_PORTS];	///< Sorted list of the universes of the ports
+	struct TE131DiscoveredSource m_DiscoveredSources[E131_MAX_DISCOVERED_SOURCES];	///< Entries 0 .. nDiscoveredSources - 1 are used
+	uint8_t m_MergeScratch[E131_DMX_LENGTH];	///< Intermediate HTP result when more than two sources are merged, the per-address priority merge result
 
 	struct TE131 m_E131;
+	struct TE131View m_View;		///< The fields of the packet received, filled by \ref e131_validate
 	struct TE131DiscoveryPacket m_E131DiscoveryPacket;
 };
 
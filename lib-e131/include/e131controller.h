@@ -0,0 +1,128 @@
+/**
+ * @file e131controller.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef E131CONTROLLER_H_
+#define E131CONTROLLER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "e131.h"
+#include "e131packets.h"
+#include "lightsetinput.h"
+
+/**
+ * The maximum number of universes transmitted by a single controller, each universe is a port of the LightSetInput.
+ * Override at build time.
+ */
+#if !defined (E131_CONTROLLER_MAX_PORTS)
+ #define E131_CONTROLLER_MAX_PORTS	4
+#endif
+
+/**
+ * The unchanged packets before the transmit suppression are sent at the DMX512 full rate (44 Hz)
+ */
+#define E131_CONTROLLER_REPEAT_MILLIS	23
+
+/**
+ * struct to represent an input port, the DMX data received is transmitted on its universe
+ */
+struct TE131InputPort {
+	uint16_t nUniverse;				///< 0 is port not used
+	uint32_t nMulticastIp;			///< 9.3.1 239.255.UHB.ULB
+	uint8_t nSequence;				///< Sequence of the latest packet sent
+	uint32_t nMillis;				///< Time of the latest packet sent
+	uint8_t nRepeat;				///< Number of packets sent with the same data
+	bool IsTransmitting;			///< Data is sent, so the stream is terminated at Stop
+};
+
+/**
+ * E1.31 source : the DMX data of a \ref LightSetInput is transmitted as sACN.
+ * Changed data is sent right away, unchanged data \ref E131_TRANSMIT_SUPPRESSION_PACKETS times and then at the keep alive time.
+ */
+class E131Controller {
+public:
+	E131Controller(void);
+	~E131Controller(void);
+
+	void SetInput(LightSetInput *);
+
+	const uint16_t getUniverse(const uint8_t);
+	void setUniverse(const uint8_t, const uint16_t);
+
+	const uint8_t getPriority(void);
+	void setPriority(const uint8_t);
+
+	const uint16_t getSynchronizationAddress(void);
+	void setSynchronizationAddress(const uint16_t);
+
+	const uint32_t getKeepAlive(void);
+	void setKeepAlive(const uint32_t);
+
+	const uint8_t *GetCid(void);
+	void setCid(const uint8_t[E131_CID_LENGTH]);
+
+	const char *GetSourceName(void);
+	void setSourceName(const char[E131_SOURCE_NAME_LENGTH]);
+
+	void Start(void);
+	void Stop(void);
+
+	int Run(void);
+
+private:
+	void FillDataPacket(void);
+	void FillSynchronizationPacket(void);
+	void FillDiscoveryPacket(void);
+
+	void SendData(const uint8_t, const uint8_t *, const uint16_t, const uint8_t);
+	void SendSynchronization(void);
+	void SendDiscoveryPacket(void);
+
+private:
+	LightSetInput *m_pLightSetInput;
+	uint8_t m_Cid[E131_CID_LENGTH];
+	char m_SourceName[E131_SOURCE_NAME_LENGTH];
+
+	uint8_t m_nPriority;
+	uint16_t m_nSynchronizationAddress;		///< 0 is no synchronization
+	uint32_t m_nSynchronizationIp;			///<
+	uint8_t m_nSynchronizationSequence;		///< Sequence of the latest synchronization packet sent
+	uint32_t m_nKeepAlive;					///< Milliseconds
+	bool m_IsStarted;						///<
+
+	uint32_t m_nCurrentMillis;
+	uint32_t m_DiscoveryIpAddress;
+	uint32_t m_nDiscoveryMillis;
+	uint16_t m_nDiscoveryPacketLength;
+
+	struct TE131InputPort m_InputPorts[E131_CONTROLLER_MAX_PORTS];
+
+	struct TE131DataPacket m_E131DataPacket;
+	struct TE131SynchronizationPacket m_E131SynchronizationPacket;
+	struct TE131DiscoveryPacket m_E131DiscoveryPacket;
+};
+
+#endif /* E131CONTROLLER_H_ */
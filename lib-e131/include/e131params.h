@@ -44,9 +44,13 @@ public:
 
 	const _output_type GetOutputType(void);
 	const uint16_t GetUniverse(void);
-	const TMerge GetMergeMode(void);
+	const TE131Merge GetMergeMode(void);
 	const bool isHaveCustomCid(void);
 	const char *GetCidString(void);
+
+	const bool isInput(void);
+	const uint8_t GetPriority(void);
+	const uint16_t GetSynchronizationAddress(void);
 };
 
 #endif /* E131PARAMS_H_ */
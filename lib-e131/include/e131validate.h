@@ -0,0 +1,75 @@
+/**
+ * @file e131validate.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef E131VALIDATE_H_
+#define E131VALIDATE_H_
+
+#include <stdint.h>
+
+#include "e131.h"
+
+/**
+ * The kind of a valid E1.31 packet
+ */
+enum TE131PacketType {
+	E131_PACKET_INVALID,			///< Discard
+	E131_PACKET_DATA,				///< 6.2 E1.31 Data Packet
+	E131_PACKET_SYNCHRONIZATION,	///< 6.3 E1.31 Synchronization Packet
+	E131_PACKET_DISCOVERY			///< 6.4 E1.31 Universe Discovery Packet
+};
+
+/**
+ * The fields of a validated packet in host byte order. The pointers are into the receive buffer.
+ */
+struct TE131View {
+	const uint8_t *pCid;				///< Sender's CID
+	uint16_t nUniverse;					///< Data : the universe. Synchronization : the synchronization address
+	uint8_t nSequence;					///< Data and synchronization : the sequence number
+	// Data
+	uint8_t nPriority;					///<
+	uint8_t nOptions;					///< \ref TOptions
+	uint8_t nStartCode;					///<
+	uint16_t nSynchronizationAddress;	///<
+	uint16_t nSlots;					///< Number of slots after the START Code, at most \ref E131_DMX_LENGTH
+	const uint8_t *pData;				///< The slots after the START Code
+	// Universe Discovery
+	const uint8_t *pSourceName;			///< Not null-terminated when it fills the field
+	uint8_t nPage;						///<
+	uint8_t nLastPage;					///<
+	uint16_t nUniverses;				///< Number of universes in pUniverses
+	const uint8_t *pUniverses;			///< Sorted list of universes, 2 octets each in network byte order
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const enum TE131PacketType e131_validate(const uint8_t *, const uint16_t, /*@out@*/struct TE131View *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* E131VALIDATE_H_ */
@@ -0,0 +1,462 @@
+/**
+ * @file benchmark.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Check e131_validate on the seed corpus : valid data, synchronization and discovery packets, and truncated and mutated
+ * ones which must be discarded. Then fuzz it with random mutations of the seeds, checking that the view of a valid packet
+ * stays inside the bytes received, and time it in packets per second.
+ *
+ * benchmark [-l loops] [-n mutations] [-w directory]
+ *
+ * -w writes the seed corpus, one file per packet, as the starting point for an external fuzzer.
+ * Build with SANITIZE=1 to fuzz under AddressSanitizer and UndefinedBehaviorSanitizer.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131validate.h"
+
+#define SEEDS_MAX		32
+#define PACKET_MAX		(sizeof(union UE131Packet) + 16)	///< Mutations can also make a packet longer
+
+#define DATA_HEADER_LENGTH		(sizeof(struct TE131DataPacket) - (E131_DMX_LENGTH + 1))
+#define DISCOVERY_HEADER_LENGTH	(sizeof(struct TE131DiscoveryPacket) - (E131_DISCOVERY_UNIVERSES_PER_PAGE * 2))
+
+struct seed {
+	const char *name;
+	enum TE131PacketType type;	///< Expected
+	uint16_t length;
+	union UE131Packet packet;
+};
+
+static struct seed seeds[SEEDS_MAX];
+static unsigned seeds_count;
+
+static volatile uint32_t sink;
+
+static const char *type_name[] = { "invalid", "data", "synchronization", "discovery" };
+
+/*
+ * Seed corpus
+ */
+
+static struct seed *seed_add(const char *name, const enum TE131PacketType type) {
+	struct seed *s = &seeds[seeds_count++];
+
+	memset(s, 0, sizeof(struct seed));
+	s->name = name;
+	s->type = type;
+
+	return s;
+}
+
+static struct seed *seed_copy(const char *name, const enum TE131PacketType type, const struct seed *from) {
+	struct seed *s = &seeds[seeds_count++];
+
+	memcpy(s, from, sizeof(struct seed));
+	s->name = name;
+	s->type = type;
+
+	return s;
+}
+
+static void root_layer(struct TRootLayer *p, const uint32_t vector, const uint16_t length) {
+	static const uint8_t cid[E131_CID_LENGTH] = { 0x5a, 0x4e, 0x12, 0x0c, 0x33, 0x86, 0x4b, 0x2a, 0x9a, 0x1c, 0x7b, 0x31, 0x0e, 0x58, 0x06, 0xa1 };
+
+	p->PreAmbleSize = htons(0x0010);
+	p->PostAmbleSize = 0;
+	memcpy(p->ACNPacketIdentifier, "ASC-E1.17\0\0\0", E131_PACKET_IDENTIFIER_LENGTH);
+	p->FlagsLength = htons((uint16_t) (0x7000 | (length - 16)));
+	p->Vector = htonl(vector);
+	memcpy(p->Cid, cid, E131_CID_LENGTH);
+}
+
+static struct seed *seed_data(const char *name, const uint16_t slots, const uint8_t start_code) {
+	struct seed *s = seed_add(name, E131_PACKET_DATA);
+	struct TE131DataPacket *p = &s->packet.Data;
+	unsigned i;
+
+	s->length = (uint16_t) (DATA_HEADER_LENGTH + 1 + slots);
+
+	root_layer(&p->RootLayer, E131_VECTOR_ROOT_DATA, s->length);
+	p->FrameLayer.FLagsLength = htons((uint16_t) (0x7000 | (s->length - sizeof(struct TRootLayer))));
+	p->FrameLayer.Vector = htonl(E131_VECTOR_DATA_PACKET);
+	strcpy((char *) p->FrameLayer.SourceName, "benchmark");
+	p->FrameLayer.Priority = 100;
+	p->FrameLayer.SequenceNumber = 1;
+	p->FrameLayer.Universe = htons(1);
+	p->DMPLayer.FlagsLength = htons((uint16_t) (0x7000 | (s->length - sizeof(struct TRootLayer) - sizeof(struct TDataFrameLayer))));
+	p->DMPLayer.Vector = E131_VECTOR_DMP_SET_PROPERTY;
+	p->DMPLayer.Type = 0xa1;
+	p->DMPLayer.FirstAddressProperty = 0;
+	p->DMPLayer.AddressIncrement = htons(1);
+	p->DMPLayer.PropertyValueCount = htons((uint16_t) (slots + 1));
+	p->DMPLayer.PropertyValues[0] = start_code;
+
+	for (i = 1; i <= slots; i++) {
+		p->DMPLayer.PropertyValues[i] = (uint8_t) i;
+	}
+
+	return s;
+}
+
+static struct seed *seed_synchronization(const char *name) {
+	struct seed *s = seed_add(name, E131_PACKET_SYNCHRONIZATION);
+	struct TE131SynchronizationPacket *p = &s->packet.Synchronization;
+
+	s->length = (uint16_t) sizeof(struct TE131SynchronizationPacket);
+
+	root_layer(&p->RootLayer, E131_VECTOR_ROOT_EXTENDED, s->length);
+	p->FrameLayer.FLagsLength = htons((uint16_t) (0x7000 | (s->length - sizeof(struct TRootLayer))));
+	p->FrameLayer.Vector = htonl(E131_VECTOR_EXTENDED_SYNCHRONIZATION);
+	p->FrameLayer.SequenceNumber = 1;
+	p->FrameLayer.UniverseNumber = htons(7);
+
+	return s;
+}
+
+static struct seed *seed_discovery(const char *name, const uint16_t universes) {
+	struct seed *s = seed_add(name, E131_PACKET_DISCOVERY);
+	struct TE131DiscoveryPacket *p = &s->packet.Discovery;
+	const uint16_t layer_length = (uint16_t) (sizeof(struct TUniverseDiscoveryLayer) - (E131_DISCOVERY_UNIVERSES_PER_PAGE * 2) + (universes * 2));
+	unsigned i;
+
+	s->length = (uint16_t) (DISCOVERY_HEADER_LENGTH + (universes * 2));
+
+	root_layer(&p->RootLayer, E131_VECTOR_ROOT_EXTENDED, s->length);
+	p->FrameLayer.FLagsLength = htons((uint16_t) (0x7000 | (s->length - sizeof(struct TRootLayer))));
+	p->FrameLayer.Vector = htonl(E131_VECTOR_EXTENDED_DISCOVERY);
+	strcpy((char *) p->FrameLayer.SourceName, "benchmark");
+	p->UniverseDiscoveryLayer.FlagsLength = htons((uint16_t) (0x7000 | layer_length));
+	p->UniverseDiscoveryLayer.Vector = htonl(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST);
+
+	for (i = 0; i < universes; i++) {
+		p->UniverseDiscoveryLayer.ListOfUniverses[i] = htons((uint16_t) (i + 1));
+	}
+
+	return s;
+}
+
+static void corpus(void) {
+	struct seed *s;
+
+	const struct seed *data = seed_data("data-512", E131_DMX_LENGTH, E131_START_CODE_DMX);
+	seed_data("data-1", 1, E131_START_CODE_DMX);
+	seed_data("data-0", 0, E131_START_CODE_DMX);
+	seed_data("priority-512", E131_DMX_LENGTH, E131_START_CODE_PRIORITY);
+	const struct seed *sync = seed_synchronization("synchronization");
+	const struct seed *discovery = seed_discovery("discovery-512", E131_DISCOVERY_UNIVERSES_PER_PAGE);
+	seed_discovery("discovery-0", 0);
+
+	// Truncated
+	s = seed_copy("data-short-slot", E131_PACKET_INVALID, data);
+	s->length--;
+	s = seed_copy("data-short-header", E131_PACKET_INVALID, data);
+	s->length = (uint16_t) DATA_HEADER_LENGTH - 1;
+	s = seed_copy("synchronization-short", E131_PACKET_INVALID, sync);
+	s->length--;
+	s = seed_copy("discovery-short-header", E131_PACKET_INVALID, discovery);
+	s->length = (uint16_t) DISCOVERY_HEADER_LENGTH - 1;
+	s = seed_copy("discovery-short-list", E131_PACKET_DISCOVERY, discovery);
+	s->length = (uint16_t) (s->length - 101);
+	s = seed_copy("raw-short", E131_PACKET_INVALID, data);
+	s->length = (uint16_t) sizeof(struct TE131RawPacket) - 1;
+	s = seed_copy("empty", E131_PACKET_INVALID, data);
+	s->length = 0;
+
+	// Mutated
+	s = seed_copy("preamble", E131_PACKET_INVALID, data);
+	s->packet.Raw.RootLayer.ACNPacketIdentifier[3] = 'e';
+	s = seed_copy("root-vector", E131_PACKET_INVALID, data);
+	s->packet.Raw.RootLayer.Vector = htonl(5);
+	s = seed_copy("data-vector", E131_PACKET_INVALID, data);
+	s->packet.Data.FrameLayer.Vector = htonl(E131_VECTOR_DATA_PACKET + 1);
+	s = seed_copy("dmp-type", E131_PACKET_INVALID, data);
+	s->packet.Data.DMPLayer.Type = 0xa2;
+	s = seed_copy("dmp-first-address", E131_PACKET_INVALID, data);
+	s->packet.Data.DMPLayer.FirstAddressProperty = htons(1);
+	s = seed_copy("dmp-count-0", E131_PACKET_INVALID, data);
+	s->packet.Data.DMPLayer.PropertyValueCount = 0;
+	s = seed_copy("dmp-count-514", E131_PACKET_INVALID, data);
+	s->packet.Data.DMPLayer.PropertyValueCount = htons(E131_DMX_LENGTH + 2);
+	s = seed_copy("extended-vector", E131_PACKET_INVALID, sync);
+	s->packet.Raw.FrameLayer.Vector = htonl(3);
+	s = seed_copy("discovery-vector", E131_PACKET_INVALID, discovery);
+	s->packet.Discovery.UniverseDiscoveryLayer.Vector = htonl(2);
+	s = seed_copy("discovery-layer-length", E131_PACKET_INVALID, discovery);
+	s->packet.Discovery.UniverseDiscoveryLayer.FlagsLength = htons(0x7004);
+	s = seed_copy("discovery-layer-long", E131_PACKET_DISCOVERY, discovery);
+	s->packet.Discovery.UniverseDiscoveryLayer.FlagsLength = htons(0x7FFF);
+}
+
+/*
+ * Checks
+ */
+
+static bool is_inside(const uint8_t *buffer, const uint16_t length, const uint8_t *p, const unsigned size) {
+	return (p >= buffer) && ((p + size) <= (buffer + length));
+}
+
+/**
+ * The view of a valid packet must only point at bytes which are received.
+ */
+static int check_view(const char *name, const uint8_t *buffer, const uint16_t length, const enum TE131PacketType type, const struct TE131View *view) {
+	bool is_valid = true;
+
+	switch (type) {
+	case E131_PACKET_DATA:
+		is_valid = is_inside(buffer, length, view->pCid, E131_CID_LENGTH) && (view->nSlots <= E131_DMX_LENGTH) && is_inside(buffer, length, view->pData, view->nSlots);
+		break;
+	case E131_PACKET_SYNCHRONIZATION:
+		is_valid = is_inside(buffer, length, view->pCid, E131_CID_LENGTH);
+		break;
+	case E131_PACKET_DISCOVERY:
+		is_valid = is_inside(buffer, length, view->pCid, E131_CID_LENGTH) && is_inside(buffer, length, view->pSourceName, E131_SOURCE_NAME_LENGTH)
+				&& (view->nUniverses <= E131_DISCOVERY_UNIVERSES_PER_PAGE) && is_inside(buffer, length, view->pUniverses, view->nUniverses * 2U);
+		break;
+	default:
+		break;
+	}
+
+	if (!is_valid) {
+		fprintf(stderr, "%s : %s view outside the %u bytes received\n", name, type_name[type], (unsigned) length);
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Every packet is validated from a buffer of exactly its length, so a sanitizer catches any read past the end.
+ */
+static enum TE131PacketType validate(const char *name, const uint8_t *packet, const uint16_t length, int *errors) {
+	uint8_t *buffer = malloc(length == 0 ? 1 : length);
+	struct TE131View view;
+	enum TE131PacketType type;
+
+	memcpy(buffer, packet, length);
+	memset(&view, 0, sizeof view);
+
+	type = e131_validate(buffer, length, &view);
+	*errors += check_view(name, buffer, length, type, &view);
+
+	free(buffer);
+
+	return type;
+}
+
+static int verify(void) {
+	int errors = 0;
+	unsigned i;
+
+	for (i = 0; i < seeds_count; i++) {
+		const struct seed *s = &seeds[i];
+		const enum TE131PacketType type = validate(s->name, (const uint8_t *) &s->packet, s->length, &errors);
+
+		if (type != s->type) {
+			fprintf(stderr, "%s : %s, expected %s\n", s->name, type_name[type], type_name[s->type]);
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+static int fuzz(const uint32_t mutations) {
+	uint32_t types[4] = { 0, 0, 0, 0 };
+	uint8_t packet[PACKET_MAX];
+	int errors = 0;
+	uint32_t m;
+
+	for (m = 0; (m < mutations) && (errors == 0); m++) {
+		const struct seed *s = &seeds[(unsigned) rand() % seeds_count];
+		uint16_t length = s->length;
+		unsigned n = 1 + ((unsigned) rand() % 4);
+
+		memset(packet, 0, sizeof packet);
+		memcpy(packet, &s->packet, s->length);
+
+		while (n-- != 0) {
+			const unsigned offset = (unsigned) rand() % sizeof(union UE131Packet);
+
+			switch (rand() % 5) {
+			case 0:
+				packet[offset] ^= (uint8_t) (1U << (rand() % 8));
+				break;
+			case 1:
+				packet[offset] = (uint8_t) rand();
+				break;
+			case 2:
+				// A length field, or any other 16-bit field
+				packet[offset] = (uint8_t) (rand() & 1 ? 0x70 | (rand() & 0x0F) : rand());
+				packet[offset + 1] = (uint8_t) rand();
+				break;
+			case 3:
+				length = (uint16_t) ((unsigned) rand() % (length + 1U));
+				break;
+			default:
+				length = (uint16_t) (length + ((unsigned) rand() % (PACKET_MAX - length + 1U)));
+				break;
+			}
+		}
+
+		types[validate(s->name, packet, length, &errors)]++;
+	}
+
+	printf("%u mutations : %u invalid, %u data, %u synchronization, %u discovery\n", (unsigned) mutations, (unsigned) types[0], (unsigned) types[1], (unsigned) types[2], (unsigned) types[3]);
+
+	return errors;
+}
+
+static int write_corpus(const char *directory) {
+	char path[256];
+	unsigned i;
+
+	for (i = 0; i < seeds_count; i++) {
+		FILE *f;
+
+		snprintf(path, sizeof path, "%s/%02u-%s", directory, i, seeds[i].name);
+
+		if ((f = fopen(path, "wb")) == NULL) {
+			perror(path);
+			return 1;
+		}
+
+		if (fwrite(&seeds[i].packet, 1, seeds[i].length, f) != seeds[i].length) {
+			perror(path);
+			fclose(f);
+			return 1;
+		}
+
+		fclose(f);
+	}
+
+	printf("%s : %u seeds\n", directory, seeds_count);
+
+	return 0;
+}
+
+/*
+ * Timing
+ */
+
+static double ns_since(const struct timespec *start) {
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (double) (end.tv_sec - start->tv_sec) * 1e9 + (double) (end.tv_nsec - start->tv_nsec);
+}
+
+static void run(const char *name, const uint32_t loops) {
+	const struct seed *s = NULL;
+	struct TE131View view;
+	struct timespec start;
+	unsigned i;
+	uint32_t l;
+
+	for (i = 0; i < seeds_count; i++) {
+		if (strcmp(seeds[i].name, name) == 0) {
+			s = &seeds[i];
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (l = 0; l < loops; l++) {
+		sink += (uint32_t) e131_validate((const uint8_t *) &s->packet, s->length, &view);
+	}
+
+	const double ns = ns_since(&start) / (double) loops;
+
+	printf("%-16s %-16s %10.1f %12.0f\n", name, type_name[s->type], ns, 1e9 / ns);
+}
+
+int main(int argc, char **argv) {
+	const char *directory = NULL;
+	uint32_t loops = 1000000;
+	uint32_t mutations = 1000000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:n:w:")) != -1) {
+		switch (opt) {
+		case 'l':
+			loops = (uint32_t) strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			mutations = (uint32_t) strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			directory = optarg;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-l loops] [-n mutations] [-w directory]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (loops == 0) {
+		loops = 1;
+	}
+
+	srand(1);
+
+	corpus();
+
+	if ((directory != NULL) && (write_corpus(directory) != 0)) {
+		return EXIT_FAILURE;
+	}
+
+	if (verify() != 0) {
+		return EXIT_FAILURE;
+	}
+
+	printf("%u seeds checked\n", seeds_count);
+
+	if (fuzz(mutations) != 0) {
+		return EXIT_FAILURE;
+	}
+
+	printf("\n%-16s %-16s %10s %12s\n", "", "", "ns", "packets/s");
+
+	run("data-512", loops);
+	run("data-1", loops);
+	run("priority-512", loops);
+	run("synchronization", loops);
+	run("discovery-512", loops);
+	run("preamble", loops);
+	run("dmp-count-514", loops);
+
+	return EXIT_SUCCESS;
+}
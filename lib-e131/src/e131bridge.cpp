@@ -31,6 +31,7 @@
 #include "e131.h"
 #include "e131packets.h"
 #include "e131bridge.h"
+#include "e131validate.h"
 
 #include "lightset.h"
 
@@ -50,21 +51,19 @@ static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x
  */
 E131Bridge::E131Bridge(void) :
 		m_pLightSet(0),
-		m_nUniverse(E131_UNIVERSE_DEFAULT),
 		m_nCurrentPacketMillis(0),
 		m_nPreviousPacketMillis(0) {
 
-	memset(&m_OutputPort, 0, sizeof(struct TOutputPort));
-	m_OutputPort.mergeMode = E131_MERGE_HTP;
-	m_OutputPort.IsDataPending = false;
+	memset(m_OutputPorts, 0, sizeof(m_OutputPorts));
+
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		m_OutputPorts[i].mergeMode = E131_MERGE_HTP;
+		m_OutputPorts[i].nPriority = E131_PRIORITY_LOWEST;
+	}
 
 	memset(&m_State, 0, sizeof(struct TE131BridgeState));
 	m_State.IsNetworkDataLoss = true;
-	m_State.IsMergeMode = false;
 	m_State.IsTransmitting = false;
-	m_State.IsSynchronized = false;
-	m_State.IsForcedSynchronized = false;
-	m_State.nPriority = E131_PRIORITY_LOWEST;
 	m_State.DiscoveryTime = 0;
 
 	m_DiscoveryIpAddress = 0;
@@ -74,6 +73,7 @@ E131Bridge::E131Bridge(void) :
 	memset(m_SourceName, 0, sizeof(m_SourceName));
 	strncpy(m_SourceName, DEFAULT_SOURCE_NAME, sizeof(m_SourceName));
 
+	UpdateUniverseIndex();
 	FillDiscoveryPacket();
 }
 
@@ -100,6 +100,7 @@ void E131Bridge::Start(void) {
 
 	m_pLightSet->Start();
 	m_State.IsTransmitting = true;
+	m_State.IsNetworkDataLoss = false;
 }
 
 /**
@@ -109,14 +110,7 @@ void E131Bridge::Stop(void) {
 	m_pLightSet->Stop();
 	//
 	m_State.IsNetworkDataLoss = true;
-	m_State.IsMergeMode = false;
 	m_State.IsTransmitting = false;
-	m_State.IsSynchronized = false;
-	m_State.IsForcedSynchronized = false;
-	m_State.nPriority = E131_PRIORITY_LOWEST;
-	//
-	m_OutputPort.length = 0;
-	m_OutputPort.IsDataPending = false;
 }
 
 /**
@@ -136,22 +130,111 @@ void E131Bridge::SetOutput(LightSet *pLightSet) {
 	m_pLightSet = pLightSet;
 }
 
+/**
+ *
+ * @param nPortIndex
+ * @return The universe of the port, 0 is port not used
+ */
+const uint16_t E131Bridge::getUniverse(const uint8_t nPortIndex) {
+	assert(nPortIndex < E131_MAX_PORTS);
+
+	return m_OutputPorts[nPortIndex].nUniverse;
+}
+
+/**
+ * The data of the universe is handed to the LightSet port nPortIndex.
+ * The multicast group of the universe is joined. A universe can only be used by one port.
+ *
+ * @param nPortIndex
+ * @param nUniverse 0 is port not used
+ */
+void E131Bridge::setUniverse(const uint8_t nPortIndex, const uint16_t nUniverse) {
+	assert(nPortIndex < E131_MAX_PORTS);
+	assert((nUniverse == 0) || ((nUniverse >= E131_UNIVERSE_DEFAULT) && (nUniverse <= E131_UNIVERSE_MAX)));
+
+	if (m_OutputPorts[nPortIndex].nUniverse == nUniverse) {
+		return;
+	}
+
+	SetNetworkDataLossCondition(nPortIndex);
+	m_OutputPorts[nPortIndex].nUniverse = nUniverse;
+	m_OutputPorts[nPortIndex].HasSampled = false;
+
+	if (nUniverse != 0) {
+		JoinUniverse(nUniverse);
+	}
+
+	UpdateUniverseIndex();
+	FillDiscoveryPacket();
+}
+
 /**
  *
  * @return
  */
-const uint16_t E131Bridge::getUniverse() {
-	return m_nUniverse;
+const uint8_t E131Bridge::getActiveOutputPorts(void) {
+	return m_State.nActivePorts;
 }
 
 /**
+ * 9.3.1 Allocation of Multicast Addresses : 239.255.UHB.ULB
  *
  * @param nUniverse
  */
-void E131Bridge::setUniverse(const uint16_t nUniverse) {
-	assert((nUniverse > E131_UNIVERSE_DEFAULT) && (nUniverse < E131_UNIVERSE_MAX));
+void E131Bridge::JoinUniverse(const uint16_t nUniverse) {
+	uint32_t group_ip;
 
-	m_nUniverse = nUniverse;
+	(void)inet_aton("239.255.0.0", &group_ip);
+	group_ip = group_ip | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF00) << 8));
+
+	udp_joingroup(group_ip);
+}
+
+/**
+ * The lookup table is indexed by the low byte of the universe.
+ */
+void E131Bridge::UpdateUniverseIndex(void) {
+	memset(m_UniverseIndex, E131_PORT_INDEX_NONE, sizeof(m_UniverseIndex));
+	m_State.nActivePorts = 0;
+
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		const uint16_t nUniverse = m_OutputPorts[i].nUniverse;
+
+		if (nUniverse == 0) {
+			continue;
+		}
+
+		m_State.nActivePorts++;
+
+		if (m_UniverseIndex[nUniverse & 0xFF] == E131_PORT_INDEX_NONE) {
+			m_UniverseIndex[nUniverse & 0xFF] = (uint8_t) i;
+		} else {
+			m_UniverseIndex[nUniverse & 0xFF] = E131_PORT_INDEX_SCAN;
+		}
+	}
+}
+
+/**
+ *
+ * @param nUniverse
+ * @return The port for the universe or \ref E131_PORT_INDEX_NONE
+ */
+const uint8_t E131Bridge::GetPortIndex(const uint16_t nUniverse) {
+	const uint8_t nPortIndex = m_UniverseIndex[nUniverse & 0xFF];
+
+	if (nPortIndex < E131_MAX_PORTS) {
+		return m_OutputPorts[nPortIndex].nUniverse == nUniverse ? nPortIndex : E131_PORT_INDEX_NONE;
+	}
+
+	if (nPortIndex == E131_PORT_INDEX_SCAN) {
+		for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+			if (m_OutputPorts[i].nUniverse == nUniverse) {
+				return (uint8_t) i;
+			}
+		}
+	}
+
+	return E131_PORT_INDEX_NONE;
 }
 
 /**
@@ -194,158 +277,280 @@ void E131Bridge::setSourceName(const char aSourceName[E131_SOURCE_NAME_LENGTH])
  *
  * @return
  */
-const TMerge E131Bridge::getMergeMode(void) {
-	return m_OutputPort.mergeMode;
+const bool E131Bridge::getDiscoveryListener(void) {
+	return m_State.IsDiscoveryListener;
 }
 
 /**
+ * The Universe Discovery packets of the other sources are kept, see \ref getDiscoveredSource.
+ * Enabling joins the Universe Discovery multicast group, disabling clears the discovered sources.
  *
- * @param mergeMode
+ * @param IsDiscoveryListener
  */
-void E131Bridge::setMergeMode(TMerge mergeMode) {
-	m_OutputPort.mergeMode = mergeMode;
+void E131Bridge::setDiscoveryListener(const bool IsDiscoveryListener) {
+	if (IsDiscoveryListener == m_State.IsDiscoveryListener) {
+		return;
+	}
+
+	if (IsDiscoveryListener) {
+		udp_joingroup(m_DiscoveryIpAddress);
+	}
+
+	m_State.IsDiscoveryListener = IsDiscoveryListener;
+	m_State.nDiscoveredSources = 0;
 }
 
 /**
  *
+ * @return The number of sources found by their Universe Discovery packets
+ */
+const uint8_t E131Bridge::getDiscoveredSources(void) {
+	return m_State.nDiscoveredSources;
+}
+
+/**
+ *
+ * @param nIndex 0 .. \ref getDiscoveredSources - 1
+ * @return
+ */
+const struct TE131DiscoveredSource *E131Bridge::getDiscoveredSource(const uint8_t nIndex) {
+	assert(nIndex < m_State.nDiscoveredSources);
+
+	return &m_DiscoveredSources[nIndex];
+}
+
+/**
+ *
+ * @return
+ */
+const TE131Merge E131Bridge::getMergeMode(void) {
+	return m_OutputPorts[0].mergeMode;
+}
+
+/**
+ * The merge mode of all the ports
+ *
+ * @param mergeMode
+ */
+void E131Bridge::setMergeMode(TE131Merge mergeMode) {
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		m_OutputPorts[i].mergeMode = mergeMode;
+	}
+}
+
+/**
+ * The list of universes is sorted, as required by 8.5 List of Universes.
+ * The layers which are the same for all the pages are filled here, the first page is filled with \ref FillDiscoveryPage.
  */
 void E131Bridge::FillDiscoveryPacket(void) {
-	uint16_t root_layer_length = sizeof(struct TRootLayer);
-	uint16_t framing_layer_size = sizeof(struct TDiscoveryFrameLayer);
-	uint16_t discovery_layer_size = sizeof(struct TUniverseDiscoveryLayer) - (511 * 2);
+	uint16_t nUniverses = 0;
 
-	m_State.DiscoveryPacketLength = root_layer_length + framing_layer_size + discovery_layer_size;
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		const uint16_t nUniverse = m_OutputPorts[i].nUniverse;
+		unsigned j;
+
+		if (nUniverse == 0) {
+			continue;
+		}
+
+		for (j = nUniverses; (j > 0) && (m_DiscoveryUniverses[j - 1] > nUniverse); j--) {
+			m_DiscoveryUniverses[j] = m_DiscoveryUniverses[j - 1];
+		}
+
+		m_DiscoveryUniverses[j] = nUniverse;
+		nUniverses++;
+	}
+
+	m_State.nDiscoveryUniverses = nUniverses;
 
 	memset(&m_E131DiscoveryPacket, 0, sizeof(struct TE131DiscoveryPacket));
 
 	// Root Layer (See Section 5)
 	m_E131DiscoveryPacket.RootLayer.PreAmbleSize = SWAP_UINT16(0x10);
 	memcpy(m_E131DiscoveryPacket.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
-	m_E131DiscoveryPacket.RootLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | (m_State.DiscoveryPacketLength));
 	m_E131DiscoveryPacket.RootLayer.Vector = SWAP_UINT32(E131_VECTOR_ROOT_EXTENDED);
 	memcpy(m_E131DiscoveryPacket.RootLayer.Cid, m_Cid, E131_CID_LENGTH);
 
-
 	// E1.31 Framing Layer (See Section 6)
-	m_E131DiscoveryPacket.FrameLayer.FLagsLength = SWAP_UINT16((0x07 << 12) | (framing_layer_size + discovery_layer_size) );
 	m_E131DiscoveryPacket.FrameLayer.Vector = SWAP_UINT32(E131_VECTOR_EXTENDED_DISCOVERY);
 	memcpy(m_E131DiscoveryPacket.FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
 
 	// Universe Discovery Layer (See Section 8)
-	m_E131DiscoveryPacket.UniverseDiscoveryLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | discovery_layer_size);
 	m_E131DiscoveryPacket.UniverseDiscoveryLayer.Vector = SWAP_UINT32(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST);
-	m_E131DiscoveryPacket.UniverseDiscoveryLayer.ListOfUniverses[0] = SWAP_UINT16(m_nUniverse);
+
+	FillDiscoveryPage(0, GetDiscoveryLastPage());
+}
+
+/**
+ * 8.3 Page and 8.4 Last Page : the universes are sent in pages of \ref E131_DISCOVERY_UNIVERSES_PER_PAGE.
+ *
+ * @return The number of the final page, there is always a page 0
+ */
+const uint8_t E131Bridge::GetDiscoveryLastPage(void) {
+	if (m_State.nDiscoveryUniverses == 0) {
+		return 0;
+	}
+
+	return (uint8_t) ((m_State.nDiscoveryUniverses - 1) / E131_DISCOVERY_UNIVERSES_PER_PAGE);
+}
+
+/**
+ *
+ * @param nPage
+ * @param nLastPage
+ */
+void E131Bridge::FillDiscoveryPage(const uint8_t nPage, const uint8_t nLastPage) {
+	const uint16_t nFirst = (uint16_t) nPage * E131_DISCOVERY_UNIVERSES_PER_PAGE;
+	const uint16_t nUniverses = MIN((uint16_t) (m_State.nDiscoveryUniverses - nFirst), (uint16_t) E131_DISCOVERY_UNIVERSES_PER_PAGE);
+
+	uint16_t root_layer_length = sizeof(struct TRootLayer);
+	uint16_t framing_layer_size = sizeof(struct TDiscoveryFrameLayer);
+	uint16_t discovery_layer_size = sizeof(struct TUniverseDiscoveryLayer) - ((512 - nUniverses) * 2);
+
+	m_State.DiscoveryPacketLength = root_layer_length + framing_layer_size + discovery_layer_size;
+
+	m_E131DiscoveryPacket.RootLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | (m_State.DiscoveryPacketLength - (2 + 2 + E131_PACKET_IDENTIFIER_LENGTH)));
+	m_E131DiscoveryPacket.FrameLayer.FLagsLength = SWAP_UINT16((0x07 << 12) | (framing_layer_size + discovery_layer_size) );
+	m_E131DiscoveryPacket.UniverseDiscoveryLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | discovery_layer_size);
+	m_E131DiscoveryPacket.UniverseDiscoveryLayer.Page = nPage;
+	m_E131DiscoveryPacket.UniverseDiscoveryLayer.LastPage = nLastPage;
+
+	for (unsigned i = 0; i < nUniverses; i++) {
+		m_E131DiscoveryPacket.UniverseDiscoveryLayer.ListOfUniverses[i] = SWAP_UINT16(m_DiscoveryUniverses[nFirst + i]);
+	}
 }
 
 /**
  *
+ * @param nPortIndex
  * @param pData
  * @param nLength
  * @return
  */
-const bool E131Bridge::IsDmxDataChanged(const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+const bool E131Bridge::IsDmxDataChanged(const uint8_t nPortIndex, const uint8_t *pData, const uint16_t nLength) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
 
-	uint8_t *src = (uint8_t *)pData;
-	uint8_t *dst = (uint8_t *)m_OutputPort.data;
-
-	if (nLength != m_OutputPort.length) {
-		m_OutputPort.length = nLength;
-		for (unsigned i = 0 ; i < E131_DMX_LENGTH; i++) {
-			*dst++ = *src++;
-		}
+	if (nLength != pPort->length) {
+		pPort->length = nLength;
+		(void) lightset_merge_copy(pPort->data, pData, nLength, 0);
+		lightset_merge_mark(&pPort->changed, 0, nLength);
 		return true;
 	}
 
-	for (unsigned i = 0; i < E131_DMX_LENGTH; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
-	}
-
-	return isChanged;
+	return lightset_merge_copy(pPort->data, pData, nLength, &pPort->changed);
 }
 
 /**
+ * HTP merge of the sources with the highest priority.
  *
- * @param pData
+ * @param nPortIndex
+ * @param pSources The data of the sources, at least two
+ * @param nSources
  * @param nLength
  * @return
  */
-const bool E131Bridge::IsMergedDmxDataChanged(const uint8_t *pData, const uint16_t nLength) {
-	bool isChanged = false;
+const bool E131Bridge::IsMergedDmxDataChanged(const uint8_t nPortIndex, const uint8_t **pSources, const uint8_t nSources, const uint16_t nLength) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
+	const uint8_t *pA = pSources[0];
+	const uint8_t *pB = pSources[nSources - 1];
 
-	if (m_OutputPort.mergeMode == E131_MERGE_HTP) {
+	assert(nSources >= 2);
 
-		if (nLength != m_OutputPort.length) {
-			m_OutputPort.length = nLength;
-			for (unsigned i = 0; i < nLength; i++) {
-				uint8_t data = MAX(m_OutputPort.sourceA.data[i], m_OutputPort.sourceB.data[i]);
-				m_OutputPort.data[i] = data;
-			}
-			return true;
+#if E131_MAX_SOURCES > 2
+	for (unsigned i = 1; i < (unsigned) nSources - 1; i++) {
+		(void) lightset_merge_htp(m_MergeScratch, pA, pSources[i], nLength, 0);
+		pA = m_MergeScratch;
+	}
+#endif
+
+	if (nLength != pPort->length) {
+		pPort->length = nLength;
+		(void) lightset_merge_htp(pPort->data, pA, pB, nLength, 0);
+		lightset_merge_mark(&pPort->changed, 0, nLength);
+		return true;
+	}
+
+	return lightset_merge_htp(pPort->data, pA, pB, nLength, &pPort->changed);
+}
+
+/**
+ * 6.7.1 Network Data Loss : a source without data for \ref E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS is removed.
+ * When the last source is removed the universe is in the network data loss condition.
+ * A source without per-address priority data for \ref E131_PER_ADDRESS_PRIORITY_TIMEOUT_SECONDS reverts to its universe priority.
+ *
+ * @param nPortIndex
+ */
+void E131Bridge::CheckSourceTimeouts(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
+	bool IsChanged = false;
+
+	for (unsigned i = 0; i < E131_MAX_SOURCES; i++) {
+		struct TSource *pSource = &pPort->sources[i];
+
+		if (pSource->ip == 0) {
+			continue;
 		}
 
-		for (unsigned i = 0; i < nLength; i++) {
-			uint8_t data = MAX(m_OutputPort.sourceA.data[i], m_OutputPort.sourceB.data[i]);
-			if (data != m_OutputPort.data[i]) {
-				m_OutputPort.data[i] = data;
-				isChanged = true;
-			}
+		if ((m_nCurrentPacketMillis - pSource->time) >= (uint32_t) (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
+			RemoveSource(nPortIndex, pSource);
+			IsChanged = true;
+		} else if (pSource->IsPerAddressPriority && ((m_nCurrentPacketMillis - pSource->priorityTime) >= (uint32_t) (E131_PER_ADDRESS_PRIORITY_TIMEOUT_SECONDS * 1000))) {
+			pSource->IsPerAddressPriority = false;
+			SetUniversePriority(pSource);
+			IsChanged = true;
 		}
+	}
 
-		return isChanged;
+	if (!IsChanged) {
+		return;
+	}
+
+	if (pPort->nSources == 0) {
+		SetNetworkDataLossCondition(nPortIndex);
 	} else {
-		return IsDmxDataChanged(pData, nLength);
+		UpdateOutput(nPortIndex);
 	}
 }
 
+/**
+ * A source without per-address priority has its universe priority for all the slots.
+ * Universe priority 0 is a valid priority, but a slot priority 0 is a slot not driven, so it becomes 1.
+ *
+ * @param pSource
+ */
+void E131Bridge::SetUniversePriority(struct TSource *pSource) {
+	memset(pSource->priorities, MAX(pSource->priority, (uint8_t) 1), E131_DMX_LENGTH);
+}
+
 /**
  *
+ * @param nPortIndex
+ * @return The source of the packet, 0 when the source is not known
  */
-void E131Bridge::CheckMergeTimeouts(void) {
-	const uint32_t timeOutA = m_nCurrentPacketMillis - m_OutputPort.sourceA.time;
-	const uint32_t timeOutB = m_nCurrentPacketMillis - m_OutputPort.sourceB.time;
+struct TSource *E131Bridge::FindSource(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
 
-	if (timeOutA > (uint32_t)(E131_MERGE_TIMEOUT_SECONDS * 1000)) {
-		m_OutputPort.sourceA.ip = 0;
-		m_State.IsMergeMode = false;
+	for (unsigned i = 0; i < E131_MAX_SOURCES; i++) {
+		if (isIpCidMatch(&pPort->sources[i])) {
+			return &pPort->sources[i];
+		}
 	}
 
-	if (timeOutB > (uint32_t)(E131_MERGE_TIMEOUT_SECONDS * 1000)) {
-		m_OutputPort.sourceB.ip = 0;
-		m_State.IsMergeMode = false;
-	}
+	return 0;
 }
 
 /**
  *
- * @return
+ * @param nPortIndex
+ * @param pSource
  */
-const bool E131Bridge::IsPriorityTimeOut(void) {
-	const uint32_t timeOutA = m_nCurrentPacketMillis - m_OutputPort.sourceA.time;
-	const uint32_t timeOutB = m_nCurrentPacketMillis - m_OutputPort.sourceB.time;
+void E131Bridge::RemoveSource(const uint8_t nPortIndex, struct TSource *pSource) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
 
-	if ( (m_OutputPort.sourceA.ip != 0) && (m_OutputPort.sourceB.ip != 0) ) {
-		if ( (timeOutA < (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) || (timeOutB < (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) ) {
-			return false;
-		} else {
-			return true;
-		}
-	} else if ( (m_OutputPort.sourceA.ip != 0) && (m_OutputPort.sourceB.ip == 0) ) {
-		if (timeOutA > (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) {
-			return true;
-		}
-	} else if ( (m_OutputPort.sourceA.ip == 0) && (m_OutputPort.sourceB.ip != 0) ) {
-		if (timeOutB > (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) {
-			return true;
-		}
-	}
+	assert(pPort->nSources != 0);
 
-	return false;
+	pSource->ip = 0;
+	pPort->nSources--;
 }
 
 /**
@@ -359,7 +564,7 @@ const bool E131Bridge::isIpCidMatch(const struct TSource *source) {
 		return false;
 	}
 
-	if (memcmp(source->cid, m_E131.E131Packet.Raw.RootLayer.Cid, E131_CID_LENGTH) != 0) {
+	if (memcmp(source->cid, m_View.pCid, E131_CID_LENGTH) != 0) {
 		return false;
 	}
 
@@ -368,32 +573,29 @@ const bool E131Bridge::isIpCidMatch(const struct TSource *source) {
 
 /**
  *
+ * @param nPortIndex The port of the universe in the packet
  */
-void E131Bridge::HandleDmx(void) {
-	const uint8_t *p = &m_E131.E131Packet.Data.DMPLayer.PropertyValues[1];
-	const uint16_t slots = SWAP_UINT16(m_E131.E131Packet.Data.DMPLayer.PropertyValueCount) - (uint16_t)1;
-	const uint32_t ipA = m_OutputPort.sourceA.ip;
-	const uint32_t ipB = m_OutputPort.sourceB.ip;
-	struct TSource *pSourceA = &m_OutputPort.sourceA;
-	struct TSource *pSourceB = &m_OutputPort.sourceB;
-	const bool isSourceA = isIpCidMatch(pSourceA);
-	const bool isSourceB = isIpCidMatch(pSourceB);
+void E131Bridge::HandleDmx(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
+	const uint8_t *p = m_View.pData;
+	const uint16_t slots = m_View.nSlots;
+	const uint8_t nStartCode = m_View.nStartCode;
+	struct TSource *pSource;
+
+	// Only the levels and the per-address priority are handled, other START Codes are ignored
+	if ((nStartCode != (uint8_t) E131_START_CODE_DMX) && (nStartCode != (uint8_t) E131_START_CODE_PRIORITY)) {
+		return;
+	}
 
-	bool sendNewData = false;
+	pSource = FindSource(nPortIndex);
 
 	// 6.9.2 Sequence Numbering
 	// Having first received a packet with sequence number A, a second packet with sequence number B
 	// arrives. If, using signed 8-bit binary arithmetic, B – A is less than or equal to 0, but greater than -20 then
 	// the packet containing sequence number B shall be deemed out of sequence and discarded
-	if (isSourceA) {
-		const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSourceA->sequenceNumberData);
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
-			return;
-		}
-	} else if (isSourceB) {
-		const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSourceB->sequenceNumberData);
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
+	if (pSource != 0) {
+		const int8_t diff = (int8_t) (m_View.nSequence - pSource->sequenceNumberData);
+		pSource->sequenceNumberData = m_View.nSequence;
 		if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
 			return;
 		}
@@ -401,229 +603,413 @@ void E131Bridge::HandleDmx(void) {
 
 	// This bit, when set to 1, indicates that the data in this packet is intended for use in visualization or media
 	// server preview applications and shall not be used to generate live output.
-	if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_PREVIEW_DATA) != 0) {
+	if ((m_View.nOptions & E131_OPTIONS_MASK_PREVIEW_DATA) != 0) {
 		return;
 	}
 
 	// Upon receipt of a packet containing this bit set to a value of 1, receiver shall enter network data loss condition.
 	// Any property values in these packets shall be ignored.
-	if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_STREAM_TERMINATED) != 0) {
-		if (isSourceA || isSourceB) {
-			if (!m_State.IsMergeMode) {
-				SetNetworkDataLossCondition();
+	// The other sources of the universe are not affected.
+	if ((m_View.nOptions & E131_OPTIONS_MASK_STREAM_TERMINATED) != 0) {
+		if (pSource != 0) {
+			RemoveSource(nPortIndex, pSource);
+
+			if (pPort->nSources == 0) {
+				SetNetworkDataLossCondition(nPortIndex);
+			} else if (!pPort->IsSampling) {
+				UpdateOutput(nPortIndex);
 			}
 		}
 		return;
 	}
 
+	if (pSource == 0) {
+		if (pPort->nSources == E131_MAX_SOURCES) {
+			// More sources than the table holds, discarding data
+			return;
+		}
+
+		for (unsigned i = 0; i < E131_MAX_SOURCES; i++) {
+			if (pPort->sources[i].ip == 0) {
+				pSource = &pPort->sources[i];
+				break;
+			}
+		}
+
+		assert(pSource != 0);
+
+		pSource->ip = m_E131.IPAddressFrom;
+		memcpy(pSource->cid, m_View.pCid, E131_CID_LENGTH);
+		pSource->sequenceNumberData = m_View.nSequence;
+		pSource->priority = m_View.nPriority;
+		// The slot can be reused, the data of the previous source must not be merged
+		memset((void *)pSource->data, 0, E131_DMX_LENGTH);
+		pSource->length = 0;
+		pSource->IsPerAddressPriority = false;
+		SetUniversePriority(pSource);
+		pPort->nSources++;
+
+		if (!pPort->HasSampled) {
+			pPort->HasSampled = true;
+			pPort->IsSampling = true;
+			pPort->SamplingTime = m_nCurrentPacketMillis;
+		}
+	}
+
+	pSource->time = m_nCurrentPacketMillis;
+
+	if (nStartCode == (uint8_t) E131_START_CODE_PRIORITY) {
+		// The slots not in the packet are not driven by the source
+		memcpy((void *)pSource->priorities, (const void *)p, slots);
+		memset((void *)&pSource->priorities[slots], 0, E131_DMX_LENGTH - slots);
+
+		pSource->IsPerAddressPriority = true;
+		pSource->priorityTime = m_nCurrentPacketMillis;
+	} else {
+		pSource->priority = m_View.nPriority;
+
+		if (!pSource->IsPerAddressPriority && (pSource->priorities[0] != MAX(pSource->priority, (uint8_t) 1))) {
+			SetUniversePriority(pSource);
+		}
+
+		memcpy((void *)pSource->data, (const void *)p, slots);
+
+		if (slots < pSource->length) {
+			memset((void *)&pSource->data[slots], 0, pSource->length - slots);
+		}
+
+		pSource->length = slots;
+		pPort->nLatestSource = (uint8_t) (pSource - pPort->sources);
+	}
+
+	// 6.2.4.1 Synchronization Address : the universe synchronization packets to wait for, 0 is act on the data right away.
+	// The universe is synchronized from the first synchronization packet for the address on, until then the data is output.
+	if (m_View.nSynchronizationAddress != pPort->nSynchronizationAddress) {
+		pPort->nSynchronizationAddress = m_View.nSynchronizationAddress;
+		pPort->IsSynchronized = false;
+
+		if (pPort->nSynchronizationAddress != 0) {
+			JoinUniverse(pPort->nSynchronizationAddress);
+		}
+	}
+
 	// This bit indicates whether to lock or revert to an unsynchronized state when synchronization is lost
 	// (See Section 11 on Universe Synchronization and 11.1 for discussion on synchronization states).
 	// When set to 0, components that had been operating in a synchronized state shall not update with any new packets
 	// until synchronization resumes.
 	// When set to 1, once synchronization has been lost, components that had been operating in a synchronized state
 	// need not wait for a new E1.31 Synchronization Packet in order to update to the next E1.31 Data Packet.
-	if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_FORCE_SYNCHRONIZATION) == 0) {
-		m_State.IsForcedSynchronized = true;
-		if (m_State.IsSynchronized) {
-			return;
-		}
-	} else {
-		m_State.IsForcedSynchronized = false;
-	}
+	pPort->IsForcedSynchronized = ((m_View.nOptions & E131_OPTIONS_MASK_FORCE_SYNCHRONIZATION) == 0);
 
-	if (m_State.IsMergeMode) {
-		CheckMergeTimeouts();
+	if (pPort->IsSampling) {
+		return;
 	}
 
-	if (m_E131.E131Packet.Data.FrameLayer.Priority < m_State.nPriority ){
-		if (!IsPriorityTimeOut()) {
-			return;
+	// While synchronized, the data is held as pending
+	UpdateOutput(nPortIndex);
+}
+
+/**
+ * Only the sources with the highest priority are output. HTP merges all of them, LTP takes the latest.
+ * When a source sends per-address priority, the highest priority is selected for each slot and the merge is always HTP.
+ * The cost is bounded by \ref E131_MAX_SOURCES.
+ *
+ * @param nPortIndex
+ */
+void E131Bridge::UpdateOutput(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
+	const uint8_t *pSources[E131_MAX_SOURCES];
+	const uint8_t *pAllSources[E131_MAX_SOURCES];
+	const uint8_t *pAllPriorities[E131_MAX_SOURCES];
+	const struct TSource *pLatest = 0;
+	uint8_t nSources = 0;
+	uint8_t nAllSources = 0;
+	uint8_t nPriority = 0;
+	uint16_t nLength = 0;
+	uint16_t nAllLength = 0;
+	bool IsPerAddressPriority = false;
+
+	for (unsigned i = 0; i < E131_MAX_SOURCES; i++) {
+		const struct TSource *pSource = &pPort->sources[i];
+
+		if (pSource->ip == 0) {
+			continue;
 		}
-		m_State.nPriority = m_E131.E131Packet.Data.FrameLayer.Priority;
-	} else if (m_E131.E131Packet.Data.FrameLayer.Priority > m_State.nPriority) {
-		m_OutputPort.sourceA.ip = 0;
-		m_OutputPort.sourceB.ip = 0;
-		m_State.IsMergeMode = false;
-		m_State.nPriority = m_E131.E131Packet.Data.FrameLayer.Priority;
-	}
-
-	if ((ipA == 0) && (ipB == 0)) {
-		//printf("1. First package from Source\n");
-		pSourceA->ip = m_E131.IPAddressFrom;
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		memcpy(pSourceA->cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-		pSourceA->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsDmxDataChanged(p, slots);
-
-	} else if (isSourceA && (ipB == 0)) {
-		//printf("2. Continue package from SourceA\n");
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceA->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsDmxDataChanged(p, slots);
-
-	} else if ((ipA == 0) && isSourceB) {
-		//printf("3. Continue package from SourceB\n");
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceB->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceB->data, (const void *)p, slots);
-		sendNewData = IsDmxDataChanged(p, slots);
-
-	} else if (!isSourceA && (ipB == 0)) {
-		//printf("4. New ip, start merging\n");
-		pSourceB->ip = m_E131.IPAddressFrom;
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		memcpy(m_OutputPort.sourceB.cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-		pSourceB->time = m_nCurrentPacketMillis;
-		m_State.IsMergeMode = true;
-		memcpy((void *)pSourceB->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceB->data, slots);
-
-	} else if ((ipA == 0) && !isSourceB) {
-		//printf("5. New ip, start merging\n");
-		pSourceA->ip = m_E131.IPAddressFrom;
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		memcpy(m_OutputPort.sourceA.cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-		pSourceA->time = m_nCurrentPacketMillis;
-		m_State.IsMergeMode = true;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceA->data, slots);
-
-	} else if (isSourceA && !isSourceB) {
-		//printf("6. Continue merging\n");
-		pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceA->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceA->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceA->data, slots);
-
-	} else if (!isSourceA && isSourceB) {
-		//printf("7. Continue merging\n");
-		pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-		pSourceB->time = m_nCurrentPacketMillis;
-		memcpy((void *)pSourceB->data, (const void *)p, slots);
-		sendNewData = IsMergedDmxDataChanged(pSourceB->data, slots);
-
-	} else if (isSourceA && isSourceB) {
-		//printf("8. Source matches both buffers, this shouldn't be happening!\n");
-		return;
 
-	} else if (!isSourceA && !isSourceB) {
-		//printf("9. More than two sources, discarding data\n");
-		return;
+		pAllSources[nAllSources] = pSource->data;
+		pAllPriorities[nAllSources++] = pSource->priorities;
+		nAllLength = MAX(nAllLength, pSource->length);
+		IsPerAddressPriority |= pSource->IsPerAddressPriority;
+
+		if ((nSources == 0) || (pSource->priority > nPriority)) {
+			nPriority = pSource->priority;
+			nSources = 0;
+			nLength = 0;
+			pLatest = pSource;
+		} else if (pSource->priority < nPriority) {
+			continue;
+		}
 
-	} else {
-		//printf("0. No cases matched, this shouldn't happen!\n");
+		pSources[nSources++] = pSource->data;
+		nLength = MAX(nLength, pSource->length);
+
+		if ((i == pPort->nLatestSource) || ((int32_t) (pSource->time - pLatest->time) > 0)) {
+			pLatest = pSource;
+		}
+	}
+
+	if (nSources == 0) {
 		return;
 	}
 
-	if (sendNewData) {
-		if (!m_State.IsSynchronized) {
-			Start();
-			m_pLightSet->SetData(0, m_OutputPort.data, m_OutputPort.length);
-		} else {
-			m_OutputPort.IsDataPending = true;
-		}
+	pPort->nPriority = nPriority;
 
+	bool sendNewData;
 
+	if (IsPerAddressPriority) {
+		pPort->IsMergeMode = (nAllSources > 1);
+		lightset_merge_priority(m_MergeScratch, pAllSources, pAllPriorities, nAllSources, nAllLength);
+		sendNewData = IsDmxDataChanged(nPortIndex, m_MergeScratch, nAllLength);
+	} else if ((nSources == 1) || (pPort->mergeMode == E131_MERGE_LTP)) {
+		pPort->IsMergeMode = (nSources > 1);
+		sendNewData = IsDmxDataChanged(nPortIndex, pLatest->data, pLatest->length);
+	} else {
+		pPort->IsMergeMode = true;
+		sendNewData = IsMergedDmxDataChanged(nPortIndex, pSources, nSources, nLength);
+	}
+
+	// Data pending when the universe is no longer synchronized is output now
+	if (!sendNewData && !pPort->IsDataPending) {
+		return;
+	}
+
+	if (pPort->IsSynchronized) {
+		pPort->IsDataPending = true;
+	} else {
+		Start();
+		SetLightSetData(nPortIndex);
+		pPort->IsDataPending = false;
 	}
 }
 
 /**
+ * Hand the data to the LightSet, together with the slots changed since the previous hand over.
  *
+ * @param nPortIndex
+ */
+void E131Bridge::SetLightSetData(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
+	struct _lightset_merge_result *pChanged = &pPort->changed;
+	const uint16_t nLength = pPort->length;
+
+	if (pChanged->is_changed && (pChanged->first_slot < nLength)) {
+		const uint16_t nLast = MIN(pChanged->last_slot, (uint16_t) (nLength - 1));
+		m_pLightSet->SetDataRange(nPortIndex, pPort->data, nLength, pChanged->first_slot, (nLast - pChanged->first_slot) + 1);
+	} else {
+		m_pLightSet->SetData(nPortIndex, pPort->data, nLength);
+	}
+
+	pChanged->is_changed = false;
+}
+
+/**
+ * 11 Universe Synchronization : all the universes with the synchronization address become synchronized,
+ * and their pending data is handed to the LightSet as a single update.
+ * The universes can have different synchronization addresses, each address is synchronized on its own.
  */
 void E131Bridge::HandleSynchronization(void) {
-	if (m_E131.E131Packet.Synchronization.FrameLayer.UniverseNumber != SWAP_UINT16(m_nUniverse)) {
+	const uint16_t nSynchronizationAddress = m_View.nUniverse;
+	bool IsUpdating = false;
+
+	if (nSynchronizationAddress == 0) {
 		return;
 	}
 
-	m_State.IsSynchronized = true;
-	m_State.SynchronizationTime = m_nCurrentPacketMillis;
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		struct TOutputPort *pPort = &m_OutputPorts[i];
 
-	if (m_OutputPort.IsDataPending) {
-		Start();
-		m_pLightSet->SetData(0, m_OutputPort.data, m_OutputPort.length);
-		m_OutputPort.IsDataPending = false;
+		if ((pPort->nSources == 0) || (pPort->nSynchronizationAddress != nSynchronizationAddress)) {
+			continue;
+		}
+
+		pPort->IsSynchronized = true;
+		pPort->SynchronizationTime = m_nCurrentPacketMillis;
+
+		if (pPort->IsDataPending) {
+			if (!IsUpdating) {
+				Start();
+				m_pLightSet->BeginUpdate();
+				IsUpdating = true;
+			}
+
+			SetLightSetData((uint8_t) i);
+			pPort->IsDataPending = false;
+		}
+	}
+
+	if (IsUpdating) {
+		m_pLightSet->EndUpdate();
 	}
 }
 
 /**
+ * The sources of the universe are gone. The LightSet is stopped when all the universes are gone.
  *
+ * @param nPortIndex
  */
-void E131Bridge::SetNetworkDataLossCondition(void) {
-	Stop();
-	m_OutputPort.sourceA.ip = (uint32_t) 0;
-	m_OutputPort.sourceB.ip = (uint32_t) 0;
+void E131Bridge::SetNetworkDataLossCondition(const uint8_t nPortIndex) {
+	struct TOutputPort *pPort = &m_OutputPorts[nPortIndex];
+
+	for (unsigned i = 0; i < E131_MAX_SOURCES; i++) {
+		pPort->sources[i].ip = (uint32_t) 0;
+	}
+
+	pPort->nSources = 0;
+	pPort->IsMergeMode = false;
+	pPort->IsSynchronized = false;
+	pPort->IsForcedSynchronized = false;
+	pPort->nSynchronizationAddress = 0;
+	pPort->IsSampling = false;
+	pPort->nPriority = E131_PRIORITY_LOWEST;
+	pPort->length = 0;
+	pPort->IsDataPending = false;
+
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		if (m_OutputPorts[i].nSources != 0) {
+			return;
+		}
+	}
+
+	if (m_State.IsTransmitting) {
+		Stop();
+	}
 }
 
 /**
- *
+ * Ends the sampling period, removes the sources which timed out.
+ * A synchronized universe without synchronization for \ref E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS reverts to unsynchronized,
+ * unless the source asks to stay synchronized (Force_Synchronization is 0). The pending data is output then.
  */
-void E131Bridge::SendDiscoveryPacket(void) {
-	udp_sendto((const uint8_t *)&(m_E131DiscoveryPacket), m_State.DiscoveryPacketLength, m_DiscoveryIpAddress, (uint16_t)E131_DEFAULT_PORT);
-	m_State.DiscoveryTime = m_nCurrentPacketMillis;
+void E131Bridge::CheckNetworkDataLoss(void) {
+	for (unsigned i = 0; i < E131_MAX_PORTS; i++) {
+		struct TOutputPort *pPort = &m_OutputPorts[i];
+
+		if (pPort->nSources == 0) {
+			continue;
+		}
+
+		if (pPort->IsSampling && ((m_nCurrentPacketMillis - pPort->SamplingTime) >= (uint32_t) (E131_SAMPLING_PERIOD_SECONDS * 1000))) {
+			pPort->IsSampling = false;
+			UpdateOutput((uint8_t) i);
+		}
+
+		CheckSourceTimeouts((uint8_t) i);
+
+		if (pPort->IsSynchronized && !pPort->IsForcedSynchronized) {
+			if ((m_nCurrentPacketMillis - pPort->SynchronizationTime) >= (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
+				pPort->IsSynchronized = false;
+
+				if (pPort->IsDataPending) {
+					Start();
+					SetLightSetData((uint8_t) i);
+					pPort->IsDataPending = false;
+				}
+			}
+		}
+	}
 }
 
 /**
- *
- * @return
+ * All the pages are sent. With a single page the packet is already filled.
  */
-const bool E131Bridge::IsValidRoot(void) {
-	// 5 E1.31 use of the ACN Root Layer Protocol
-	// Receivers shall discard the packet if the ACN Packet Identifier is not valid.
-	if (memcmp(m_E131.E131Packet.Raw.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, 12) != 0) {
-		return false;
-	}
-	
-	if (m_E131.E131Packet.Raw.RootLayer.Vector != SWAP_UINT32(E131_VECTOR_ROOT_DATA)
-			 && (m_E131.E131Packet.Raw.RootLayer.Vector != SWAP_UINT32(E131_VECTOR_ROOT_EXTENDED)) ) {
-		return false;
+void E131Bridge::SendDiscoveryPacket(void) {
+	const uint8_t nLastPage = GetDiscoveryLastPage();
+
+	for (unsigned nPage = 0; nPage <= nLastPage; nPage++) {
+		if (nLastPage != 0) {
+			FillDiscoveryPage((uint8_t) nPage, nLastPage);
+		}
+
+		udp_sendto((const uint8_t *)&(m_E131DiscoveryPacket), m_State.DiscoveryPacketLength, m_DiscoveryIpAddress, (uint16_t)E131_DEFAULT_PORT);
 	}
 
-	return true;
+	m_State.DiscoveryTime = m_nCurrentPacketMillis;
 }
 
 /**
- *
- * @return
+ * The source is looked up by its CID. The universes are collected from page 0 on,
+ * a page received out of order leaves the list as it is until the next page 0.
  */
-const bool E131Bridge::IsValidDataPacket(void) {
-	// Frame layer
+void E131Bridge::HandleDiscovery(void) {
+	if (memcmp(m_View.pCid, m_Cid, E131_CID_LENGTH) == 0) {
+		return;
+	}
 
-	// 8.2 Association of Multicast Addresses and Universe
-	// Note: The identity of the universe shall be determined by the universe number in the
-	// packet and not assumed from the multicast address.
-	if (m_E131.E131Packet.Data.FrameLayer.Universe != SWAP_UINT16(m_nUniverse)) {
-		return false;
+	struct TE131DiscoveredSource *pSource = 0;
+
+	for (unsigned i = 0; i < m_State.nDiscoveredSources; i++) {
+		if (memcmp(m_DiscoveredSources[i].cid, m_View.pCid, E131_CID_LENGTH) == 0) {
+			pSource = &m_DiscoveredSources[i];
+			break;
+		}
 	}
 
-	// DMP layer
+	if (pSource == 0) {
+		if (m_State.nDiscoveredSources == E131_MAX_DISCOVERED_SOURCES) {
+			// More sources than the table holds
+			return;
+		}
 
-	// The DMP Layer's Vector shall be set to 0x02, which indicates a DMP Set Property message by
-	// transmitters. Receivers shall discard the packet if the received value is not 0x02.
-	if (m_E131.E131Packet.Data.DMPLayer.Vector != (uint8_t)E131_VECTOR_DMP_SET_PROPERTY) {
-		return false;
+		pSource = &m_DiscoveredSources[m_State.nDiscoveredSources++];
+		memcpy(pSource->cid, m_View.pCid, E131_CID_LENGTH);
+		pSource->nUniverses = 0;
+		pSource->IsTruncated = false;
+		pSource->nextPage = 0;
 	}
 
-	// Transmitters shall set the DMP Layer's Address Type and Data Type to 0xa1. Receivers shall discard the
-	// packet if the received value is not 0xa1.
-	if (m_E131.E131Packet.Data.DMPLayer.Type != (uint8_t)0xa1) {
-		return false;
+	pSource->time = m_nCurrentPacketMillis;
+	pSource->ip = m_E131.IPAddressFrom;
+	memcpy(pSource->sourceName, m_View.pSourceName, E131_SOURCE_NAME_LENGTH - 1);
+	pSource->sourceName[E131_SOURCE_NAME_LENGTH - 1] = '\0';
+
+	if (m_View.nPage == 0) {
+		pSource->nUniverses = 0;
+		pSource->IsTruncated = false;
+	} else if (m_View.nPage != pSource->nextPage) {
+		return;
 	}
 
-	// Transmitters shall set the DMP Layer's First Property Address to 0x0000. Receivers shall discard the
-	// packet if the received value is not 0x0000.
-	if (m_E131.E131Packet.Data.DMPLayer.FirstAddressProperty != SWAP_UINT16((uint16_t)0x0000)) {
-		return false;
+	pSource->nextPage = m_View.nPage + 1;
+
+	for (unsigned i = 0; i < m_View.nUniverses; i++) {
+		if (pSource->nUniverses == E131_MAX_DISCOVERED_UNIVERSES) {
+			pSource->IsTruncated = true;
+			break;
+		}
+
+		pSource->universes[pSource->nUniverses++] = (uint16_t) ((m_View.pUniverses[i * 2] << 8) | m_View.pUniverses[i * 2 + 1]);
 	}
+}
 
-	// Transmitters shall set the DMP Layer's Address Increment to 0x0001. Receivers shall discard the packet if
-	// the received value is not 0x0001.
-	if (m_E131.E131Packet.Data.DMPLayer.AddressIncrement != SWAP_UINT16((uint16_t)0x0001)) {
-		return false;
+/**
+ * The table is kept compact, the last entry takes the place of a removed entry.
+ */
+void E131Bridge::CheckDiscoveredSourceTimeouts(void) {
+	unsigned i = 0;
+
+	while (i < m_State.nDiscoveredSources) {
+		if ((m_nCurrentPacketMillis - m_DiscoveredSources[i].time) >= (uint32_t) (E131_UNIVERSE_DISCOVERY_TIMEOUT_SECONDS * 1000)) {
+			m_State.nDiscoveredSources--;
+
+			if (i != m_State.nDiscoveredSources) {
+				memcpy(&m_DiscoveredSources[i], &m_DiscoveredSources[m_State.nDiscoveredSources], sizeof(struct TE131DiscoveredSource));
+			}
+		} else {
+			i++;
+		}
 	}
 
-	return true;
+	m_State.DiscoveredSourcesTime = m_nCurrentPacketMillis;
 }
 
 /**
@@ -642,39 +1028,40 @@ int E131Bridge::Run(void) {
 		SendDiscoveryPacket();
 	}
 
+	CheckNetworkDataLoss();
+
+	if (m_State.IsDiscoveryListener && (m_nCurrentPacketMillis - m_State.DiscoveredSourcesTime >= 1000)) {
+		CheckDiscoveredSourceTimeouts();
+	}
+
 	if (nBytesReceived == 0) {
-		if ((m_nCurrentPacketMillis - m_nPreviousPacketMillis) >= (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
-			SetNetworkDataLossCondition();
-		}
 		return 0;
 	}
 
-	if (!IsValidRoot()) {
+	const enum TE131PacketType nPacketType = e131_validate((const uint8_t *)packet, (uint16_t)nBytesReceived, &m_View);
+
+	if (nPacketType == E131_PACKET_INVALID) {
 		return 0;
 	}
 
+	m_E131.IPAddressFrom = IPAddressFrom;
 	m_nPreviousPacketMillis = m_nCurrentPacketMillis;
 
-	if (m_State.IsSynchronized && !m_State.IsForcedSynchronized) {
-		if ((m_nCurrentPacketMillis - m_State.SynchronizationTime) >= (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
-			m_State.IsSynchronized = false;
-		}
-	}
-
-	const uint32_t nRootVector = SWAP_UINT32(m_E131.E131Packet.Raw.RootLayer.Vector);
+	if (nPacketType == E131_PACKET_DATA) {
+		// 8.2 Association of Multicast Addresses and Universe
+		// Note: The identity of the universe shall be determined by the universe number in the
+		// packet and not assumed from the multicast address.
+		const uint8_t nPortIndex = GetPortIndex(m_View.nUniverse);
 
-	if (nRootVector == E131_VECTOR_ROOT_DATA) {
-		if (!IsValidDataPacket()) {
+		if (nPortIndex == E131_PORT_INDEX_NONE) {
 			return 0;
 		}
-		HandleDmx();
-	} else if (nRootVector == E131_VECTOR_ROOT_EXTENDED) {
-		const uint32_t nFramingVector = SWAP_UINT32(m_E131.E131Packet.Raw.FrameLayer.Vector);
-
-		if (nFramingVector == E131_VECTOR_EXTENDED_SYNCHRONIZATION) {
-			HandleSynchronization();
-		}
 
+		HandleDmx(nPortIndex);
+	} else if (nPacketType == E131_PACKET_SYNCHRONIZATION) {
+		HandleSynchronization();
+	} else if (m_State.IsDiscoveryListener) {
+		HandleDiscovery();
 	}
 
 	return nBytesReceived;
@@ -0,0 +1,494 @@
+/**
+ * @file e131controller.cpp
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131controller.h"
+
+#include "lightsetinput.h"
+
+#include "inet.h"
+#include "udp.h"
+
+#include "util.h"
+#include "sys_time.h"
+
+static const uint8_t ACN_PACKET_IDENTIFIER[E131_PACKET_IDENTIFIER_LENGTH] = { 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 }; ///< 5.3 ACN Packet Identifier
+
+#define DEFAULT_SOURCE_NAME  "Raspberry Pi sACN E1.31 DMX In http://www.raspberrypi-dmx.org"
+
+/**
+ * The first bytes of the Root Layer are not part of the Root Layer PDU
+ */
+#define ROOT_LAYER_PREAMBLE_SIZE	(2 + 2 + E131_PACKET_IDENTIFIER_LENGTH)
+
+/**
+ * 9.3.1 Allocation of Multicast Addresses : 239.255.UHB.ULB
+ *
+ * @param nUniverse
+ * @return
+ */
+static uint32_t multicast_ip(const uint16_t nUniverse) {
+	uint32_t group_ip;
+
+	(void)inet_aton("239.255.0.0", &group_ip);
+
+	return group_ip | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)nUniverse & (uint32_t)0xFF00) << 8));
+}
+
+/**
+ *
+ */
+E131Controller::E131Controller(void) :
+		m_pLightSetInput(0),
+		m_nPriority(E131_PRIORITY_DEFAULT),
+		m_nSynchronizationAddress(0),
+		m_nSynchronizationIp(0),
+		m_nSynchronizationSequence(0),
+		m_nKeepAlive(E131_KEEP_ALIVE_MILLIS),
+		m_IsStarted(false),
+		m_nCurrentMillis(0),
+		m_nDiscoveryMillis(0),
+		m_nDiscoveryPacketLength(0) {
+
+	memset(m_InputPorts, 0, sizeof(m_InputPorts));
+	memset(m_Cid, 0, sizeof(m_Cid));
+
+	m_DiscoveryIpAddress = multicast_ip(E131_UNIVERSE_DISCOVERY);
+
+	memset(m_SourceName, 0, sizeof(m_SourceName));
+	strncpy(m_SourceName, DEFAULT_SOURCE_NAME, sizeof(m_SourceName));
+
+	FillDataPacket();
+	FillSynchronizationPacket();
+	FillDiscoveryPacket();
+}
+
+/**
+ *
+ */
+E131Controller::~E131Controller(void) {
+	Stop();
+}
+
+/**
+ *
+ * @param pLightSetInput
+ */
+void E131Controller::SetInput(LightSetInput *pLightSetInput) {
+	assert(pLightSetInput != 0);
+
+	m_pLightSetInput = pLightSetInput;
+}
+
+/**
+ *
+ * @param nPortIndex
+ * @return The universe of the port, 0 is port not used
+ */
+const uint16_t E131Controller::getUniverse(const uint8_t nPortIndex) {
+	assert(nPortIndex < E131_CONTROLLER_MAX_PORTS);
+
+	return m_InputPorts[nPortIndex].nUniverse;
+}
+
+/**
+ * The DMX data of port nPortIndex of the LightSetInput is transmitted on the universe.
+ *
+ * @param nPortIndex
+ * @param nUniverse 0 is port not used
+ */
+void E131Controller::setUniverse(const uint8_t nPortIndex, const uint16_t nUniverse) {
+	assert(nPortIndex < E131_CONTROLLER_MAX_PORTS);
+	assert((nUniverse == 0) || ((nUniverse >= E131_UNIVERSE_DEFAULT) && (nUniverse <= E131_UNIVERSE_MAX)));
+
+	struct TE131InputPort *pPort = &m_InputPorts[nPortIndex];
+
+	if (pPort->nUniverse == nUniverse) {
+		return;
+	}
+
+	if (pPort->IsTransmitting) {
+		for (unsigned i = 0; i < E131_STREAM_TERMINATED_PACKETS; i++) {
+			SendData(nPortIndex, 0, 0, E131_OPTIONS_MASK_STREAM_TERMINATED);
+		}
+	}
+
+	pPort->nUniverse = nUniverse;
+	pPort->nMulticastIp = multicast_ip(nUniverse);
+	pPort->nRepeat = 0;
+	pPort->IsTransmitting = false;
+
+	FillDiscoveryPacket();
+}
+
+/**
+ *
+ * @return
+ */
+const uint8_t E131Controller::getPriority(void) {
+	return m_nPriority;
+}
+
+/**
+ *
+ * @param nPriority 0 - 200
+ */
+void E131Controller::setPriority(const uint8_t nPriority) {
+	m_nPriority = MIN(nPriority, (uint8_t) E131_PRIORITY_HIGHEST);
+	m_E131DataPacket.FrameLayer.Priority = m_nPriority;
+}
+
+/**
+ *
+ * @return The universe of the synchronization packets, 0 is no synchronization
+ */
+const uint16_t E131Controller::getSynchronizationAddress(void) {
+	return m_nSynchronizationAddress;
+}
+
+/**
+ * 6.2.4 Synchronization Address : the data packets are followed by an E1.31 Synchronization Packet on this universe.
+ *
+ * @param nSynchronizationAddress 0 is no synchronization
+ */
+void E131Controller::setSynchronizationAddress(const uint16_t nSynchronizationAddress) {
+	assert((nSynchronizationAddress == 0) || ((nSynchronizationAddress >= E131_UNIVERSE_DEFAULT) && (nSynchronizationAddress <= E131_UNIVERSE_MAX)));
+
+	m_nSynchronizationAddress = nSynchronizationAddress;
+	m_nSynchronizationIp = multicast_ip(nSynchronizationAddress);
+
+	m_E131DataPacket.FrameLayer.SynchronizationAddress = SWAP_UINT16(nSynchronizationAddress);
+	m_E131SynchronizationPacket.FrameLayer.UniverseNumber = SWAP_UINT16(nSynchronizationAddress);
+}
+
+/**
+ *
+ * @return Milliseconds
+ */
+const uint32_t E131Controller::getKeepAlive(void) {
+	return m_nKeepAlive;
+}
+
+/**
+ *
+ * @param nKeepAlive Milliseconds, at most \ref E131_KEEP_ALIVE_MILLIS
+ */
+void E131Controller::setKeepAlive(const uint32_t nKeepAlive) {
+	m_nKeepAlive = MIN(nKeepAlive, (uint32_t) E131_KEEP_ALIVE_MILLIS);
+}
+
+/**
+ *
+ * @return
+ */
+const uint8_t* E131Controller::GetCid(void) {
+	return m_Cid;
+}
+
+/**
+ *
+ * @param
+ */
+void E131Controller::setCid(const uint8_t aCid[E131_CID_LENGTH]) {
+	assert(aCid != 0);
+
+	memcpy(m_Cid, aCid, E131_CID_LENGTH);
+	memcpy(m_E131DataPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
+	memcpy(m_E131SynchronizationPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
+	memcpy(m_E131DiscoveryPacket.RootLayer.Cid, aCid, E131_CID_LENGTH);
+}
+
+/**
+ *
+ * @return
+ */
+const char* E131Controller::GetSourceName(void) {
+	return m_SourceName;
+}
+
+/**
+ *
+ * @param
+ */
+void E131Controller::setSourceName(const char aSourceName[E131_SOURCE_NAME_LENGTH]) {
+	memcpy(m_SourceName, aSourceName, E131_SOURCE_NAME_LENGTH);
+	memcpy(m_E131DataPacket.FrameLayer.SourceName, aSourceName, E131_SOURCE_NAME_LENGTH);
+	memcpy(m_E131DiscoveryPacket.FrameLayer.SourceName, aSourceName, E131_SOURCE_NAME_LENGTH);
+}
+
+/**
+ *
+ */
+void E131Controller::Start(void) {
+	assert(m_pLightSetInput != 0);
+
+	if (m_IsStarted) {
+		return;
+	}
+
+	m_pLightSetInput->Start();
+	m_IsStarted = true;
+}
+
+/**
+ * 6.2.6 Stream_Terminated : the receivers know right away that the universes are no longer transmitted.
+ */
+void E131Controller::Stop(void) {
+	if (!m_IsStarted) {
+		return;
+	}
+
+	for (unsigned i = 0; i < E131_CONTROLLER_MAX_PORTS; i++) {
+		struct TE131InputPort *pPort = &m_InputPorts[i];
+
+		if (!pPort->IsTransmitting) {
+			continue;
+		}
+
+		for (unsigned j = 0; j < E131_STREAM_TERMINATED_PACKETS; j++) {
+			SendData((uint8_t) i, 0, 0, E131_OPTIONS_MASK_STREAM_TERMINATED);
+		}
+
+		pPort->IsTransmitting = false;
+	}
+
+	m_pLightSetInput->Stop();
+	m_IsStarted = false;
+}
+
+/**
+ * The layers which are the same for all the data packets.
+ */
+void E131Controller::FillDataPacket(void) {
+	memset(&m_E131DataPacket, 0, sizeof(struct TE131DataPacket));
+
+	// Root Layer (See Section 5)
+	m_E131DataPacket.RootLayer.PreAmbleSize = SWAP_UINT16(0x10);
+	memcpy(m_E131DataPacket.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	m_E131DataPacket.RootLayer.Vector = SWAP_UINT32(E131_VECTOR_ROOT_DATA);
+	memcpy(m_E131DataPacket.RootLayer.Cid, m_Cid, E131_CID_LENGTH);
+
+	// E1.31 Framing Layer (See Section 6)
+	m_E131DataPacket.FrameLayer.Vector = SWAP_UINT32(E131_VECTOR_DATA_PACKET);
+	memcpy(m_E131DataPacket.FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
+	m_E131DataPacket.FrameLayer.Priority = m_nPriority;
+	m_E131DataPacket.FrameLayer.SynchronizationAddress = SWAP_UINT16(m_nSynchronizationAddress);
+
+	// DMP Layer (See Section 7)
+	m_E131DataPacket.DMPLayer.Vector = E131_VECTOR_DMP_SET_PROPERTY;
+	m_E131DataPacket.DMPLayer.Type = 0xa1;
+	m_E131DataPacket.DMPLayer.FirstAddressProperty = SWAP_UINT16((uint16_t)0x0000);
+	m_E131DataPacket.DMPLayer.AddressIncrement = SWAP_UINT16((uint16_t)0x0001);
+	m_E131DataPacket.DMPLayer.PropertyValues[0] = E131_START_CODE_DMX;
+}
+
+/**
+ *
+ */
+void E131Controller::FillSynchronizationPacket(void) {
+	const uint16_t nFrameLength = sizeof(struct TE131SynchronizationFrameLayer);
+	const uint16_t nRootLength = sizeof(struct TRootLayer) - ROOT_LAYER_PREAMBLE_SIZE + nFrameLength;
+
+	memset(&m_E131SynchronizationPacket, 0, sizeof(struct TE131SynchronizationPacket));
+
+	// Root Layer (See Section 5)
+	m_E131SynchronizationPacket.RootLayer.PreAmbleSize = SWAP_UINT16(0x10);
+	memcpy(m_E131SynchronizationPacket.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	m_E131SynchronizationPacket.RootLayer.FlagsLength = (uint16_t) SWAP_UINT16((0x07 << 12) | nRootLength);
+	m_E131SynchronizationPacket.RootLayer.Vector = SWAP_UINT32(E131_VECTOR_ROOT_EXTENDED);
+	memcpy(m_E131SynchronizationPacket.RootLayer.Cid, m_Cid, E131_CID_LENGTH);
+
+	// E1.31 Framing Layer (See Section 6)
+	m_E131SynchronizationPacket.FrameLayer.FLagsLength = (uint16_t) SWAP_UINT16((0x07 << 12) | nFrameLength);
+	m_E131SynchronizationPacket.FrameLayer.Vector = SWAP_UINT32(E131_VECTOR_EXTENDED_SYNCHRONIZATION);
+	m_E131SynchronizationPacket.FrameLayer.UniverseNumber = SWAP_UINT16(m_nSynchronizationAddress);
+}
+
+/**
+ * The list of universes is sorted, as required by 8.5 List of Universes.
+ * There are less universes than fit in a page.
+ */
+void E131Controller::FillDiscoveryPacket(void) {
+	uint16_t aUniverses[E131_CONTROLLER_MAX_PORTS];
+	uint16_t nUniverses = 0;
+
+	for (unsigned i = 0; i < E131_CONTROLLER_MAX_PORTS; i++) {
+		const uint16_t nUniverse = m_InputPorts[i].nUniverse;
+		unsigned j;
+
+		if (nUniverse == 0) {
+			continue;
+		}
+
+		for (j = nUniverses; (j > 0) && (aUniverses[j - 1] > nUniverse); j--) {
+			aUniverses[j] = aUniverses[j - 1];
+		}
+
+		aUniverses[j] = nUniverse;
+		nUniverses++;
+	}
+
+	const uint16_t nDiscoveryLength = sizeof(struct TUniverseDiscoveryLayer) - ((E131_DISCOVERY_UNIVERSES_PER_PAGE - nUniverses) * 2);
+	const uint16_t nFrameLength = sizeof(struct TDiscoveryFrameLayer) + nDiscoveryLength;
+
+	m_nDiscoveryPacketLength = sizeof(struct TRootLayer) + nFrameLength;
+
+	memset(&m_E131DiscoveryPacket, 0, sizeof(struct TE131DiscoveryPacket));
+
+	// Root Layer (See Section 5)
+	m_E131DiscoveryPacket.RootLayer.PreAmbleSize = SWAP_UINT16(0x10);
+	memcpy(m_E131DiscoveryPacket.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, E131_PACKET_IDENTIFIER_LENGTH);
+	m_E131DiscoveryPacket.RootLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | (m_nDiscoveryPacketLength - ROOT_LAYER_PREAMBLE_SIZE));
+	m_E131DiscoveryPacket.RootLayer.Vector = SWAP_UINT32(E131_VECTOR_ROOT_EXTENDED);
+	memcpy(m_E131DiscoveryPacket.RootLayer.Cid, m_Cid, E131_CID_LENGTH);
+
+	// E1.31 Framing Layer (See Section 6)
+	m_E131DiscoveryPacket.FrameLayer.FLagsLength = SWAP_UINT16((0x07 << 12) | nFrameLength);
+	m_E131DiscoveryPacket.FrameLayer.Vector = SWAP_UINT32(E131_VECTOR_EXTENDED_DISCOVERY);
+	memcpy(m_E131DiscoveryPacket.FrameLayer.SourceName, m_SourceName, E131_SOURCE_NAME_LENGTH);
+
+	// Universe Discovery Layer (See Section 8)
+	m_E131DiscoveryPacket.UniverseDiscoveryLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | nDiscoveryLength);
+	m_E131DiscoveryPacket.UniverseDiscoveryLayer.Vector = SWAP_UINT32(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST);
+
+	for (unsigned i = 0; i < nUniverses; i++) {
+		m_E131DiscoveryPacket.UniverseDiscoveryLayer.ListOfUniverses[i] = SWAP_UINT16(aUniverses[i]);
+	}
+}
+
+/**
+ * 6.7.2 Sequence Numbering : every packet of the universe has the next sequence number.
+ *
+ * @param nPortIndex
+ * @param pData 0 when nLength is 0
+ * @param nLength Number of slots, without the start code
+ * @param nOptions \ref TOptions
+ */
+void E131Controller::SendData(const uint8_t nPortIndex, const uint8_t *pData, const uint16_t nLength, const uint8_t nOptions) {
+	struct TE131InputPort *pPort = &m_InputPorts[nPortIndex];
+	const uint16_t nSlots = MIN(nLength, (uint16_t) E131_DMX_LENGTH);
+	const uint16_t nDmpLength = sizeof(struct TDataDMPLayer) - (E131_DMX_LENGTH - nSlots);
+	const uint16_t nFrameLength = sizeof(struct TDataFrameLayer) + nDmpLength;
+	const uint16_t nPacketLength = sizeof(struct TRootLayer) + nFrameLength;
+
+	m_E131DataPacket.RootLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | (nPacketLength - ROOT_LAYER_PREAMBLE_SIZE));
+	m_E131DataPacket.FrameLayer.FLagsLength = SWAP_UINT16((0x07 << 12) | nFrameLength);
+	m_E131DataPacket.FrameLayer.SequenceNumber = pPort->nSequence++;
+	m_E131DataPacket.FrameLayer.Options = nOptions;
+	m_E131DataPacket.FrameLayer.Universe = SWAP_UINT16(pPort->nUniverse);
+	m_E131DataPacket.DMPLayer.FlagsLength = SWAP_UINT16((0x07 << 12) | nDmpLength);
+	m_E131DataPacket.DMPLayer.PropertyValueCount = SWAP_UINT16(nSlots + 1);
+
+	if (nSlots != 0) {
+		memcpy(&m_E131DataPacket.DMPLayer.PropertyValues[1], pData, nSlots);
+	}
+
+	udp_sendto((const uint8_t *)&(m_E131DataPacket), nPacketLength, pPort->nMulticastIp, (uint16_t)E131_DEFAULT_PORT);
+
+	pPort->nMillis = m_nCurrentMillis;
+}
+
+/**
+ *
+ */
+void E131Controller::SendSynchronization(void) {
+	m_E131SynchronizationPacket.FrameLayer.SequenceNumber = m_nSynchronizationSequence++;
+
+	udp_sendto((const uint8_t *)&(m_E131SynchronizationPacket), (uint16_t) sizeof(struct TE131SynchronizationPacket), m_nSynchronizationIp, (uint16_t)E131_DEFAULT_PORT);
+}
+
+/**
+ *
+ */
+void E131Controller::SendDiscoveryPacket(void) {
+	udp_sendto((const uint8_t *)&(m_E131DiscoveryPacket), m_nDiscoveryPacketLength, m_DiscoveryIpAddress, (uint16_t)E131_DEFAULT_PORT);
+	m_nDiscoveryMillis = m_nCurrentMillis;
+}
+
+/**
+ * Changed data is sent right away. Unchanged data is sent \ref E131_TRANSMIT_SUPPRESSION_PACKETS times,
+ * and then once every keep alive time. With a synchronization address the data packets sent are followed by a synchronization packet.
+ *
+ * @return The number of data packets sent
+ */
+int E131Controller::Run(void) {
+	int nSent = 0;
+
+	if (!m_IsStarted) {
+		return 0;
+	}
+
+	m_nCurrentMillis = millis();
+
+	if (m_nCurrentMillis - m_nDiscoveryMillis >= (E131_UNIVERSE_DISCOVERY_INTERVAL_SECONDS * 1000)) {
+		SendDiscoveryPacket();
+	}
+
+	for (unsigned i = 0; i < E131_CONTROLLER_MAX_PORTS; i++) {
+		struct TE131InputPort *pPort = &m_InputPorts[i];
+
+		if (pPort->nUniverse == 0) {
+			continue;
+		}
+
+		uint16_t nLength;
+		bool IsChanged;
+
+		const uint8_t *pData = m_pLightSetInput->GetData((uint8_t) i, &nLength, &IsChanged);
+
+		if (pData == 0) {
+			continue;
+		}
+
+		const uint32_t nElapsed = m_nCurrentMillis - pPort->nMillis;
+
+		if (IsChanged || !pPort->IsTransmitting) {
+			pPort->nRepeat = 0;
+		} else if (pPort->nRepeat < E131_TRANSMIT_SUPPRESSION_PACKETS) {
+			if (nElapsed < E131_CONTROLLER_REPEAT_MILLIS) {
+				continue;
+			}
+		} else if (nElapsed < m_nKeepAlive) {
+			continue;
+		}
+
+		SendData((uint8_t) i, pData, nLength, 0);
+
+		pPort->nRepeat++;
+		pPort->IsTransmitting = true;
+		nSent++;
+	}
+
+	if ((nSent != 0) && (m_nSynchronizationAddress != 0)) {
+		SendSynchronization();
+	}
+
+	return nSent;
+}
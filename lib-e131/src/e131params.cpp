@@ -39,12 +39,18 @@ static const char PARAMS_UNIVERSE[] ALIGNED = "universe";			///<
 static const char PARAMS_MERGE_MODE[] ALIGNED = "merge_mode";		///<
 static const char PARAMS_OUTPUT[] ALIGNED = "output";				///<
 static const char PARAMS_CID[] ALIGNED = "cid";						///<
+static const char PARAMS_DIRECTION[] ALIGNED = "direction";			///< "input" : the DMX received is transmitted as sACN
+static const char PARAMS_PRIORITY[] ALIGNED = "priority";			///< Priority of the sACN transmitted
+static const char PARAMS_SYNC_ADDRESS[] ALIGNED = "sync_address";	///< Universe of the synchronization packets transmitted, 0 is none
 
 static uint16_t E131ParamsUniverse ALIGNED = E131_UNIVERSE_DEFAULT;	///<
 static _output_type E131ParamsOutputType ALIGNED = OUTPUT_TYPE_DMX;	///<
-static TMerge E131ParamsMergeMode = E131_MERGE_HTP;					///<
+static TE131Merge E131ParamsMergeMode = E131_MERGE_HTP;					///<
 static char E131ParamsCidString[UUID_STRING_LENGTH + 1] ALIGNED;
 static bool E131HaveCustomCid = false;
+static bool E131ParamsIsInput = false;								///<
+static uint8_t E131ParamsPriority = E131_PRIORITY_DEFAULT;			///<
+static uint16_t E131ParamsSynchronizationAddress = 0;				///<
 
 /**
  *
@@ -54,6 +60,7 @@ static void process_line_read(const char *line) {
 	char value[UUID_STRING_LENGTH + 2] ALIGNED;
 	uint8_t len;
 
+	uint8_t value8;
 	uint16_t value16;
 
 	if (sscan_uint16_t(line, PARAMS_UNIVERSE, &value16) == 2) {
@@ -86,6 +93,28 @@ static void process_line_read(const char *line) {
 		memcpy(E131ParamsCidString, value, UUID_STRING_LENGTH);
 		E131ParamsCidString[UUID_STRING_LENGTH] = '\0';
 		E131HaveCustomCid = true;
+		return;
+	}
+
+	len = 5;
+	if (sscan_char_p(line, PARAMS_DIRECTION, value, &len) == 2) {
+		if(memcmp(value, "input", 5) == 0) {
+			E131ParamsIsInput = true;
+		}
+		return;
+	}
+
+	if (sscan_uint8_t(line, PARAMS_PRIORITY, &value8) == 2) {
+		if (value8 <= E131_PRIORITY_HIGHEST) {
+			E131ParamsPriority = value8;
+		}
+		return;
+	}
+
+	if (sscan_uint16_t(line, PARAMS_SYNC_ADDRESS, &value16) == 2) {
+		if (value16 <= E131_UNIVERSE_MAX) {
+			E131ParamsSynchronizationAddress = value16;
+		}
 	}
 
 }
@@ -133,7 +162,7 @@ const _output_type E131Params::GetOutputType(void) {
  *
  * @return
  */
-const TMerge E131Params::GetMergeMode(void) {
+const TE131Merge E131Params::GetMergeMode(void) {
 	return E131ParamsMergeMode;
 }
 
@@ -152,3 +181,27 @@ const bool E131Params::isHaveCustomCid(void) {
 const char* E131Params::GetCidString(void) {
 	return E131ParamsCidString;
 }
+
+/**
+ *
+ * @return true when the DMX received is transmitted as sACN
+ */
+const bool E131Params::isInput(void) {
+	return E131ParamsIsInput;
+}
+
+/**
+ *
+ * @return range 0 to 200
+ */
+const uint8_t E131Params::GetPriority(void) {
+	return E131ParamsPriority;
+}
+
+/**
+ *
+ * @return 0 is no synchronization
+ */
+const uint16_t E131Params::GetSynchronizationAddress(void) {
+	return E131ParamsSynchronizationAddress;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file e131validate.cpp
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "e131.h"
+#include "e131packets.h"
+#include "e131validate.h"
+
+#include "util.h"
+
+/**
+ * The receive buffer is not always word aligned, so let the compiler generate the loads which are safe for any alignment.
+ */
+typedef uint32_t uint32_unaligned_t __attribute__((aligned(1)));
+
+/**
+ * 5.1 Preamble Size, 5.2 Post-amble Size and 5.3 ACN Packet Identifier : the first 16 octets are always the same
+ */
+static const uint8_t ROOT_LAYER_PREAMBLE[16] __attribute__((aligned(4))) = { 0x00, 0x10, 0x00, 0x00, 0x41, 0x53, 0x43, 0x2d, 0x45, 0x31, 0x2e, 0x31, 0x37, 0x00, 0x00, 0x00 };
+
+#define DATA_HEADER_LENGTH		(sizeof(struct TE131DataPacket) - (E131_DMX_LENGTH + 1))						///< Up to the START Code
+#define DISCOVERY_HEADER_LENGTH	(sizeof(struct TE131DiscoveryPacket) - (E131_DISCOVERY_UNIVERSES_PER_PAGE * 2))	///< Up to the List of Universes
+#define DISCOVERY_LAYER_HEADER	(sizeof(struct TUniverseDiscoveryLayer) - (E131_DISCOVERY_UNIVERSES_PER_PAGE * 2))	///<
+
+/**
+ * All the checks for a packet are done in a single pass over the buffer, and the fields are extracted in the view.
+ * After this nothing in the buffer needs to be parsed again.
+ *
+ * @param pBuffer The packet as received
+ * @param nLength The number of bytes received
+ * @param pView Only valid when the packet is not \ref E131_PACKET_INVALID
+ * @return \ref TE131PacketType
+ */
+const enum TE131PacketType e131_validate(const uint8_t *pBuffer, const uint16_t nLength, struct TE131View *pView) {
+	const union UE131Packet *pPacket = (const union UE131Packet *) pBuffer;
+	const uint32_unaligned_t *pWords = (const uint32_unaligned_t *) pBuffer;
+	const uint32_t *pPreamble = (const uint32_t *) ROOT_LAYER_PREAMBLE;
+
+	if (nLength < sizeof(struct TE131RawPacket)) {
+		return E131_PACKET_INVALID;
+	}
+
+	// Receivers shall discard the packet if the Preamble Size, Post-amble Size or ACN Packet Identifier is not valid
+	if (((pWords[0] ^ pPreamble[0]) | (pWords[1] ^ pPreamble[1]) | (pWords[2] ^ pPreamble[2]) | (pWords[3] ^ pPreamble[3])) != 0) {
+		return E131_PACKET_INVALID;
+	}
+
+	const uint32_t nRootVector = pPacket->Raw.RootLayer.Vector;
+	const uint32_t nFramingVector = pPacket->Raw.FrameLayer.Vector;
+
+	pView->pCid = pPacket->Raw.RootLayer.Cid;
+
+	if (nRootVector == SWAP_UINT32(E131_VECTOR_ROOT_DATA)) {
+		const struct TDataFrameLayer *pFrameLayer = &pPacket->Data.FrameLayer;
+		const struct TDataDMPLayer *pDMPLayer = &pPacket->Data.DMPLayer;
+
+		if ((nFramingVector != SWAP_UINT32(E131_VECTOR_DATA_PACKET)) || (nLength < DATA_HEADER_LENGTH)) {
+			return E131_PACKET_INVALID;
+		}
+
+		// 7.2 DMP Layer Vector 0x02, 7.3 Address Type and Data Type 0xa1, 7.4 First Property Address 0x0000, 7.5 Address Increment 0x0001
+		if ((((uint32_t) pDMPLayer->Vector ^ E131_VECTOR_DMP_SET_PROPERTY) | ((uint32_t) pDMPLayer->Type ^ 0xa1) | pDMPLayer->FirstAddressProperty | (pDMPLayer->AddressIncrement ^ SWAP_UINT16((uint16_t) 0x0001))) != 0) {
+			return E131_PACKET_INVALID;
+		}
+
+		// 7.6 Property Value Count : the START Code and the slots, all of them received
+		const uint16_t nPropertyValueCount = SWAP_UINT16(pDMPLayer->PropertyValueCount);
+
+		if ((nPropertyValueCount == 0) || (nPropertyValueCount > (E131_DMX_LENGTH + 1)) || ((DATA_HEADER_LENGTH + nPropertyValueCount) > nLength)) {
+			return E131_PACKET_INVALID;
+		}
+
+		pView->nUniverse = SWAP_UINT16(pFrameLayer->Universe);
+		pView->nSequence = pFrameLayer->SequenceNumber;
+		pView->nPriority = pFrameLayer->Priority;
+		pView->nOptions = pFrameLayer->Options;
+		pView->nSynchronizationAddress = SWAP_UINT16(pFrameLayer->SynchronizationAddress);
+		pView->nStartCode = pDMPLayer->PropertyValues[0];
+		pView->nSlots = nPropertyValueCount - 1;
+		pView->pData = &pDMPLayer->PropertyValues[1];
+
+		return E131_PACKET_DATA;
+	}
+
+	if (nRootVector != SWAP_UINT32(E131_VECTOR_ROOT_EXTENDED)) {
+		return E131_PACKET_INVALID;
+	}
+
+	if (nFramingVector == SWAP_UINT32(E131_VECTOR_EXTENDED_SYNCHRONIZATION)) {
+		const struct TE131SynchronizationFrameLayer *pFrameLayer = &pPacket->Synchronization.FrameLayer;
+
+		if (nLength < sizeof(struct TE131SynchronizationPacket)) {
+			return E131_PACKET_INVALID;
+		}
+
+		pView->nUniverse = SWAP_UINT16(pFrameLayer->UniverseNumber);
+		pView->nSequence = pFrameLayer->SequenceNumber;
+
+		return E131_PACKET_SYNCHRONIZATION;
+	}
+
+	if (nFramingVector == SWAP_UINT32(E131_VECTOR_EXTENDED_DISCOVERY)) {
+		const struct TUniverseDiscoveryLayer *pLayer = &pPacket->Discovery.UniverseDiscoveryLayer;
+
+		if ((nLength < DISCOVERY_HEADER_LENGTH) || (pLayer->Vector != SWAP_UINT32(VECTOR_UNIVERSE_DISCOVERY_UNIVERSE_LIST))) {
+			return E131_PACKET_INVALID;
+		}
+
+		// The universes in the PDU, limited by the bytes received
+		const uint16_t nLayerLength = SWAP_UINT16(pLayer->FlagsLength) & 0x0FFF;
+
+		if (nLayerLength < DISCOVERY_LAYER_HEADER) {
+			return E131_PACKET_INVALID;
+		}
+
+		const uint16_t nUniverses = MIN((uint16_t) ((nLayerLength - DISCOVERY_LAYER_HEADER) / 2), (uint16_t) ((nLength - DISCOVERY_HEADER_LENGTH) / 2));
+
+		pView->pSourceName = pPacket->Discovery.FrameLayer.SourceName;
+		pView->nPage = pLayer->Page;
+		pView->nLastPage = pLayer->LastPage;
+		pView->nUniverses = MIN(nUniverses, (uint16_t) E131_DISCOVERY_UNIVERSES_PER_PAGE);
+		pView->pUniverses = &pBuffer[DISCOVERY_HEADER_LENGTH];
+
+		return E131_PACKET_DISCOVERY;
+	}
+
+	return E131_PACKET_INVALID;
+}
@@ -71,8 +71,8 @@ extern /*@shared@*/const char *wifi_get_firmware_version(void);
  */
 
 extern /*@shared@*/const char *system_get_sdk_version(void);
-extern bool wifi_get_macaddr(const uint8_t *);
-extern bool wifi_get_ip_info(const struct ip_info *);
+extern bool wifi_get_macaddr(uint8_t *);
+extern bool wifi_get_ip_info(struct ip_info *);
 extern /*@shared@*/const char *wifi_station_get_hostname(void);
 extern _wifi_mode wifi_get_opmode(void);
 extern const _wifi_station_status wifi_station_get_connect_status(void);
@@ -70,7 +70,7 @@ _wifi_mode wifi_get_opmode(void) {
  * @param macaddr
  * @return
  */
-bool wifi_get_macaddr(const uint8_t *macaddr) {
+bool wifi_get_macaddr(uint8_t *macaddr) {
 	assert(macaddr != NULL);
 
 	if (macaddr == NULL) {
@@ -90,7 +90,7 @@ bool wifi_get_macaddr(const uint8_t *macaddr) {
  * @param info
  * @return
  */
-bool wifi_get_ip_info(const struct ip_info *info) {
+bool wifi_get_ip_info(struct ip_info *info) {
 	assert(info != NULL);
 
 	if (info == NULL) {
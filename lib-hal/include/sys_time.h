@@ -41,6 +41,7 @@ extern void sys_time_set(/*@out@*/const struct tm *);
 extern time_t sys_time (/*@null@*/ time_t *);
 
 extern const uint32_t millis();
+extern const uint32_t micros();
 
 #ifdef __cplusplus
 }
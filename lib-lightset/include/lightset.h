@@ -36,6 +36,21 @@ public:
 	virtual void Stop(void)= 0;
 
 	virtual void SetData(const uint8_t, const uint8_t *, const uint16_t)= 0;
+
+	/**
+	 * Same as SetData, the data is the full universe.
+	 * Only the slots nOffset .. nOffset + nCount - 1 are changed since the previous SetData/SetDataRange.
+	 * The default implementation calls SetData.
+	 */
+	virtual void SetDataRange(const uint8_t nPort, const uint8_t *pData, const uint16_t nLength, const uint16_t nOffset, const uint16_t nCount);
+
+	/**
+	 * The SetData/SetDataRange calls between BeginUpdate and EndUpdate are a single update of several ports
+	 * (E1.31 universe synchronization, ArtSync), which is output at once at EndUpdate.
+	 * The default implementations do nothing, so each SetData is output right away.
+	 */
+	virtual void BeginUpdate(void);
+	virtual void EndUpdate(void);
 };
 
 #endif /* LIGHTSET_H_ */
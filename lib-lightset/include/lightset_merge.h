@@ -0,0 +1,58 @@
+/**
+ * @file lightset_merge.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIGHTSET_MERGE_H_
+#define LIGHTSET_MERGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * The range of slots changed by the merges and compares since is_changed was cleared.
+ * first_slot and last_slot are only valid when is_changed is true.
+ */
+struct _lightset_merge_result {
+	bool is_changed;		///<
+	uint16_t first_slot;	///< Index of the first changed slot
+	uint16_t last_slot;		///< Index of the last changed slot
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void lightset_merge_mark(struct _lightset_merge_result *, const uint16_t, const uint16_t);
+
+extern bool lightset_merge_htp(uint8_t *, const uint8_t *, const uint8_t *, const uint16_t, /*@null@*/struct _lightset_merge_result *);
+extern bool lightset_merge_copy(uint8_t *, const uint8_t *, const uint16_t, /*@null@*/struct _lightset_merge_result *);
+extern bool lightset_merge_compare(const uint8_t *, const uint8_t *, const uint16_t, /*@null@*/struct _lightset_merge_result *);
+
+extern void lightset_merge_priority(uint8_t *, const uint8_t **, const uint8_t **, const uint8_t, const uint16_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIGHTSET_MERGE_H_ */
@@ -0,0 +1,48 @@
+/**
+ * @file lightsetinput.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIGHTSETINPUT_H_
+#define LIGHTSETINPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+class LightSetInput {
+public:
+	virtual ~LightSetInput(void);
+
+	virtual void Start(void)= 0;
+	virtual void Stop(void)= 0;
+
+	/**
+	 * @param nPort
+	 * @param pLength The number of slots, without the start code
+	 * @param pIsChanged Is the data changed since the previous GetData?
+	 * @return The latest DMX data received, without the start code. 0 when nothing is received.
+	 */
+	virtual const uint8_t *GetData(const uint8_t nPort, uint16_t *pLength, bool *pIsChanged)= 0;
+};
+
+#endif /* LIGHTSETINPUT_H_ */
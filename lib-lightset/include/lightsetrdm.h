@@ -0,0 +1,75 @@
+/**
+ * @file lightsetrdm.h
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIGHTSETRDM_H_
+#define LIGHTSETRDM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * The RDM controller behind the output ports of a node.
+ * The Table of Devices is kept by the controller, so a TOD request is answered without discovery on the DMX line.
+ * Nothing blocks: requests are queued and the responses are collected after \ref Run.
+ */
+class LightSetRdm {
+public:
+	virtual ~LightSetRdm(void);
+
+	/**
+	 * Called from the main loop of the node. Runs the background discovery and the queued requests, must not block.
+	 */
+	virtual void Run(void)= 0;
+
+	/**
+	 * Flush the TOD of the port and start a full discovery.
+	 */
+	virtual void Full(const uint8_t nPort)= 0;
+
+	/**
+	 * @return The UIDs of the TOD of the port, RDM_UID_SIZE bytes each. The number of UIDs is returned in pUidCount.
+	 */
+	virtual const uint8_t *GetTod(const uint8_t nPort, uint16_t *pUidCount)= 0;
+
+	/**
+	 * @return true once after the TOD of the port is changed by the discovery
+	 */
+	virtual const bool IsTodChanged(const uint8_t nPort)= 0;
+
+	/**
+	 * Queue a RDM request, starting with the start code. It is sent on the DMX line by \ref Run.
+	 * @param nTag Returned with the response, identifies the requester
+	 * @return false when the request is rejected or the queue is full
+	 */
+	virtual bool Request(const uint8_t nPort, const uint8_t *pRdmData, const uint32_t nTag)= 0;
+
+	/**
+	 * There is no response for a broadcast request, nor for a request which timed out.
+	 * @return The next response starting with the start code, once, or 0. The port and the tag of the request are returned in pPort and pTag.
+	 */
+	virtual const uint8_t *GetResponse(uint8_t *pPort, uint32_t *pTag)= 0;
+};
+
+#endif /* LIGHTSETRDM_H_ */
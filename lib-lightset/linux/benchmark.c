@@ -0,0 +1,313 @@
+/**
+ * @file benchmark.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Time lightset_merge_htp, lightset_merge_copy and lightset_merge_compare against the per slot loops they replaced,
+ * for unchanged and changed data, with word aligned buffers and with the ArtDmx Data offset of 18.
+ * The results of both are checked to be equal first, for random data and lengths.
+ *
+ * benchmark [-l loops]
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lightset_merge.h"
+
+#define SLOTS			512
+#define OFFSET_ARTDMX	18		///< Offset of the Data in the ArtDmx packet
+#define VERIFY_LOOPS	20000
+
+#define ALIGNED __attribute__((aligned(4)))
+
+static uint8_t store_out[2][SLOTS + 32] ALIGNED;
+static uint8_t store_a[2][SLOTS + 32] ALIGNED;
+static uint8_t store_b[SLOTS + 32] ALIGNED;
+static uint8_t store_ref[SLOTS + 32] ALIGNED;
+
+static volatile uint32_t sink;
+
+/*
+ * The loops replaced by lightset_merge
+ */
+
+static bool slot_htp(uint8_t *out, const uint8_t *a, const uint8_t *b, const uint16_t length) {
+	bool is_changed = false;
+	uint16_t i;
+
+	for (i = 0; i < length; i++) {
+		const uint8_t data = a[i] > b[i] ? a[i] : b[i];
+		if (data != out[i]) {
+			out[i] = data;
+			is_changed = true;
+		}
+	}
+
+	return is_changed;
+}
+
+static bool slot_copy(uint8_t *out, const uint8_t *src, const uint16_t length) {
+	bool is_changed = false;
+	uint16_t i;
+
+	for (i = 0; i < length; i++) {
+		if (out[i] != src[i]) {
+			out[i] = src[i];
+			is_changed = true;
+		}
+	}
+
+	return is_changed;
+}
+
+static bool slot_compare(const uint8_t *a, const uint8_t *b, const uint16_t length) {
+	uint16_t i;
+
+	for (i = 0; i < length; i++) {
+		if (a[i] != b[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Checks
+ */
+
+static void fill_random(uint8_t *p, const uint16_t length) {
+	uint16_t i;
+
+	for (i = 0; i < length; i++) {
+		p[i] = (uint8_t) rand();
+	}
+}
+
+/**
+ * Start from a copy of b, with a few random slots changed. Mostly equal is the case which matters.
+ */
+static void fill_similar(uint8_t *p, const uint8_t *b, const uint16_t length) {
+	unsigned n = (unsigned) rand() % 4;
+
+	memcpy(p, b, length);
+
+	while ((n-- != 0) && (length != 0)) {
+		p[(unsigned) rand() % length] = (uint8_t) rand();
+	}
+}
+
+static int check_range(const char *name, const uint8_t *x, const uint8_t *y, const uint16_t length, const bool is_changed, const struct _lightset_merge_result *r) {
+	int first = -1, last = -1;
+	uint16_t i;
+
+	for (i = 0; i < length; i++) {
+		if (x[i] != y[i]) {
+			if (first < 0) {
+				first = i;
+			}
+			last = i;
+		}
+	}
+
+	if ((first >= 0) != is_changed || r->is_changed != is_changed) {
+		fprintf(stderr, "%s : changed %d, result %d, reference %d\n", name, (int) is_changed, (int) r->is_changed, first >= 0);
+		return 1;
+	}
+
+	if (is_changed && ((r->first_slot != first) || (r->last_slot != last))) {
+		fprintf(stderr, "%s : range %u .. %u, reference %d .. %d\n", name, (unsigned) r->first_slot, (unsigned) r->last_slot, first, last);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int verify(const unsigned offset) {
+	uint8_t *out = &store_out[0][offset];
+	uint8_t *out_slot = &store_out[1][offset];
+	uint8_t *a = &store_a[0][offset];
+	uint8_t *b = &store_b[offset];
+	uint8_t *before = &store_ref[offset];
+	int errors = 0;
+	unsigned l;
+
+	for (l = 0; l < VERIFY_LOOPS; l++) {
+		const uint16_t length = (uint16_t) ((unsigned) rand() % (SLOTS + 1));
+		struct _lightset_merge_result r = { false, 0, 0 };
+
+		fill_random(b, length);
+		rand() & 1 ? fill_similar(a, b, length) : fill_random(a, length);
+		rand() & 1 ? fill_similar(out, a, length) : fill_random(out, length);
+		memcpy(out_slot, out, length);
+		memcpy(before, out, length);
+
+		switch (l % 3) {
+		case 0: {
+			const bool is_changed = lightset_merge_htp(out, a, b, length, &r);
+			if ((slot_htp(out_slot, a, b, length) != is_changed) || (memcmp(out, out_slot, length) != 0)) {
+				fprintf(stderr, "lightset_merge_htp : differs, offset %u, length %u\n", offset, (unsigned) length);
+				errors++;
+			}
+			errors += check_range("lightset_merge_htp", before, out, length, is_changed, &r);
+			}
+			break;
+		case 1: {
+			const bool is_changed = lightset_merge_copy(out, a, length, &r);
+			if ((slot_copy(out_slot, a, length) != is_changed) || (memcmp(out, out_slot, length) != 0)) {
+				fprintf(stderr, "lightset_merge_copy : differs, offset %u, length %u\n", offset, (unsigned) length);
+				errors++;
+			}
+			errors += check_range("lightset_merge_copy", before, out, length, is_changed, &r);
+			}
+			break;
+		default: {
+			const bool is_changed = lightset_merge_compare(a, out, length, &r);
+			if (slot_compare(a, out, length) != is_changed) {
+				fprintf(stderr, "lightset_merge_compare : differs, offset %u, length %u\n", offset, (unsigned) length);
+				errors++;
+			}
+			errors += check_range("lightset_merge_compare", a, out, length, is_changed, &r);
+			}
+			break;
+		}
+
+		if (errors != 0) {
+			break;
+		}
+	}
+
+	return errors;
+}
+
+/*
+ * Timing
+ */
+
+static double ns_since(const struct timespec *start) {
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (double) (end.tv_sec - start->tv_sec) * 1e9 + (double) (end.tv_nsec - start->tv_nsec);
+}
+
+#define TIME(ns, loops, statement)					\
+	do {											\
+		struct timespec start;						\
+		uint32_t l;									\
+		clock_gettime(CLOCK_MONOTONIC, &start);		\
+		for (l = 0; l < (loops); l++) {				\
+			statement;								\
+		}											\
+		ns = ns_since(&start) / (double) (loops);	\
+	} while (0)
+
+static void report(const char *name, const unsigned offset, const bool is_changed, const double ns_slot, const double ns_merge) {
+	printf("%-8s %-9s %-9s %10.1f %10.1f %8.2fx\n", name, offset == 0 ? "aligned" : "offset 18", is_changed ? "changed" : "unchanged", ns_slot, ns_merge, ns_slot / ns_merge);
+}
+
+/**
+ * When changed, a[] takes turns between two frames which differ in every 16th slot, so each call has changes.
+ */
+static void run(const unsigned offset, const bool is_changed, const uint32_t loops) {
+	uint8_t *out = &store_out[0][offset];
+	const uint8_t *a[2] = { &store_a[0][offset], &store_a[1][offset] };
+	const uint8_t *b = &store_b[offset];
+	const unsigned alternate = is_changed ? 1 : 0;
+	double ns_slot, ns_merge;
+	unsigned i;
+
+	fill_random(store_a[0], sizeof store_a[0]);
+	memcpy(store_a[1], store_a[0], sizeof store_a[1]);
+
+	for (i = 0; i < SLOTS; i += 16) {
+		store_a[1][offset + i] = store_a[0][offset + i] ^ 0x80;
+	}
+
+	memset(store_b, 0, sizeof store_b);	// The HTP result is a[]
+	memcpy(out, a[0], SLOTS);
+
+	TIME(ns_slot, loops, sink += slot_htp(out, a[l & alternate], b, SLOTS));
+	memcpy(out, a[0], SLOTS);
+	TIME(ns_merge, loops, sink += lightset_merge_htp(out, a[l & alternate], b, SLOTS, 0));
+	report("htp", offset, is_changed, ns_slot, ns_merge);
+
+	memcpy(out, a[0], SLOTS);
+	TIME(ns_slot, loops, sink += slot_copy(out, a[l & alternate], SLOTS));
+	memcpy(out, a[0], SLOTS);
+	TIME(ns_merge, loops, sink += lightset_merge_copy(out, a[l & alternate], SLOTS, 0));
+	report("copy", offset, is_changed, ns_slot, ns_merge);
+
+	memcpy(out, a[0], SLOTS);
+	TIME(ns_slot, loops, sink += slot_compare(a[l & alternate], out, SLOTS));
+	TIME(ns_merge, loops, sink += lightset_merge_compare(a[l & alternate], out, SLOTS, 0));
+	report("compare", offset, is_changed, ns_slot, ns_merge);
+}
+
+int main(int argc, char **argv) {
+	const unsigned offsets[2] = { 0, OFFSET_ARTDMX };
+	uint32_t loops = 100000;
+	unsigned i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "l:")) != -1) {
+		switch (opt) {
+		case 'l':
+			loops = (uint32_t) strtoul(optarg, NULL, 0);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-l loops]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (loops == 0) {
+		loops = 1;
+	}
+
+	srand(1);
+
+	for (i = 0; i < 2; i++) {
+		if (verify(offsets[i]) != 0) {
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("%d random merges checked for each alignment\n\n", VERIFY_LOOPS);
+	printf("%-8s %-9s %-9s %10s %10s %9s\n", "", "", "", "slot ns", "merge ns", "speedup");
+
+	for (i = 0; i < 2; i++) {
+		run(offsets[i], false, loops);
+		run(offsets[i], true, loops);
+	}
+
+	return EXIT_SUCCESS;
+}
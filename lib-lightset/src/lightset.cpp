@@ -29,3 +29,28 @@ LightSet::~LightSet (void)
 {
 
 }
+
+/**
+ * Default adapter for a LightSet which always handles the full universe.
+ *
+ * @param nPort
+ * @param pData
+ * @param nLength
+ * @param nOffset
+ * @param nCount
+ */
+void LightSet::SetDataRange(const uint8_t nPort, const uint8_t *pData, const uint16_t nLength, const uint16_t nOffset, const uint16_t nCount) {
+	SetData(nPort, pData, nLength);
+}
+
+/**
+ * Default, the ports are output by SetData.
+ */
+void LightSet::BeginUpdate(void) {
+}
+
+/**
+ * Default, the ports are output by SetData.
+ */
+void LightSet::EndUpdate(void) {
+}
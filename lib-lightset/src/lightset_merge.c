@@ -0,0 +1,275 @@
+/**
+ * @file lightset_merge.c
+ *
+ */
+/* Copyright (C) 2016 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lightset_merge.h"
+
+/**
+ * The DMX data is not always word aligned (ArtDmx Data is at offset 18),
+ * so let the compiler generate the loads and stores which are safe for any alignment.
+ */
+typedef uint32_t uint32_unaligned_t __attribute__((aligned(1)));
+
+/**
+ * Slot wise unsigned maximum of 4 slots packed in a word.
+ *
+ * ARMv6 and up : USUB8 sets the GE flag for each slot where a >= b, SEL then picks a or b.
+ * Others : SWAR, the borrow out of bit 7 of each slot of (a - b) is set when a < b.
+ */
+inline static uint32_t max_u8x4(const uint32_t a, const uint32_t b) {
+#if defined (__ARM_FEATURE_SIMD32)
+	uint32_t r;
+	__asm__ ("usub8 %0, %1, %2\n\tsel %0, %1, %2" : "=&r" (r) : "r" (a), "r" (b) : "cc");
+	return r;
+#else
+	const uint32_t d = ((a | 0x80808080) - (b & 0x7F7F7F7F)) ^ ((a ^ ~b) & 0x80808080);
+	const uint32_t borrow = ((~a & b) | (~(a ^ b) & d)) & 0x80808080;
+	const uint32_t mask = (borrow >> 7) * 0xFF;
+	return (a & ~mask) | (b & mask);
+#endif
+}
+
+/**
+ * The dirty range is kept in words while merging, and converted to slots once.
+ * Little endian : the lowest slot is in the least significant byte.
+ */
+inline static void mark_changed(struct _lightset_merge_result *result, const uint16_t slot, const uint32_t diff) {
+	const uint16_t first = slot + (uint16_t) (__builtin_ctz(diff) / 8);
+	const uint16_t last = slot + (uint16_t) (3 - (__builtin_clz(diff) / 8));
+
+	if (!result->is_changed) {
+		result->is_changed = true;
+		result->first_slot = first;
+	}
+
+	result->last_slot = last;
+}
+
+inline static void mark_changed_slot(struct _lightset_merge_result *result, const uint16_t slot) {
+	if (!result->is_changed) {
+		result->is_changed = true;
+		result->first_slot = slot;
+	}
+
+	result->last_slot = slot;
+}
+
+/**
+ * @ingroup lightset
+ *
+ * Add the slots first_slot .. first_slot + length - 1 to the changed range.
+ *
+ * @param result
+ * @param first_slot
+ * @param length Number of slots, nothing is added when 0
+ */
+void lightset_merge_mark(struct _lightset_merge_result *result, const uint16_t first_slot, const uint16_t length) {
+	const uint16_t last_slot = first_slot + length - 1;
+
+	if (length == 0) {
+		return;
+	}
+
+	if (!result->is_changed) {
+		result->is_changed = true;
+		result->first_slot = first_slot;
+		result->last_slot = last_slot;
+		return;
+	}
+
+	if (first_slot < result->first_slot) {
+		result->first_slot = first_slot;
+	}
+
+	if (last_slot > result->last_slot) {
+		result->last_slot = last_slot;
+	}
+}
+
+/**
+ * @ingroup lightset
+ *
+ * HTP merge of two sources : out[i] = max(a[i], b[i]).
+ *
+ * @param out The data sent, updated in place
+ * @param a Data from source A
+ * @param b Data from source B
+ * @param length Number of slots
+ * @param result Optional, the changed slots compared to the previous content of out are added
+ * @return true when out is changed
+ */
+bool lightset_merge_htp(uint8_t *out, const uint8_t *a, const uint8_t *b, const uint16_t length, struct _lightset_merge_result *result) {
+	struct _lightset_merge_result r = { false, 0, 0 };
+	uint32_unaligned_t *dst = (uint32_unaligned_t *) out;
+	const uint32_unaligned_t *src_a = (const uint32_unaligned_t *) a;
+	const uint32_unaligned_t *src_b = (const uint32_unaligned_t *) b;
+	const uint16_t words = length / 4;
+	uint16_t i;
+
+	for (i = 0; i < words; i++) {
+		const uint32_t merged = max_u8x4(src_a[i], src_b[i]);
+		const uint32_t diff = merged ^ dst[i];
+
+		if (diff != 0) {
+			dst[i] = merged;
+			mark_changed(&r, i * 4, diff);
+		}
+	}
+
+	for (i = words * 4; i < length; i++) {
+		const uint8_t merged = a[i] > b[i] ? a[i] : b[i];
+
+		if (merged != out[i]) {
+			out[i] = merged;
+			mark_changed_slot(&r, i);
+		}
+	}
+
+	if ((result != 0) && r.is_changed) {
+		lightset_merge_mark(result, r.first_slot, (r.last_slot - r.first_slot) + 1);
+	}
+
+	return r.is_changed;
+}
+
+/**
+ * @ingroup lightset
+ *
+ * Copy with change detection : out[i] = src[i].
+ *
+ * @param out The data sent, updated in place
+ * @param src
+ * @param length Number of slots
+ * @param result Optional, the changed slots compared to the previous content of out are added
+ * @return true when out is changed
+ */
+bool lightset_merge_copy(uint8_t *out, const uint8_t *src, const uint16_t length, struct _lightset_merge_result *result) {
+	struct _lightset_merge_result r = { false, 0, 0 };
+	uint32_unaligned_t *dst = (uint32_unaligned_t *) out;
+	const uint32_unaligned_t *s = (const uint32_unaligned_t *) src;
+	const uint16_t words = length / 4;
+	uint16_t i;
+
+	for (i = 0; i < words; i++) {
+		const uint32_t diff = s[i] ^ dst[i];
+
+		if (diff != 0) {
+			dst[i] = s[i];
+			mark_changed(&r, i * 4, diff);
+		}
+	}
+
+	for (i = words * 4; i < length; i++) {
+		if (src[i] != out[i]) {
+			out[i] = src[i];
+			mark_changed_slot(&r, i);
+		}
+	}
+
+	if ((result != 0) && r.is_changed) {
+		lightset_merge_mark(result, r.first_slot, (r.last_slot - r.first_slot) + 1);
+	}
+
+	return r.is_changed;
+}
+
+/**
+ * @ingroup lightset
+ *
+ * Change detection only, nothing is written.
+ *
+ * @param a
+ * @param b
+ * @param length Number of slots
+ * @param result Optional, the slots which differ are added
+ * @return true when a and b differ
+ */
+bool lightset_merge_compare(const uint8_t *a, const uint8_t *b, const uint16_t length, struct _lightset_merge_result *result) {
+	struct _lightset_merge_result r = { false, 0, 0 };
+	const uint32_unaligned_t *src_a = (const uint32_unaligned_t *) a;
+	const uint32_unaligned_t *src_b = (const uint32_unaligned_t *) b;
+	const uint16_t words = length / 4;
+	uint16_t i;
+
+	for (i = 0; i < words; i++) {
+		const uint32_t diff = src_a[i] ^ src_b[i];
+
+		if (diff != 0) {
+			mark_changed(&r, i * 4, diff);
+		}
+	}
+
+	for (i = words * 4; i < length; i++) {
+		if (a[i] != b[i]) {
+			mark_changed_slot(&r, i);
+		}
+	}
+
+	if ((result != 0) && r.is_changed) {
+		lightset_merge_mark(result, r.first_slot, (r.last_slot - r.first_slot) + 1);
+	}
+
+	return r.is_changed;
+}
+
+/**
+ * @ingroup lightset
+ *
+ * Per slot priority merge : for each slot the sources with the highest priority win, and these are HTP merged.
+ * A slot with priority 0 is not driven by the source. A slot which is not driven by any source is 0.
+ *
+ * This runs for every frame, so the compares are turned into masks and there are no branches in the slot loop.
+ *
+ * @param out The merged data
+ * @param data The data of the sources, at least length slots each
+ * @param priority The slot priorities of the sources, at least length slots each
+ * @param sources Number of sources
+ * @param length Number of slots
+ */
+void lightset_merge_priority(uint8_t *out, const uint8_t **data, const uint8_t **priority, const uint8_t sources, const uint16_t length) {
+	uint16_t i;
+	uint8_t j;
+
+	for (i = 0; i < length; i++) {
+		uint32_t level = 0;
+		uint32_t prio = 0;
+
+		for (j = 0; j < sources; j++) {
+			const uint32_t p = priority[j][i];
+			const uint32_t l = data[j][i];
+			const uint32_t is_higher = -(uint32_t) (p > prio);
+			const uint32_t is_equal = -(uint32_t) ((p == prio) & (p != 0));
+			const uint32_t is_brighter = -(uint32_t) (l > level);
+			const uint32_t take = is_higher | (is_equal & is_brighter);
+
+			level = (l & take) | (level & ~take);
+			prio = (p & is_higher) | (prio & ~is_higher);
+		}
+
+		out[i] = (uint8_t) level;
+	}
+}
@@ -40,6 +40,10 @@ public:
 	void Stop(void);
 
 	void SetData(const uint8_t, const uint8_t *, const uint16_t);
+	void SetDataRange(const uint8_t, const uint8_t *, const uint16_t, const uint16_t, const uint16_t);
+
+	void BeginUpdate(void);
+	void EndUpdate(void);
 
 	void SetLEDType(const _ws28xxx_type);
 	const _ws28xxx_type GetLEDType(void);
@@ -47,9 +51,14 @@ public:
 	void SetLEDCount(const uint16_t);
 	const uint16_t GetLEDCount(void);
 
+private:
+	void SetLEDs(const uint8_t, const uint8_t *, const uint16_t, const uint16_t, const uint16_t);
+
 private:
 	_ws28xxx_type		m_led_type;
 	uint16_t			m_led_count;
+	bool				m_bIsUpdating;			///< Between BeginUpdate and EndUpdate
+	bool				m_bIsUpdatePending;		///< The LEDs are changed while updating
 };
 
 #endif /* SPISEND_H_ */
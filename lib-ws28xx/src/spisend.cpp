@@ -35,7 +35,7 @@
 /**
  *
  */
-SPISend::SPISend(void) : m_led_type(WS2801), m_led_count(170) {
+SPISend::SPISend(void) : m_led_type(WS2801), m_led_count(170), m_bIsUpdating(false), m_bIsUpdatePending(false) {
 }
 
 /**
@@ -68,6 +68,33 @@ void SPISend::Stop(void)
  * @param length
  */
 void SPISend::SetData(const uint8_t nPortId, const uint8_t *data, const uint16_t length)
+{
+	SetLEDs(nPortId, data, length, 0, length);
+}
+
+/**
+ * Only the LEDs of the changed slots are encoded again.
+ *
+ * @param nPortId
+ * @param data
+ * @param length
+ * @param offset First changed slot
+ * @param count Number of changed slots
+ */
+void SPISend::SetDataRange(const uint8_t nPortId, const uint8_t *data, const uint16_t length, const uint16_t offset, const uint16_t count)
+{
+	SetLEDs(nPortId, data, length, offset, count);
+}
+
+/**
+ *
+ * @param nPortId
+ * @param data
+ * @param length
+ * @param offset
+ * @param count
+ */
+void SPISend::SetLEDs(const uint8_t nPortId, const uint8_t *data, const uint16_t length, const uint16_t offset, const uint16_t count)
 {
 	uint16_t i = 0;
 	uint16_t j = 0;
@@ -103,6 +130,16 @@ void SPISend::SetData(const uint8_t nPortId, const uint8_t *data, const uint16_t
 		break;
 	}
 
+	if (count == 0) {
+		endIndex = beginIndex;
+	} else {
+		const uint16_t firstLed = beginIndex + (offset / (uint16_t)3);
+		const uint16_t lastLed = beginIndex + ((offset + count - 1) / (uint16_t)3);
+
+		i = (offset / (uint16_t)3) * (uint16_t)3;
+		beginIndex = firstLed;
+		endIndex = MIN(endIndex, (uint16_t)(lastLed + 1));
+	}
 
 	//monitor_line(MONITOR_LINE_STATS, "%d-%x:%x:%x-%d|%s", nPortId, data[0], data[1], data[2], length, bUpdate == false ? "False" : "True");
 
@@ -111,7 +148,29 @@ void SPISend::SetData(const uint8_t nPortId, const uint8_t *data, const uint16_t
 		i = i + 3;
 	}
 
-	if (bUpdate) {
+	if (m_bIsUpdating) {
+		m_bIsUpdatePending = true;
+	} else if (bUpdate) {
+		ws28xx_update();
+	}
+}
+
+/**
+ * The universes of a synchronized update are all set before the LEDs are updated once,
+ * also when the universe with the last LED is not part of the update.
+ */
+void SPISend::BeginUpdate(void) {
+	m_bIsUpdating = true;
+}
+
+/**
+ *
+ */
+void SPISend::EndUpdate(void) {
+	m_bIsUpdating = false;
+
+	if (m_bIsUpdatePending) {
+		m_bIsUpdatePending = false;
 		ws28xx_update();
 	}
 }
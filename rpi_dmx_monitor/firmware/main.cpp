@@ -32,6 +32,7 @@
 #include "console.h"
 #include "led.h"
 #include "dmx.h"
+#include "dmx_timing.h"
 
 #include "software_version.h"
 
@@ -44,6 +45,21 @@ void __attribute__((interrupt("IRQ"))) c_irq_handler(void) {}
   #define UINT32_MAX  ((uint32_t)-1)
 #endif
 
+/**
+ * The bins in percent of all values, starting at column 16
+ */
+static void print_histogram(const int line, const struct _dmx_timing_histogram *histogram) {
+	console_set_cursor(16, line);
+
+	for (uint32_t i = 0; i < DMX_TIMING_HISTOGRAM_BINS; i++) {
+		if (histogram->count == 0) {
+			console_puts("  -");
+		} else {
+			printf("%3d", (int) (((uint64_t) histogram->bins[i] * 100) / histogram->count));
+		}
+	}
+}
+
 void notmain(void) {
 	uint32_t micros_previous = 0;
 
@@ -51,10 +67,6 @@ void notmain(void) {
 	uint32_t updates_per_seconde_max = (uint32_t)0;
 	uint32_t slots_in_packet_min = UINT32_MAX;
 	uint32_t slots_in_packet_max = (uint32_t)0;
-	uint32_t slot_to_slot_min = UINT32_MAX;
-	uint32_t slot_to_slot_max = (uint32_t)0;
-	uint32_t break_to_break_min = UINT32_MAX;
-	uint32_t break_to_break_max = (uint32_t)0;
 
 	hardware_init();
 
@@ -72,7 +84,11 @@ void notmain(void) {
 	console_puts("DMX updates/sec\n");
 	console_puts("Slots in packet\n");
 	console_puts("Slot to slot\n");
-	console_puts("Break to break");
+	console_puts("Break to break\n");
+	console_puts("BREAK + MAB\n");
+	console_puts("Slot to slot %\n");
+	console_puts("Refresh rate %\n");
+	console_puts("BREAK + MAB %");
 
 	hardware_watchdog_init();
 
@@ -106,23 +122,28 @@ void notmain(void) {
 				console_puts("---");
 				console_set_cursor(17, 25);
 				console_puts("-------");
+				console_set_cursor(20, 26);
+				console_puts("---");
 			} else {
+				const struct _dmx_timing *dmx_timing = dmx_timing_get();
+
 				updates_per_seconde_min = MIN(dmx_updates_per_seconde, updates_per_seconde_min);
 				updates_per_seconde_max = MAX(dmx_updates_per_seconde, updates_per_seconde_max);
 				slots_in_packet_min = MIN(dmx_statistics->statistics.slots_in_packet, slots_in_packet_min);
 				slots_in_packet_max = MAX(dmx_statistics->statistics.slots_in_packet, slots_in_packet_max);
-				slot_to_slot_min = MIN(dmx_statistics->statistics.slot_to_slot, slot_to_slot_min);
-				slot_to_slot_max = MAX(dmx_statistics->statistics.slot_to_slot, slot_to_slot_max);
-				break_to_break_min = MIN(dmx_statistics->statistics.break_to_break, break_to_break_min);
-				break_to_break_max = MAX(dmx_statistics->statistics.break_to_break, break_to_break_max);
 				console_set_cursor(20, 22);
 				printf("%3d     %3d / %d", (int)dmx_updates_per_seconde, (int)updates_per_seconde_min , (int)updates_per_seconde_max);
 				console_set_cursor(20, 23);
 				printf("%3d     %3d / %d", (int)dmx_statistics->statistics.slots_in_packet, (int)slots_in_packet_min, (int)slots_in_packet_max);
 				console_set_cursor(20, 24);
-				printf("%3d     %3d / %d", (int)dmx_statistics->statistics.slot_to_slot, (int)slot_to_slot_min, (int)slot_to_slot_max);
+				printf("%3d     %3d / %d / %d  ", (int)dmx_statistics->statistics.slot_to_slot, (int)dmx_timing->slot_to_slot.min, (int)dmx_timing_get_mean(&dmx_timing->slot_to_slot), (int)dmx_timing->slot_to_slot.max);
 				console_set_cursor(17, 25);
-				printf("%6d  %6d / %d", (int)dmx_statistics->statistics.break_to_break, (int)break_to_break_min, (int)break_to_break_max);
+				printf("%6d     %3d / %d / %d Hz  ", (int)dmx_statistics->statistics.break_to_break, (int)dmx_timing->refresh_rate.min, (int)dmx_timing_get_mean(&dmx_timing->refresh_rate), (int)dmx_timing->refresh_rate.max);
+				console_set_cursor(20, 26);
+				printf("%3d     %3d / %d / %d  ", (int)dmx_statistics->statistics.break_to_start_code, (int)dmx_timing->break_mab.min, (int)dmx_timing_get_mean(&dmx_timing->break_mab), (int)dmx_timing->break_mab.max);
+				print_histogram(27, &dmx_timing->slot_to_slot);
+				print_histogram(28, &dmx_timing->refresh_rate);
+				print_histogram(29, &dmx_timing->break_mab);
 			}
 
 			micros_previous = micros_now;
@@ -46,7 +46,8 @@ typedef enum {
 	SEND_RDM_DISCOVERY_REQUEST = 11,			///< Send RDM Discovery Request
 	RDM_TIMEOUT = 12,							///< https://github.com/OpenLightingProject/ola/blob/master/plugins/usbpro/EnttecUsbProWidget.cpp#L353
 	MANUFACTURER_LABEL = 77,					///< https://wiki.openlighting.org/index.php/USB_Protocol_Extensions
-	GET_WIDGET_NAME_LABEL = 78					///< https://wiki.openlighting.org/index.php/USB_Protocol_Extensions
+	GET_WIDGET_NAME_LABEL = 78,					///< https://wiki.openlighting.org/index.php/USB_Protocol_Extensions
+	GET_DMX_TIMING_LABEL = 100					///< DMX receive timing analyzer, BREAK + MAB, slot to slot and refresh rate histograms
 } _widget_codes;
 
 typedef enum {
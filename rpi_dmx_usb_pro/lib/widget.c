@@ -41,6 +41,7 @@
 #include "widget_monitor.h"
 
 #include "dmx.h"
+#include "dmx_timing.h"
 #include "rdm.h"
 #include "rdm_e120.h"
 #include "rdm_device_info.h"
@@ -404,12 +405,47 @@ void widget_received_dmx_change_of_state_packet(void) {
 		return;
 	}
 
-	if (dmx_is_data_changed()) {
-		monitor_line(MONITOR_LINE_INFO, "RECEIVED_DMX_COS_TYPE");
-		monitor_line(MONITOR_LINE_STATUS, NULL);
-		// TODO widget_received_dmx_change_of_state_packet
-		monitor_line(MONITOR_LINE_INFO, "Sent changed DMX data to HOST");
+	struct _dmx_data_changed dmx_data_changed;
+	const uint8_t *dmx_data = dmx_is_data_changed_slots(&dmx_data_changed);
+
+	if (dmx_data == NULL) {
+		return;
 	}
+
+	const struct _dmx_data *dmx_statistics = (struct _dmx_data *)dmx_data;
+	const uint16_t length = (uint16_t)(dmx_statistics->statistics.slots_in_packet + 1);
+	uint16_t start;
+
+	monitor_line(MONITOR_LINE_INFO, "RECEIVED_DMX_COS_TYPE");
+	monitor_line(MONITOR_LINE_STATUS, NULL);
+
+	// Each message : start changed byte number (slot / 8), changed bit array for 40 slots, the changed slots
+	for (start = dmx_data_changed.first_slot & (uint16_t) ~7; (start <= dmx_data_changed.last_slot) && (start < length); start += 40) {
+		uint8_t cos[1 + 5 + 40];
+		uint16_t cos_length = 1 + 5;
+		uint16_t i;
+
+		cos[0] = (uint8_t) (start / 8);
+
+		for (i = 0; i < 40; i++) {
+			const uint16_t slot = start + i;
+
+			if ((i % 8) == 0) {
+				cos[1 + (i / 8)] = 0;
+			}
+
+			if ((slot < length) && (dmx_data_changed.bitmap[slot / 32] & ((uint32_t) 1 << (slot % 32)))) {
+				cos[1 + (i / 8)] |= (uint8_t) (1 << (i % 8));
+				cos[cos_length++] = dmx_data[slot];
+			}
+		}
+
+		if (cos_length > 1 + 5) {
+			widget_usb_send_message(RECEIVED_DMX_COS_TYPE, cos, cos_length);
+		}
+	}
+
+	monitor_line(MONITOR_LINE_INFO, "Sent changed DMX data to HOST");
 }
 
 /**
@@ -539,6 +575,73 @@ static void widget_get_name_reply(void) {
 	widget_received_dmx_packet_start = hardware_micros();
 }
 
+/**
+ * @ingroup widget
+ *
+ * @param value Little endian
+ */
+static void widget_usb_send_uint32(const uint32_t value) {
+	usb_send_byte((uint8_t) (value & 0xFF));
+	usb_send_byte((uint8_t) ((value >> 8) & 0xFF));
+	usb_send_byte((uint8_t) ((value >> 16) & 0xFF));
+	usb_send_byte((uint8_t) (value >> 24));
+}
+
+/**
+ * @ingroup widget
+ *
+ * count, min, max, mean, bin_low, bin_width, bins
+ */
+static void widget_usb_send_histogram(const struct _dmx_timing_histogram *histogram) {
+	uint32_t i;
+
+	widget_usb_send_uint32(histogram->count);
+	widget_usb_send_uint32(histogram->min);
+	widget_usb_send_uint32(histogram->max);
+	widget_usb_send_uint32(dmx_timing_get_mean(histogram));
+	widget_usb_send_uint32(histogram->bin_low);
+	widget_usb_send_uint32(histogram->bin_width);
+
+	for (i = 0; i < DMX_TIMING_HISTOGRAM_BINS; i++) {
+		widget_usb_send_uint32(histogram->bins[i]);
+	}
+}
+
+/**
+ * @ingroup widget
+ *
+ * Get DMX Timing Reply (Label = 100 \ref GET_DMX_TIMING_LABEL)
+ *
+ * The reply holds the histograms BREAK + MAB (us), slot to slot (us) and refresh rate (Hz), in that order.
+ * Each histogram is count, min, max, mean, bin_low, bin_width and the \ref DMX_TIMING_HISTOGRAM_BINS bins,
+ * all uint32_t little endian. Bin 0 holds the values below bin_low, the last bin all values above the range.
+ *
+ * When the request has a data byte which is not 0, the analyzer is reset after the reply.
+ */
+static void widget_get_dmx_timing_reply(uint16_t data_length) {
+	const struct _dmx_timing *dmx_timing = dmx_timing_get();
+	const uint16_t length = 3 * (6 + DMX_TIMING_HISTOGRAM_BINS) * sizeof(uint32_t);
+
+	monitor_line(MONITOR_LINE_INFO, "GET_DMX_TIMING_LABEL");
+	monitor_line(MONITOR_LINE_STATUS, NULL);
+
+	dmx_set_port_direction(DMX_PORT_DIRECTION_INP, false);
+
+	widget_usb_send_header(GET_DMX_TIMING_LABEL, length);
+	widget_usb_send_histogram(&dmx_timing->break_mab);
+	widget_usb_send_histogram(&dmx_timing->slot_to_slot);
+	widget_usb_send_histogram(&dmx_timing->refresh_rate);
+	widget_usb_send_footer();
+
+	if ((data_length != 0) && (widget_data[0] != 0)) {
+		dmx_timing_reset();
+	}
+
+	dmx_set_port_direction(DMX_PORT_DIRECTION_INP, true);
+
+	widget_received_dmx_packet_start = hardware_micros();
+}
+
 /**
  * @ingroup widget
  *
@@ -582,6 +685,9 @@ void widget_receive_data_from_host(void) {
 			case MANUFACTURER_LABEL:
 				widget_get_manufacturer_reply();
 				break;
+			case GET_DMX_TIMING_LABEL:
+				widget_get_dmx_timing_reply(data_length);
+				break;
 			case OUTPUT_ONLY_SEND_DMX_PACKET_REQUEST:
 				widget_send_dmx_packet_request_output_only(data_length);
 				break;
@@ -35,19 +35,18 @@
 #include "widget_params.h"
 
 #include "dmx.h"
+#include "dmx_timing.h"
 #include "rdm.h"
 #include "rdm_e120.h"
 
 static uint32_t widget_received_dmx_packet_count_previous = 0;	///<
+static uint32_t send_frames_previous = 0;						///<
+static uint32_t send_micros_previous = 0;						///<
 
 static uint32_t updates_per_seconde_min = UINT32_MAX;
 static uint32_t updates_per_seconde_max = (uint32_t)0;
 static uint32_t slots_in_packet_min = UINT32_MAX;
 static uint32_t slots_in_packet_max = (uint32_t)0;
-static uint32_t slot_to_slot_min = UINT32_MAX;
-static uint32_t slot_to_slot_max = (uint32_t)0;
-static uint32_t break_to_break_min = UINT32_MAX;
-static uint32_t break_to_break_max = (uint32_t)0;
 
 /**
  * @ingroup monitor
@@ -113,7 +112,8 @@ static void monitor_sniffer(void) {
 
 	monitor_dmx_data(dmx_data, MONITOR_LINE_DMX_DATA);
 
-	monitor_line(MONITOR_LINE_PACKETS, "Packets : %ld, DMX %ld, RDM %ld\n\n", (long int) total_packets, (long int) total_statistics->dmx_packets, (long int) total_statistics->rdm_packets);
+	monitor_line(MONITOR_LINE_PACKETS, "Packets : %ld, DMX %ld, RDM %ld\n", (long int) total_packets, (long int) total_statistics->dmx_packets, (long int) total_statistics->rdm_packets);
+	printf("Dropped : %ld, overruns %ld, ring %ld/%d\n\n", (long int) total_statistics->dmx_packets_dropped, (long int) total_statistics->dmx_overruns, (long int) total_statistics->dmx_high_water, (int) dmx_get_receive_depth() - 1);
 
 	printf("Discovery          : %ld\n", rdm_statistics->discovery_packets);
 	printf("Discovery response : %ld\n", rdm_statistics->discovery_response_packets);
@@ -129,20 +129,20 @@ static void monitor_sniffer(void) {
 	}
 
 	if (dmx_updates_per_seconde != 0) {
+		const struct _dmx_timing *dmx_timing = dmx_timing_get();
+
 		slots_in_packet_min = MIN(dmx_statistics->statistics.slots_in_packet, slots_in_packet_min);
 		slots_in_packet_max = MAX(dmx_statistics->statistics.slots_in_packet, slots_in_packet_max);
-		slot_to_slot_min = MIN(dmx_statistics->statistics.slot_to_slot, slot_to_slot_min);
-		slot_to_slot_max = MAX(dmx_statistics->statistics.slot_to_slot, slot_to_slot_max);
-		break_to_break_min = MIN(dmx_statistics->statistics.break_to_break, break_to_break_min);
-		break_to_break_max = MAX(dmx_statistics->statistics.break_to_break, break_to_break_max);
 
 		printf("Slots in packet     %3d     %3d / %d\n", (int)dmx_statistics->statistics.slots_in_packet, (int)slots_in_packet_min, (int)slots_in_packet_max);
-		printf("Slot to slot        %3d     %3d / %d\n", (int)dmx_statistics->statistics.slot_to_slot, (int)slot_to_slot_min, (int)slot_to_slot_max);
-		printf("Break to break   %6d  %6d / %d\n", (int)dmx_statistics->statistics.break_to_break, (int)break_to_break_min, (int)break_to_break_max);
+		printf("Slot to slot        %3d     %3d / %d / %d\n", (int)dmx_statistics->statistics.slot_to_slot, (int)dmx_timing->slot_to_slot.min, (int)dmx_timing_get_mean(&dmx_timing->slot_to_slot), (int)dmx_timing->slot_to_slot.max);
+		printf("Break to break   %6d     %3d / %d / %d Hz\n", (int)dmx_statistics->statistics.break_to_break, (int)dmx_timing->refresh_rate.min, (int)dmx_timing_get_mean(&dmx_timing->refresh_rate), (int)dmx_timing->refresh_rate.max);
+		printf("BREAK + MAB         %3d     %3d / %d / %d\n", (int)dmx_statistics->statistics.break_to_start_code, (int)dmx_timing->break_mab.min, (int)dmx_timing_get_mean(&dmx_timing->break_mab), (int)dmx_timing->break_mab.max);
 	} else {
 		console_puts("Slots in packet --     \n");
 		console_puts("Slot to slot    --     \n");
 		console_puts("Break to break  --     \n");
+		console_puts("BREAK + MAB     --     \n");
 	}
 }
 
@@ -174,6 +174,7 @@ void monitor_update(void) {
 
 		if (DMX_PORT_DIRECTION_INP == dmx_get_port_direction()) {
 			const uint8_t receive_dmx_on_change = widget_get_receive_dmx_on_change();
+			const volatile struct _total_statistics *total_statistics = dmx_get_total_statistics();
 
 			if (receive_dmx_on_change == SEND_ALWAYS) {
 				const uint32_t throttle = widget_get_received_dmx_packet_period();
@@ -185,18 +186,25 @@ void monitor_update(void) {
 					printf(", Throttle %d", (int) (1E6 / throttle));
 				}
 
-				monitor_line(MONITOR_LINE_STATS, "DMX packets per second to host : %d", widget_received_dmx_packet_count - widget_received_dmx_packet_count_previous);
+				monitor_line(MONITOR_LINE_STATS, "DMX packets per second to host : %d, dropped %d [%d/%d]", widget_received_dmx_packet_count - widget_received_dmx_packet_count_previous,
+						(int) total_statistics->dmx_packets_dropped, (int) total_statistics->dmx_high_water, (int) dmx_get_receive_depth() - 1);
 				widget_received_dmx_packet_count_previous = widget_received_dmx_packet_count;
 			} else {
 				console_puts("Input [SEND_ON_DATA_CHANGE_ONLY]");
-				console_clear_line(MONITOR_LINE_STATS);
+				monitor_line(MONITOR_LINE_STATS, "DMX packets dropped %d [%d/%d]", (int) total_statistics->dmx_packets_dropped, (int) total_statistics->dmx_high_water, (int) dmx_get_receive_depth() - 1);
 			}
 		} else {
+			const volatile struct _dmx_send_statistics *send_statistics = dmx_get_send_statistics();
+			const uint32_t send_micros = send_statistics->irq_micros;
+
 			console_puts("Output");
-			console_clear_line(MONITOR_LINE_STATS);
+
+			monitor_line(MONITOR_LINE_STATS, "DMX frames per second : %d, sending %d us/s, superseded %d", (int) (send_statistics->frames - send_frames_previous), (int) (send_micros - send_micros_previous), (int) send_statistics->frames_superseded);
+			send_frames_previous = send_statistics->frames;
+			send_micros_previous = send_micros;
 		}
 
-		const uint8_t *dmx_data = dmx_get_current_data();
+		const uint8_t *dmx_data = (DMX_PORT_DIRECTION_OUTP == dmx_get_port_direction()) ? dmx_get_send_data() : dmx_get_current_data();
 		monitor_dmx_data(dmx_data, MONITOR_LINE_DMX_DATA);
 	}
 }
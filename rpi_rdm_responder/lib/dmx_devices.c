@@ -267,13 +267,22 @@ void dmx_devices_run() {
 			return;
 		}
 	} else {
-		const uint8_t *dmx_data = dmx_is_data_changed();
+		struct _dmx_data_changed dmx_data_changed;
+		const uint8_t *dmx_data = dmx_is_data_changed_slots(&dmx_data_changed);
 
 		if (dmx_data == NULL) {
 			return;
 		}
 
 		for (i = 0; i < devices_connected.elements_count; i++) {
+			const dmx_device_info_t *dmx_device_info = &(devices_connected.device_entry[i].dmx_device_info);
+			const uint16_t dmx_footprint = dmx_device_info->rdm_sub_devices_info.dmx_footprint;
+
+			// After dmx_devices_zero all devices are updated. A device without a footprint is always updated.
+			if (!is_devices_zero && (dmx_footprint != 0) && !dmx_is_slots_changed(&dmx_data_changed, dmx_device_info->dmx_start_address, dmx_footprint)) {
+				continue;
+			}
+
 			devices_table[devices_connected.device_entry[i].devices_table_index].f(&(devices_connected.device_entry[i].dmx_device_info), dmx_data);
 		}
 
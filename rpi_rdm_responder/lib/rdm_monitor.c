@@ -104,7 +104,7 @@ void monitor_update(void) {
 
 		const volatile struct _total_statistics *total_statistics = dmx_get_total_statistics();
 
-		monitor_line(MONITOR_LINE_PACKETS, "Packets : DMX %ld, RDM %ld\n", total_statistics->dmx_packets, total_statistics->rdm_packets);
+		monitor_line(MONITOR_LINE_PACKETS, "Packets : DMX %ld, RDM %ld, dropped %ld [%ld/%d]\n", total_statistics->dmx_packets, total_statistics->rdm_packets, total_statistics->dmx_packets_dropped, total_statistics->dmx_high_water, (int) dmx_get_receive_depth() - 1);
 
 		if (rdm_is_muted()) {
 			console_puts("[Muted]");
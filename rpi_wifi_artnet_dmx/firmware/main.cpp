@@ -37,6 +37,7 @@
 #include "artnetparams.h"
 
 #include "dmxsend.h"
+#include "dmxreceive.h"
 #include "dmxparams.h"
 
 #include "dmxmonitor.h"
@@ -84,7 +85,7 @@ void notmain(void) {
 	}
 
 	printf("[V%s] %s Compiled on %s at %s\n", SOFTWARE_VERSION, hardware_board_get_model(), __DATE__, __TIME__);
-	printf("WiFi ArtNet 3 Node DMX Output / Pixel controller {4 DMX Universes}");
+	printf("WiFi ArtNet 3 Node DMX Output / Pixel controller {4 DMX Universes} / DMX Input");
 
 	console_set_top_row(3);
 
@@ -156,6 +157,42 @@ void notmain(void) {
 	console_status(CONSOLE_YELLOW, "Starting UDP ...");
 	udp_begin(6454);
 
+	if (artnetparams.IsInput()) {
+		ArtNetNode node;
+		DMXReceive dmxin;
+
+		console_status(CONSOLE_YELLOW, "Setting Node parameters ...");
+
+		node.SetInput(&dmxin);
+		node.SetUniverseSwitch(0, ARTNET_INPUT_PORT, artnetparams.GetUniverse());
+		node.SetSubnetSwitch(artnetparams.GetSubnet());
+		node.SetNetSwitch(artnetparams.GetNet());
+
+		printf("\nNode configuration\n");
+		const uint8_t *firmware_version = node.GetSoftwareVersion();
+		printf(" Firmware     : %d.%d\n", firmware_version[0], firmware_version[1]);
+		printf(" Short name   : %s\n", node.GetShortName());
+		printf(" Long name    : %s\n", node.GetLongName());
+		printf(" Net          : %d\n", node.GetNetSwitch());
+		printf(" Sub-Net      : %d\n", node.GetSubnetSwitch());
+		printf(" Universe     : %d\n", artnetparams.GetUniverse());
+		printf(" Input ports  : %d\n\n", node.GetActiveInputPorts());
+
+		hardware_watchdog_init();
+
+		console_status(CONSOLE_YELLOW, "Starting the Node ...");
+
+		node.Start();
+
+		console_status(CONSOLE_GREEN, "Node started, DMX input");
+
+		for (;;) {
+			hardware_watchdog_feed();
+			(void) node.HandlePacket();
+			led_blink();
+		}
+	}
+
 	ArtNetNode node;
 	DMXSend dmx;
 	SPISend spi;
@@ -170,6 +207,7 @@ void notmain(void) {
 	}
 
 	node.SetUniverseSwitch(0, ARTNET_OUTPUT_PORT, artnetparams.GetUniverse());
+	node.SetSyncDeadline(artnetparams.GetSyncDeadline());
 
 	if (output_type == OUTPUT_TYPE_DMX) {
 		node.SetOutput(&dmx);
@@ -251,10 +289,33 @@ void notmain(void) {
 
 	console_status(CONSOLE_GREEN, "Node started");
 
+	uint32_t micros_previous = hardware_micros();
+	uint32_t send_micros_previous = (uint32_t) 0;
+	uint32_t frames_previous = (uint32_t) 0;
+
 	for (;;) {
 		hardware_watchdog_feed();
 		(void)node.HandlePacket();
 		led_blink();
+
+		if (output_type == OUTPUT_TYPE_DMX) {
+			const uint32_t micros = hardware_micros();
+
+			// The CPU headroom is the time not spent in the DMX transmit interrupts
+			if (micros - micros_previous >= (uint32_t) 1000000) {
+				const volatile struct _dmx_send_statistics *send_statistics = dmx.GetSendStatistics();
+				const uint32_t send_micros = send_statistics->irq_micros;
+				const uint32_t busy = (send_micros - send_micros_previous) / ((micros - micros_previous) / 100);
+
+				console_save_cursor();
+				monitor_line(MONITOR_LINE_STATS, "Node started, DMX %d fps, CPU headroom %d%%", (int) (send_statistics->frames - frames_previous), (int) (100 - MIN(busy, (uint32_t) 100)));
+				console_restore_cursor();
+
+				micros_previous = micros;
+				send_micros_previous = send_micros;
+				frames_previous = send_statistics->frames;
+			}
+		}
 	}
 }
 
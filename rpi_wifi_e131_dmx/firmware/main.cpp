@@ -44,8 +44,10 @@
 
 #include "e131.h"
 #include "e131bridge.h"
+#include "e131controller.h"
 #include "e131params.h"
 #include "dmxsend.h"
+#include "dmxreceive.h"
 #include "dmxparams.h"
 #include "dmxmonitor.h"
 
@@ -157,20 +159,50 @@ void notmain(void) {
 	console_status(CONSOLE_YELLOW, "Starting UDP ...");
 	udp_begin(E131_DEFAULT_PORT);
 
-	console_status(CONSOLE_YELLOW, "Join group ...");
-
 	uint32_t group_ip;
 	(void)inet_aton("239.255.0.0", &group_ip);
 	const uint16_t universe = e131params.GetUniverse();
 	group_ip = group_ip | ((uint32_t)(((uint32_t)universe & (uint32_t)0xFF) << 24)) | ((uint32_t)(((uint32_t)universe & (uint32_t)0xFF00) << 8));
-	udp_joingroup(group_ip);
+
+	if (e131params.isInput()) {
+		E131Controller controller;
+		DMXReceive dmxin;
+
+		controller.setCid(uuid);
+		controller.SetInput(&dmxin);
+		controller.setUniverse(0, universe);
+		controller.setPriority(e131params.GetPriority());
+		controller.setSynchronizationAddress(e131params.GetSynchronizationAddress());
+
+		printf("\nController configuration\n");
+		printf(" CID          : %s\n", uuid_str);
+		printf(" Universe     : %d\n", controller.getUniverse(0));
+		printf(" Priority     : %d\n", controller.getPriority());
+		printf(" Sync address : %d\n", controller.getSynchronizationAddress());
+		printf(" Multicast ip : " IPSTR "\n", IP2STR(group_ip));
+		printf(" Unicast ip   : " IPSTR "\n\n", IP2STR(ip_config.ip.addr));
+
+		controller.Start();
+
+		hardware_watchdog_init();
+
+		console_status(CONSOLE_GREEN, "Controller is running");
+
+		for (;;) {
+			hardware_watchdog_feed();
+			(void) controller.Run();
+			led_blink();
+		}
+	}
 
 	E131Bridge bridge;
 	DMXSend dmx;
 	DMXMonitor monitor;
 
+	console_status(CONSOLE_YELLOW, "Join group ...");
+
 	bridge.setCid(uuid);
-	bridge.setUniverse(universe);
+	bridge.setUniverse(0, universe);
 	bridge.setMergeMode(e131params.GetMergeMode());
 
 	if (output_type == OUTPUT_TYPE_MONITOR) {
@@ -195,7 +227,7 @@ void notmain(void) {
 	const uint8_t *firmware_version = bridge.GetSoftwareVersion();
 	printf(" Firmware     : %d.%d\n", firmware_version[0], firmware_version[1]);
 	printf(" CID          : %s\n", uuid_str);
-	printf(" Universe     : %d\n", bridge.getUniverse());
+	printf(" Universe     : %d\n", bridge.getUniverse(0));
 	printf(" Merge mode   : %s\n", bridge.getMergeMode() == E131_MERGE_HTP ? "HTP" : "LTP");
 	printf(" Multicast ip : " IPSTR "\n", IP2STR(group_ip));
 	printf(" Unicast ip   : " IPSTR "\n\n", IP2STR(ip_config.ip.addr));